@@ -0,0 +1,64 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Arena.h"
+#include <stdlib.h>
+#include <new>
+
+using namespace std;
+
+Arena::Arena(size_t blockSize) : current(0), offset(0), blockSize(blockSize ? blockSize : 4096), nHeapAllocs(0){
+}
+
+Arena::~Arena(){
+	for (size_t i = 0; i < blocks.size(); i++)
+		free(blocks[i].data);
+}
+
+void* Arena::alloc(size_t bytes, size_t align){
+	if (align == 0)
+		align = 1;
+	while (current < blocks.size()){
+		Block& b = blocks[current];
+		size_t start = (offset + align - 1) / align * align;
+		if (start + bytes <= b.size){
+			offset = start + bytes;
+			return b.data + start;
+		}
+		// does not fit: move on to the next kept block
+		current++;
+		offset = 0;
+	}
+
+	// malloc alignment covers every type we store
+	Block b;
+	b.size = bytes > blockSize ? bytes : blockSize;
+	b.data = (char*)malloc(b.size);
+	if (b.data == NULL)
+		throw bad_alloc();
+	nHeapAllocs++;
+	blocks.push_back(b);
+	current = blocks.size() - 1;
+	offset = bytes;
+	return b.data;
+}
+
+void Arena::reset(){
+	current = 0;
+	offset = 0;
+}
+
+size_t Arena::bytesUsed() const{
+	size_t used = 0;
+	for (size_t i = 0; i < current && i < blocks.size(); i++)
+		used += blocks[i].size;
+	return used + offset;
+}
@@ -0,0 +1,55 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef ARENA_H_DEF
+#define ARENA_H_DEF
+
+#include <stddef.h>
+#include <vector>
+
+using namespace std;
+
+/*
+	Bump allocator. Memory is handed out from large blocks and only given back
+	all at once with reset(), which keeps the blocks for the next round, so a
+	decode loop that resets per batch stops touching the heap after warm-up.
+*/
+class Arena {
+public:
+	Arena(size_t blockSize = 1 << 20);
+	~Arena();
+
+	void* alloc(size_t bytes, size_t align = 8);
+	template <class T> T* allocArray(size_t n) { return (T*)alloc(n * sizeof(T), sizeof(T) < 8 ? sizeof(T) : 8); }
+
+	void reset();
+
+	size_t bytesUsed() const;
+	size_t blockCount() const { return blocks.size(); }
+	// number of blocks ever requested from the heap
+	size_t heapAllocations() const { return nHeapAllocs; }
+
+private:
+	struct Block {
+		char* data;
+		size_t size;
+	};
+	vector<Block> blocks;
+	size_t current;   // block being filled
+	size_t offset;    // first free byte in it
+	size_t blockSize;
+	size_t nHeapAllocs;
+
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
+
+#endif
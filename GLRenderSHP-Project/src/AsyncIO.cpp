@@ -0,0 +1,379 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "AsyncIO.h"
+#include "Metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+// io_uring needs only the kernel header; define ASYNCIO_NO_URING to leave it out.
+#if defined(__linux__) && !defined(ASYNCIO_NO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ASYNCIO_URING
+#endif
+#endif
+#endif
+
+using namespace std;
+
+#ifdef ASYNCIO_URING
+struct AsyncReader::Ring {
+	int fd;
+	unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+	unsigned *cqHead, *cqTail, *cqMask;
+	io_uring_sqe* sqes;
+	io_uring_cqe* cqes;
+	void* sqMap;
+	void* cqMap;
+	size_t sqMapLen, cqMapLen, sqesLen;
+
+	// one slot per read in flight; user_data is the slot index
+	vector<IORequest> slots;
+	vector<iovec> iov;
+	vector<int> freeSlots;
+
+	Ring() : fd(-1), sqes(NULL), cqes(NULL), sqMap(NULL), cqMap(NULL) {}
+	~Ring(){
+		if (sqes)
+			munmap(sqes, sqesLen);
+		if (cqMap && cqMap != sqMap)
+			munmap(cqMap, cqMapLen);
+		if (sqMap)
+			munmap(sqMap, sqMapLen);
+		if (fd >= 0)
+			close(fd);
+	}
+
+	bool setup(unsigned entries){
+		io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+		if (fd < 0)
+			return false;
+		sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+		bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single)
+			sqMapLen = cqMapLen = (sqMapLen > cqMapLen ? sqMapLen : cqMapLen);
+		sqMap = mmap(NULL, sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sqMap == MAP_FAILED){
+			sqMap = NULL;
+			return false;
+		}
+		cqMap = single ? sqMap : mmap(NULL, cqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cqMap == MAP_FAILED){
+			cqMap = NULL;
+			return false;
+		}
+		sqesLen = p.sq_entries * sizeof(io_uring_sqe);
+		void* s = mmap(NULL, sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (s == MAP_FAILED)
+			return false;
+		sqes = (io_uring_sqe*)s;
+
+		char* sq = (char*)sqMap;
+		char* cq = (char*)cqMap;
+		sqHead = (unsigned*)(sq + p.sq_off.head);
+		sqTail = (unsigned*)(sq + p.sq_off.tail);
+		sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+		sqArray = (unsigned*)(sq + p.sq_off.array);
+		cqHead = (unsigned*)(cq + p.cq_off.head);
+		cqTail = (unsigned*)(cq + p.cq_off.tail);
+		cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+		cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+
+		slots.resize(entries);
+		iov.resize(entries);
+		for (int i = (int)entries - 1; i >= 0; i--)
+			freeSlots.push_back(i);
+		return true;
+	}
+
+	// Queue the unread rest of a slot. It reaches the kernel with the next
+	// enter(). READV rather than READ so kernels from 5.1 on work.
+	void queue(int slot){
+		IORequest& r = slots[slot];
+		iov[slot].iov_base = (char*)r.dst + r.result;
+		iov[slot].iov_len = r.len - r.result;
+		unsigned tail = *sqTail;
+		unsigned idx = tail & *sqMask;
+		io_uring_sqe* e = &sqes[idx];
+		memset(e, 0, sizeof(*e));
+		e->opcode = IORING_OP_READV;
+		e->fd = r.file->getFD();
+		e->addr = (unsigned long long)(size_t)&iov[slot];
+		e->len = 1;
+		e->off = r.offset + r.result;
+		e->user_data = (unsigned long long)slot;
+		sqArray[idx] = idx;
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	// SQEs published but not yet consumed by the kernel
+	unsigned unsubmitted() const {
+		return *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+	}
+
+	// Submit everything queued in one call, optionally waiting for a completion.
+	int enter(unsigned minComplete){
+		Metrics::add(COUNTER_SYSCALLS);
+		return (int)syscall(__NR_io_uring_enter, fd, unsubmitted(), minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	}
+};
+#else
+struct AsyncReader::Ring {};
+#endif
+
+const char* AsyncReader::backendName(AsyncBackend b){
+	return b == ASYNC_IO_URING ? "io_uring" : "thread pool";
+}
+
+AsyncReader::AsyncReader(int queueDepth, int nThreads)
+	: backend(ASYNC_THREAD_POOL), queueDepth(queueDepth < 1 ? 1 : queueDepth), inFlight(0), quit(false), ring(NULL){
+	const char* force = getenv("GLRENDERSHP_IO");
+	bool poolOnly = force != NULL && strcmp(force, "threads") == 0;
+#ifdef ASYNCIO_URING
+	if (!poolOnly){
+		ring = new Ring();
+		if (ring->setup((unsigned)this->queueDepth))
+			backend = ASYNC_IO_URING;
+		else{
+			delete ring; // no kernel support, or blocked by seccomp/sysctl
+			ring = NULL;
+		}
+	}
+#endif
+	(void)poolOnly;
+	poolThreads = nThreads < 1 ? 1 : nThreads;
+	if (backend == ASYNC_THREAD_POOL)
+		startPool();
+}
+
+void AsyncReader::startPool(){
+	for (int i = 0; i < poolThreads; i++)
+		workers.push_back(thread(&AsyncReader::workerLoop, this));
+}
+
+/*
+	Outstanding reads write into caller buffers, so they are drained first.
+*/
+AsyncReader::~AsyncReader(){
+	while (inFlight - (int)ready.size() > 0 && reap(true))
+		;
+	if (!workers.empty()){
+		{
+			lock_guard<mutex> guard(lock);
+			quit = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+	delete ring;
+}
+
+void AsyncReader::submit(const IORequest& req){
+	while (inFlight - (int)ready.size() >= queueDepth)
+		reap(true);
+	IORequest r = req;
+	r.result = 0;
+	inFlight++;
+	if (backend == ASYNC_IO_URING){
+		ringSubmit(r); // a read the kernel refuses completes as failed in wait()
+		return;
+	}
+	{
+		lock_guard<mutex> guard(lock);
+		pending.push_back(r);
+	}
+	wake.notify_one();
+}
+
+bool AsyncReader::wait(IORequest& done){
+	while (ready.empty()){
+		if (inFlight == 0)
+			return false;
+		reap(true);
+	}
+	done = ready.front();
+	ready.pop_front();
+	inFlight--;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Thread pool
+////////////////////////////////////////////////////////////////////////////////
+
+void AsyncReader::workerLoop(){
+	unique_lock<mutex> guard(lock);
+	for (;;){
+		wake.wait(guard, [this]{ return quit || !pending.empty(); });
+		if (quit)
+			return;
+		IORequest r = pending.front();
+		pending.pop_front();
+		guard.unlock();
+		r.result = r.file->readAt(r.offset, r.dst, r.len);
+		guard.lock();
+		completed.push_back(r);
+		doneCV.notify_one();
+	}
+}
+
+bool AsyncReader::poolReap(bool block){
+	unique_lock<mutex> guard(lock);
+	if (block)
+		doneCV.wait(guard, [this]{ return !completed.empty(); });
+	if (completed.empty())
+		return false;
+	while (!completed.empty()){
+		ready.push_back(completed.front());
+		completed.pop_front();
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// io_uring
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef ASYNCIO_URING
+/*
+	Reads are queued on the ring and go to the kernel in batches: when a
+	quarter of the queue depth is waiting, or when the consumer has to block
+	for a completion.
+*/
+void AsyncReader::ringSubmit(const IORequest& req){
+	int slot = ring->freeSlots.back();
+	ring->freeSlots.pop_back();
+	ring->slots[slot] = req;
+	ring->queue(slot);
+	unsigned batch = queueDepth / 4 > 1 ? (unsigned)(queueDepth / 4) : 1;
+	if (ring->unsubmitted() >= batch)
+		ringFlush(); // may switch to the pool
+}
+
+// io_uring_enter errors worth another try; anything else means the ring is unusable
+static bool transientEnterError(int err){
+	return err == EINTR || err == EAGAIN || err == EBUSY;
+}
+
+void AsyncReader::ringFlush(){
+	if (ring->unsubmitted() == 0)
+		return;
+	if (ring->enter(0) < 0 && !transientEnterError(errno))
+		ringAbandon();
+}
+
+/*
+	io_uring_enter fails for good: later reads go to the thread pool, so
+	wait() and submit() keep making progress. Reads still queued on the ring
+	never reached the kernel and complete as failed (result short of len).
+	The ones the kernel took still complete on their own and post to the
+	completion ring, which needs no system call to read; they are waited
+	for there, so no read lands in a buffer the caller got back.
+*/
+void AsyncReader::ringAbandon(){
+	vector<char> held(ring->slots.size(), 1);
+	for (size_t i = 0; i < ring->freeSlots.size(); i++)
+		held[ring->freeSlots[i]] = 0;
+	unsigned head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+	for (unsigned t = head; t != *ring->sqTail; t++){
+		int slot = (int)ring->sqes[ring->sqArray[t & *ring->sqMask]].user_data;
+		held[slot] = 0;
+		ready.push_back(ring->slots[slot]);
+	}
+	__atomic_store_n(ring->sqTail, head, __ATOMIC_RELEASE);
+
+	int nHeld = 0;
+	for (size_t s = 0; s < held.size(); s++)
+		nHeld += held[s];
+	while (nHeld > 0){
+		unsigned cq = *ring->cqHead;
+		if (cq == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)){
+			this_thread::sleep_for(chrono::microseconds(100));
+			continue;
+		}
+		io_uring_cqe* c = &ring->cqes[cq & *ring->cqMask];
+		IORequest r = ring->slots[(int)c->user_data];
+		if (c->res > 0)
+			r.result += (size_t)c->res;
+		__atomic_store_n(ring->cqHead, cq + 1, __ATOMIC_RELEASE);
+		ready.push_back(r);
+		nHeld--;
+	}
+	delete ring;
+	ring = NULL;
+	backend = ASYNC_THREAD_POOL;
+	startPool();
+}
+
+/*
+	Takes one completion off the ring, submitting queued reads on the way.
+	Short reads are queued again for the rest, so a request only completes
+	when it is whole, at EOF, or failed.
+*/
+bool AsyncReader::ringReap(bool block){
+	const int maxRetries = 64; // EAGAIN/EBUSY in a row before giving up on the ring
+	unsigned head = *ring->cqHead;
+	for (int retries = 0; head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);){
+		if (!block){
+			ringFlush();
+			return false;
+		}
+		if (ring->enter(1) >= 0 || errno == EINTR)
+			continue;
+		if (!transientEnterError(errno) || ++retries >= maxRetries){
+			ringAbandon();
+			return !ready.empty();
+		}
+	}
+	io_uring_cqe* c = &ring->cqes[head & *ring->cqMask];
+	int slot = (int)c->user_data;
+	int res = c->res;
+	__atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+
+	IORequest& r = ring->slots[slot];
+	if (res > 0)
+		r.result += (size_t)res;
+	bool retry = (res == -EINTR || res == -EAGAIN) || (res > 0 && r.result < r.len);
+	if (retry){
+		ring->queue(slot);
+		return true;
+	}
+	Metrics::add(COUNTER_BYTES_READ, (long long)r.result);
+	ready.push_back(r);
+	ring->freeSlots.push_back(slot);
+	return true;
+}
+#else
+void AsyncReader::ringSubmit(const IORequest&){
+}
+
+void AsyncReader::ringFlush(){
+}
+
+void AsyncReader::ringAbandon(){
+}
+
+bool AsyncReader::ringReap(bool){
+	return false;
+}
+#endif
@@ -0,0 +1,94 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef ASYNCIO_H_DEF
+#define ASYNCIO_H_DEF
+
+#include "FileIO.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+struct IORequest {
+	const PosFile* file;
+	FileOffset offset;
+	void* dst;
+	size_t len;
+	size_t result; // bytes read, set on completion
+	void* user;    // passed through untouched
+};
+
+enum AsyncBackend {
+	ASYNC_IO_URING,
+	ASYNC_THREAD_POOL
+};
+
+/*
+	Keeps up to queueDepth positional reads in flight and hands them back as
+	they complete, in any order. Uses io_uring on Linux when the kernel allows
+	it (raw syscalls, no liburing), otherwise a pool of threads doing pread.
+	GLRENDERSHP_IO=threads forces the pool. On io_uring, queued reads are
+	submitted in batches rather than one system call each.
+
+	submit() and wait() belong to one consumer thread; the reads themselves
+	run in parallel.
+*/
+class AsyncReader {
+public:
+	AsyncReader(int queueDepth = 64, int nThreads = 4);
+	~AsyncReader();
+
+	AsyncBackend getBackend() const { return backend; }
+	static const char* backendName(AsyncBackend b);
+
+	// Queues a read. When queueDepth reads are in flight, first waits for
+	// one to complete and keeps it for a later wait().
+	void submit(const IORequest& req);
+	// Next completed read. Returns false when nothing is in flight.
+	bool wait(IORequest& done);
+	int getInFlight() const { return inFlight; }
+
+private:
+	AsyncBackend backend;
+	int queueDepth;
+	int inFlight;            // submitted, not yet returned by wait()
+	deque<IORequest> ready;  // completed, not yet returned by wait()
+
+	// thread pool
+	vector<thread> workers;
+	mutex lock;
+	condition_variable wake, doneCV;
+	deque<IORequest> pending, completed;
+	bool quit;
+	int poolThreads;
+	void startPool();
+	void workerLoop();
+
+	// io_uring
+	struct Ring;
+	Ring* ring;
+	void ringSubmit(const IORequest& req);
+	void ringFlush();
+	void ringAbandon();
+	bool ringReap(bool block);
+
+	bool poolReap(bool block);
+	bool reap(bool block) { return backend == ASYNC_IO_URING ? ringReap(block) : poolReap(block); }
+
+	AsyncReader(const AsyncReader&);
+	AsyncReader& operator=(const AsyncReader&);
+};
+
+#endif
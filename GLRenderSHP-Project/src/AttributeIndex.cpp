@@ -0,0 +1,260 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "AttributeIndex.h"
+#include "LayerAttributes.h"
+#include "Metrics.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <string.h>
+
+using namespace std;
+
+static const char indexMagic[8] = { 'G', 'L', 'S', 'H', 'P', 'A', 'I', 'X' };
+static const unsigned int indexVersion = 1;
+static const unsigned int byteOrderMark = 0x01020304;
+
+static size_t hashNumber(double v){
+	if (v == 0.0)
+		v = 0.0; // -0 and 0 are equal keys
+	unsigned long long x;
+	memcpy(&x, &v, sizeof(x));
+	x ^= x >> 33; // murmur3 finalizer
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ull;
+	x ^= x >> 33;
+	return (size_t)x;
+}
+
+size_t AttributeIndex::hashRow(int row) const{
+	return numeric ? hashNumber(attrs->getNumber(column, row)) : StrViewHash()(attrs->getString(column, row));
+}
+
+bool AttributeIndex::lessRow(int a, int b) const{
+	if (numeric){
+		double va = attrs->getNumber(column, a), vb = attrs->getNumber(column, b);
+		return va < vb || (va == vb && a < b);
+	}
+	StrView sa = attrs->getString(column, a), sb = attrs->getString(column, b);
+	return sa < sb || (sa == sb && a < b);
+}
+
+shared_ptr<const AttributeIndex> AttributeIndex::build(const LayerAttributes& attrs, int column){
+	ScopedTimer timer(PHASE_INDEX_BUILD);
+	shared_ptr<AttributeIndex> idx(new AttributeIndex());
+	idx->attrs = &attrs;
+	idx->column = column;
+	idx->numeric = attrs.getColumn(column).isNumeric();
+	int n = attrs.getRowCount();
+	const AttributeIndex& self = *idx;
+
+	// hash: hashes in parallel, then chains linked backwards so every chain is ascending
+	size_t nBuckets = 16;
+	while (nBuckets < (size_t)n * 2)
+		nBuckets <<= 1;
+	vector<size_t> hashes(n);
+	parallelFor(n, 4096, [&](int begin, int end){
+		for (int i = begin; i < end; i++)
+			hashes[i] = self.hashRow(i);
+	});
+	idx->bucketHead.assign(nBuckets, -1);
+	idx->next.assign(n, -1);
+	for (int i = n - 1; i >= 0; i--){
+		size_t b = hashes[i] & (nBuckets - 1);
+		idx->next[i] = idx->bucketHead[b];
+		idx->bucketHead[b] = i;
+	}
+
+	// sorted permutation: sort ranges in parallel, then merge them pairwise
+	vector<int>& sorted = idx->sorted;
+	sorted.resize(n);
+	for (int i = 0; i < n; i++)
+		sorted[i] = i;
+	vector<pair<int, int> > runs;
+	mutex runsLock;
+	auto less = [&self](int a, int b){ return self.lessRow(a, b); };
+	parallelFor(n, 4096, [&](int begin, int end){
+		sort(sorted.begin() + begin, sorted.begin() + end, less);
+		lock_guard<mutex> guard(runsLock);
+		runs.push_back(make_pair(begin, end));
+	});
+	sort(runs.begin(), runs.end());
+	while (runs.size() > 1){
+		vector<pair<int, int> > merged;
+		for (size_t r = 0; r + 1 < runs.size(); r += 2){
+			inplace_merge(sorted.begin() + runs[r].first, sorted.begin() + runs[r].second,
+				sorted.begin() + runs[r + 1].second, less);
+			merged.push_back(make_pair(runs[r].first, runs[r + 1].second));
+		}
+		if (runs.size() % 2)
+			merged.push_back(runs.back());
+		runs.swap(merged);
+	}
+	return idx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lookups
+////////////////////////////////////////////////////////////////////////////////
+
+vector<int> AttributeIndex::find(double value) const{
+	vector<int> rows;
+	if (!numeric || bucketHead.empty())
+		return rows;
+	for (int r = bucketHead[hashNumber(value) & (bucketHead.size() - 1)]; r >= 0; r = next[r])
+		if (attrs->getNumber(column, r) == value)
+			rows.push_back(r);
+	return rows;
+}
+
+vector<int> AttributeIndex::find(const StrView& value) const{
+	vector<int> rows;
+	if (numeric || bucketHead.empty())
+		return rows;
+	for (int r = bucketHead[StrViewHash()(value) & (bucketHead.size() - 1)]; r >= 0; r = next[r])
+		if (attrs->getString(column, r) == value)
+			rows.push_back(r);
+	return rows;
+}
+
+vector<int> AttributeIndex::range(double lo, double hi) const{
+	vector<int> rows;
+	if (!numeric)
+		return rows;
+	const LayerAttributes& a = *attrs;
+	int c = column;
+	vector<int>::const_iterator first = lower_bound(sorted.begin(), sorted.end(), lo,
+		[&a, c](int row, double v){ return a.getNumber(c, row) < v; });
+	vector<int>::const_iterator last = upper_bound(first, sorted.end(), hi,
+		[&a, c](double v, int row){ return v < a.getNumber(c, row); });
+	rows.assign(first, last);
+	sort(rows.begin(), rows.end());
+	return rows;
+}
+
+vector<int> AttributeIndex::range(const StrView& lo, const StrView& hi) const{
+	vector<int> rows;
+	if (numeric)
+		return rows;
+	const LayerAttributes& a = *attrs;
+	int c = column;
+	vector<int>::const_iterator first = lower_bound(sorted.begin(), sorted.end(), lo,
+		[&a, c](int row, const StrView& v){ return a.getString(c, row) < v; });
+	vector<int>::const_iterator last = upper_bound(first, sorted.end(), hi,
+		[&a, c](const StrView& v, int row){ return v < a.getString(c, row); });
+	rows.assign(first, last);
+	sort(rows.begin(), rows.end());
+	return rows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Persistence
+////////////////////////////////////////////////////////////////////////////////
+
+static void writeInts(ofstream& out, const vector<int>& v){
+	if (!v.empty())
+		out.write((const char*)&v[0], v.size() * sizeof(int));
+}
+
+static bool readInts(ifstream& in, vector<int>& v, size_t n){
+	v.resize(n);
+	return n == 0 || in.read((char*)&v[0], n * sizeof(int)).good();
+}
+
+bool AttributeIndex::save(const string& path, unsigned long long sourceStamp) const{
+	ofstream out(path.c_str(), ios::binary);
+	if (!out)
+		return false;
+	const string& name = attrs->getColumn(column).name;
+	int header[4] = { (int)indexVersion, (int)byteOrderMark, attrs->getRowCount(), (int)bucketHead.size() };
+	unsigned int nameLen = (unsigned int)name.size();
+	out.write(indexMagic, 8);
+	out.write((const char*)header, sizeof(header));
+	out.write((const char*)&sourceStamp, sizeof(sourceStamp));
+	out.write((const char*)&nameLen, sizeof(nameLen));
+	out.write(name.data(), nameLen);
+	writeInts(out, bucketHead);
+	writeInts(out, next);
+	writeInts(out, sorted);
+	return out.good();
+}
+
+/*
+	Every link must point forward (chains are built ascending), so a damaged
+	file cannot make a lookup loop.
+*/
+shared_ptr<const AttributeIndex> AttributeIndex::load(const string& path, const LayerAttributes& attrs,
+	int column, unsigned long long sourceStamp){
+	ifstream in(path.c_str(), ios::binary);
+	if (!in)
+		return shared_ptr<const AttributeIndex>();
+	char magic[8];
+	int header[4];
+	unsigned long long stamp;
+	unsigned int nameLen;
+	if (!in.read(magic, 8) || memcmp(magic, indexMagic, 8) != 0
+		|| !in.read((char*)header, sizeof(header)) || !in.read((char*)&stamp, sizeof(stamp))
+		|| !in.read((char*)&nameLen, sizeof(nameLen)) || nameLen > 255)
+		return shared_ptr<const AttributeIndex>();
+	string name(nameLen, ' ');
+	if (nameLen > 0 && !in.read(&name[0], nameLen))
+		return shared_ptr<const AttributeIndex>();
+	int n = attrs.getRowCount();
+	int nBuckets = header[3];
+	if (header[0] != (int)indexVersion || header[1] != (int)byteOrderMark || header[2] != n
+		|| stamp != sourceStamp || name != attrs.getColumn(column).name
+		|| nBuckets < 1 || (nBuckets & (nBuckets - 1)) != 0)
+		return shared_ptr<const AttributeIndex>();
+
+	shared_ptr<AttributeIndex> idx(new AttributeIndex());
+	idx->attrs = &attrs;
+	idx->column = column;
+	idx->numeric = attrs.getColumn(column).isNumeric();
+	if (!readInts(in, idx->bucketHead, nBuckets) || !readInts(in, idx->next, n) || !readInts(in, idx->sorted, n))
+		return shared_ptr<const AttributeIndex>();
+	for (int b = 0; b < nBuckets; b++)
+		if (idx->bucketHead[b] < -1 || idx->bucketHead[b] >= n)
+			return shared_ptr<const AttributeIndex>();
+	for (int i = 0; i < n; i++)
+		if ((idx->next[i] != -1 && (idx->next[i] <= i || idx->next[i] >= n)) || idx->sorted[i] < 0 || idx->sorted[i] >= n)
+			return shared_ptr<const AttributeIndex>();
+	if (!idx->isConsistent())
+		return shared_ptr<const AttributeIndex>();
+	return idx;
+}
+
+/*
+	A file whose stamp matches can still be damaged. Every row must sit once
+	in the chain of its own bucket, and sorted must be strictly ascending by
+	lessRow, which with in-range entries makes it a permutation of the rows.
+*/
+bool AttributeIndex::isConsistent() const{
+	int n = attrs->getRowCount();
+	size_t mask = bucketHead.size() - 1;
+	vector<char> seen(n, 0);
+	int reached = 0;
+	for (size_t b = 0; b < bucketHead.size(); b++)
+		for (int r = bucketHead[b]; r >= 0; r = next[r]){
+			if (seen[r] || (hashRow(r) & mask) != b)
+				return false;
+			seen[r] = 1;
+			reached++;
+		}
+	if (reached != n)
+		return false;
+	for (int i = 1; i < n; i++)
+		if (!lessRow(sorted[i - 1], sorted[i]))
+			return false;
+	return true;
+}
@@ -0,0 +1,70 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef ATTRIBUTEINDEX_H_DEF
+#define ATTRIBUTEINDEX_H_DEF
+
+#include "StrView.h"
+#include <vector>
+#include <string>
+#include <memory>
+
+using namespace std;
+
+class LayerAttributes;
+
+/*
+	Secondary index over one column of a LayerAttributes:
+	- a chained hash table (bucket heads + next links over rows) for equality,
+	- the rows sorted by value (a permutation) for ranges.
+	Both are flat int arrays, so the index is saved and loaded as is.
+	Results are row numbers, i.e. shape ids, in ascending order.
+
+	The index refers to the store's values and must not outlive it.
+*/
+class AttributeIndex {
+public:
+	// Builds both parts, the sort and the hashing split across threads.
+	static shared_ptr<const AttributeIndex> build(const LayerAttributes& attrs, int column);
+
+	vector<int> find(double value) const;
+	vector<int> find(const StrView& value) const;
+	// Inclusive bounds. Numeric columns only, resp. text columns only.
+	vector<int> range(double lo, double hi) const;
+	vector<int> range(const StrView& lo, const StrView& hi) const;
+
+	int getColumn() const { return column; }
+
+	/*
+		Binary file next to the layer. load() checks that it was written for
+		the same column, row count and source stamp (see
+		LayerAttributes::sourceStamp) and that its contents are intact, and
+		returns NULL otherwise.
+	*/
+	bool save(const string& path, unsigned long long sourceStamp) const;
+	static shared_ptr<const AttributeIndex> load(const string& path, const LayerAttributes& attrs,
+		int column, unsigned long long sourceStamp);
+
+private:
+	const LayerAttributes* attrs;
+	int column;
+	bool numeric;
+	vector<int> bucketHead; // size is a power of 2
+	vector<int> next;       // next row with the same bucket, -1 at the end
+	vector<int> sorted;     // rows ordered by value, ties by row
+
+	AttributeIndex() : attrs(NULL), column(-1), numeric(false) {}
+	size_t hashRow(int row) const;
+	bool lessRow(int a, int b) const;
+	bool isConsistent() const; // of a loaded file
+};
+
+#endif
@@ -0,0 +1,2056 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Benchmarks.h"
+#include "Metrics.h"
+#include "ShapeScanner.h"
+#include "DecodeKernels.h"
+#include "AsyncIO.h"
+#include "LayerAttributes.h"
+#include "NameIndex.h"
+#include "ShapeFile.h"
+#include "MapSession.h"
+#include "Camera.h"
+#include "ViewCulling.h"
+#include "LayerCompositor.h"
+#include "RenderThread.h"
+#include "DrawList.h"
+#include "PointSymbols.h"
+#include "Decimate.h"
+#include "Clip.h"
+#include "SpatialOrder.h"
+#include "shapefil.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+static const int nRuns = 5;
+static volatile double sink; // keeps decoded values observable
+
+struct BenchResult {
+	double bestMs;
+	long long allocations; // per run
+};
+
+static void report(const char* what, const BenchResult& r, int nRecords){
+	printf("  %-28s %9.2f ms  %10lld allocs  %6.2f allocs/record\n",
+		what, r.bestMs, r.allocations, nRecords ? (double)r.allocations / nRecords : 0.0);
+}
+
+/*
+	The pre-arena load path: SHPReadObject per record, then a vector of
+	points per part. Shapelib allocates with calloc/malloc, which operator new
+	does not see, so those are counted from the SHPObject that comes back.
+*/
+static BenchResult benchDecodeShapelib(const string& basename){
+	BenchResult r = { 1e30, 0 };
+	for (int run = 0; run < nRuns; run++){
+		SHPHandle hSHP = SHPOpen((basename + ".shp").c_str(), "rb");
+		if (hSHP == NULL)
+			return r;
+		int nEntities, shpType;
+		SHPGetInfo(hSHP, &nEntities, &shpType, NULL, NULL);
+
+		long long allocs0 = Metrics::counter(COUNTER_ALLOCATIONS);
+		long long shapelibAllocs = 0;
+		long long t0 = Metrics::nowNs();
+		{
+			vector<vector<vec3> > parts;
+			for (int i = 0; i < nEntities; i++){
+				SHPObject* o = SHPReadObject(hSHP, i);
+				if (o == NULL)
+					break;
+				shapelibAllocs += 1 + (o->padfX != NULL) + (o->padfY != NULL) + (o->padfZ != NULL)
+					+ (o->padfM != NULL) + (o->panPartStart != NULL) + (o->panPartType != NULL);
+				int nParts = o->nParts > 0 ? o->nParts : 1;
+				for (int p = 0; p < nParts; p++){
+					int start = o->nParts > 0 ? o->panPartStart[p] : 0;
+					int end = (p + 1 < o->nParts) ? o->panPartStart[p + 1] : o->nVertices;
+					parts.push_back(vector<vec3>());
+					for (int v = start; v < end; v++)
+						parts.back().push_back(vec3((float)o->padfX[v], (float)o->padfY[v], (float)o->padfZ[v]));
+				}
+				SHPDestroyObject(o);
+			}
+		}
+		double ms = (Metrics::nowNs() - t0) / 1e6;
+		if (ms < r.bestMs)
+			r.bestMs = ms;
+		r.allocations = Metrics::counter(COUNTER_ALLOCATIONS) - allocs0 + shapelibAllocs;
+		SHPClose(hSHP);
+	}
+	return r;
+}
+
+static BenchResult benchDecodeStore(const ShapeReader& reader){
+	BenchResult r = { 1e30, 0 };
+	const ShapeIndex& index = *reader.getIndex();
+	size_t contentBytes = 0;
+	for (int i = 0; i < index.getRecordCount(); i++)
+		contentBytes += index.recSize[i];
+
+	for (int run = 0; run < nRuns; run++){
+		long long allocs0 = Metrics::counter(COUNTER_ALLOCATIONS);
+		long long t0 = Metrics::nowNs();
+		{
+			LayerGeometry geom;
+			geom.points.reserve(contentBytes / 16);
+			geom.partStart.reserve(index.getRecordCount() + 1);
+			geom.partShape.reserve(index.getRecordCount());
+			vector<unsigned char> record;
+			for (int i = 0; i < index.getRecordCount(); i++){
+				if (reader.readRecord(i, record) && !record.empty())
+					appendShapeRecord(&record[0], record.size(), i, geom);
+			}
+		}
+		double ms = (Metrics::nowNs() - t0) / 1e6;
+		if (ms < r.bestMs)
+			r.bestMs = ms;
+		r.allocations = Metrics::counter(COUNTER_ALLOCATIONS) - allocs0;
+	}
+	return r;
+}
+
+static BenchResult benchDecodeArena(const ShapeReader& reader){
+	BenchResult r = { 1e30, 0 };
+	const ShapeIndex& index = *reader.getIndex();
+	for (int run = 0; run < nRuns; run++){
+		long long allocs0 = Metrics::counter(COUNTER_ALLOCATIONS);
+		long long t0 = Metrics::nowNs();
+		size_t arenaAllocs;
+		{
+			Arena arena;
+			vector<unsigned char> record;
+			ShapeView shape;
+			double checksum = 0.0;
+			for (int i = 0; i < index.getRecordCount(); i++){
+				arena.reset();
+				if (reader.readShape(i, arena, shape, record) && shape.nVertices > 0)
+					checksum += shape.x[0];
+			}
+			arenaAllocs = arena.heapAllocations();
+			sink = checksum;
+		}
+		double ms = (Metrics::nowNs() - t0) / 1e6;
+		if (ms < r.bestMs)
+			r.bestMs = ms;
+		r.allocations = Metrics::counter(COUNTER_ALLOCATIONS) - allocs0 + (long long)arenaAllocs;
+	}
+	return r;
+}
+
+static int benchDecode(const string& basename){
+	ShapeReader reader;
+	if (!reader.open(basename)){
+		cout << "Could not open " << basename << endl;
+		return 1;
+	}
+	int n = reader.getRecordCount();
+	cout << "decode benchmark: " << basename << " (" << n << " records, best of " << nRuns << ")" << endl;
+	report("SHPReadObject + vectors", benchDecodeShapelib(basename), n);
+	report("decode into geometry store", benchDecodeStore(reader), n);
+	report("decode into arena", benchDecodeArena(reader), n);
+	return 0;
+}
+
+/*
+	All XY blocks of the layer, repeated until the buffer is large enough
+	that the kernels stream from memory rather than cache.
+*/
+static size_t gatherXY(const ShapeReader& reader, vector<unsigned char>& xy){
+	const size_t minBytes = 64 << 20;
+	vector<unsigned char> record;
+	for (int i = 0; i < reader.getRecordCount(); i++){
+		ShapeRecordLayout l;
+		if (!reader.readRecord(i, record) || record.empty() || !parseShapeRecord(&record[0], record.size(), l))
+			continue;
+		xy.insert(xy.end(), l.xy, l.xy + l.nPoints * 16);
+	}
+	if (xy.empty())
+		return 0;
+	size_t layerBytes = xy.size();
+	while (xy.size() < minBytes)
+		xy.insert(xy.end(), xy.begin(), xy.begin() + layerBytes);
+	return xy.size() / 16;
+}
+
+static int benchKernels(const string& basename){
+	ShapeReader reader;
+	if (!reader.open(basename)){
+		cout << "Could not open " << basename << endl;
+		return 1;
+	}
+	vector<unsigned char> xy;
+	size_t n = gatherXY(reader, xy);
+	if (n == 0){
+		cout << "No coordinates in " << basename << endl;
+		return 1;
+	}
+	printf("kernel benchmark: %s, %zu points (%.1f MB input), selected: %s\n",
+		basename.c_str(), n, n * 16 / 1048576.0, kernelISAName(decodeKernels().isa));
+
+	vector<double> dx(n), dy(n), refX(n), refY(n);
+	vector<float> fx(n), fy(n);
+	vector<vec3> v3(n);
+	vector<int> qx(n), qy(n);
+	CoordBounds refBounds;
+	decodeKernelsFor(ISA_SCALAR)->toDouble(&xy[0], n, &refX[0], &refY[0], &refBounds);
+	QuantizeParams q = { refBounds.minX, refBounds.minY, 100.0 }; // centimetres for metric data
+	vector<float> refFX(n), refFY(n);
+	vector<vec3> refV3(n);
+	vector<int> refQX(n), refQY(n);
+	const DecodeKernels* scalar = decodeKernelsFor(ISA_SCALAR);
+	scalar->toFloatSoA(&xy[0], n, &refFX[0], &refFY[0], NULL);
+	scalar->toVec3(&xy[0], n, &refV3[0], NULL);
+	scalar->toQuantized(&xy[0], n, q, &refQX[0], &refQY[0], NULL);
+
+	// rounding ties: (v - 0) * 2 lands on k + 0.5 for both signs; an odd count reaches the scalar tails
+	const int nTies = 37;
+	vector<unsigned char> tieXY(nTies * 16);
+	for (int i = 0; i < nTies; i++){
+		double tx = (i - nTies / 2) + 0.25, ty = -tx;
+		memcpy(&tieXY[i * 16], &tx, 8); // the hosts the vector kernels run on are little-endian
+		memcpy(&tieXY[i * 16 + 8], &ty, 8);
+	}
+	QuantizeParams tieQ = { 0, 0, 2 };
+	vector<int> refTX(nTies), refTY(nTies), tx(nTies), ty(nTies);
+	scalar->toQuantized(&tieXY[0], nTies, tieQ, &refTX[0], &refTY[0], NULL);
+
+	bool ok = true;
+	for (int isa = 0; isa < ISA_COUNT; isa++){
+		const DecodeKernels* k = decodeKernelsFor((KernelISA)isa);
+		if (k == NULL)
+			continue;
+		double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+		CoordBounds b;
+		for (int run = 0; run < nRuns; run++){
+			long long t0 = Metrics::nowNs();
+			k->toDouble(&xy[0], n, &dx[0], &dy[0], &b);
+			long long t1 = Metrics::nowNs();
+			k->toFloatSoA(&xy[0], n, &fx[0], &fy[0], &b);
+			long long t2 = Metrics::nowNs();
+			k->toVec3(&xy[0], n, &v3[0], &b);
+			long long t3 = Metrics::nowNs();
+			k->toQuantized(&xy[0], n, q, &qx[0], &qy[0], &b);
+			long long t4 = Metrics::nowNs();
+			long long t[5] = { t0, t1, t2, t3, t4 };
+			for (int j = 0; j < 4; j++){
+				double s = (t[j + 1] - t[j]) / 1e9;
+				if (s < best[j])
+					best[j] = s;
+			}
+		}
+		k->toQuantized(&tieXY[0], nTies, tieQ, &tx[0], &ty[0], NULL);
+		bool sameV3 = true;
+		for (size_t i = 0; i < n && sameV3; i++)
+			sameV3 = v3[i].x == refV3[i].x && v3[i].y == refV3[i].y && v3[i].z == refV3[i].z;
+		bool same = dx == refX && dy == refY && b.minX == refBounds.minX && b.minY == refBounds.minY
+			&& b.maxX == refBounds.maxX && b.maxY == refBounds.maxY
+			&& fx == refFX && fy == refFY && sameV3 && qx == refQX && qy == refQY && tx == refTX && ty == refTY;
+		double gb = n * 16 / 1e9;
+		printf("  %-7s double %6.2f GB/s  float SoA %6.2f GB/s  vec3 %6.2f GB/s  quantized %6.2f GB/s  %s\n",
+			kernelISAName((KernelISA)isa), gb / best[0], gb / best[1], gb / best[2], gb / best[3],
+			same ? "ok" : "MISMATCH");
+		ok = ok && same;
+	}
+	return ok ? 0 : 1;
+}
+
+/*
+	Opening the index: SHPOpen (which also parses the whole .shx) against
+	ShapeIndex::load, then the entry byte swap alone on a synthetic table of
+	10M entries for every kernel set.
+*/
+static int benchShx(const string& basename){
+	shared_ptr<const ShapeIndex> index = ShapeIndex::load(basename);
+	if (!index){
+		cout << "Could not open " << basename << endl;
+		return 1;
+	}
+	printf("shx benchmark: %s (%d records, best of %d)\n", basename.c_str(), index->getRecordCount(), nRuns);
+
+	double bestShapelib = 1e30, bestIndex = 1e30;
+	for (int run = 0; run < nRuns; run++){
+		long long t0 = Metrics::nowNs();
+		SHPHandle hSHP = SHPOpen((basename + ".shp").c_str(), "rb");
+		long long t1 = Metrics::nowNs();
+		if (hSHP)
+			SHPClose(hSHP);
+		long long t2 = Metrics::nowNs();
+		shared_ptr<const ShapeIndex> idx = ShapeIndex::load(basename);
+		long long t3 = Metrics::nowNs();
+		if (!idx || idx->recOffset != index->recOffset)
+			cout << "  index changed between runs" << endl;
+		if ((t1 - t0) / 1e6 < bestShapelib)
+			bestShapelib = (t1 - t0) / 1e6;
+		if ((t3 - t2) / 1e6 < bestIndex)
+			bestIndex = (t3 - t2) / 1e6;
+	}
+	printf("  %-28s %9.3f ms\n", "SHPOpen", bestShapelib);
+	printf("  %-28s %9.3f ms\n", "ShapeIndex::load", bestIndex);
+
+	const size_t n = 10000000;
+	vector<unsigned char> table(n * 8);
+	for (size_t i = 0; i < n; i++){
+		unsigned int words[2] = { (unsigned int)(50 + i * 64), 60 };
+		for (int w = 0; w < 2; w++)
+			for (int b = 0; b < 4; b++)
+				table[i * 8 + w * 4 + b] = (unsigned char)(words[w] >> (24 - b * 8));
+	}
+	vector<FileOffset> refOffsets(n), offsets(n);
+	vector<unsigned int> refSizes(n), sizes(n);
+	decodeKernelsFor(ISA_SCALAR)->shxEntries(&table[0], n, &refOffsets[0], &refSizes[0]);
+	for (int isa = 0; isa < ISA_COUNT; isa++){
+		const DecodeKernels* k = decodeKernelsFor((KernelISA)isa);
+		if (k == NULL)
+			continue;
+		double best = 1e30;
+		for (int run = 0; run < nRuns; run++){
+			long long t0 = Metrics::nowNs();
+			k->shxEntries(&table[0], n, &offsets[0], &sizes[0]);
+			double s = (Metrics::nowNs() - t0) / 1e9;
+			if (s < best)
+				best = s;
+		}
+		printf("  %-7s %zu entries %8.3f ms  %6.2f GB/s  %s\n", kernelISAName((KernelISA)isa), n, best * 1e3,
+			n * 8 / 1e9 / best, (offsets == refOffsets && sizes == refSizes) ? "ok" : "MISMATCH");
+	}
+	return 0;
+}
+
+/*
+	Full-layer scan: one positional read per record against the block
+	scanner at several read-ahead depths. Counts the read syscalls
+	issued; files come from the page cache after the first run.
+*/
+static void reportScan(const char* what, double bestMs, long long syscalls, size_t bytes){
+	printf("  %-28s %9.2f ms  %8lld syscalls  %8.1f MB/s\n", what, bestMs, syscalls, bytes / 1048576.0 / (bestMs / 1e3));
+}
+
+static int benchScan(const string& basename){
+	ShapeReader reader;
+	if (!reader.open(basename)){
+		cout << "Could not open " << basename << endl;
+		return 1;
+	}
+	const ShapeIndex& index = *reader.getIndex();
+	int n = index.getRecordCount();
+	size_t bytes = 0;
+	for (int i = 0; i < n; i++)
+		bytes += index.recSize[i];
+	printf("scan benchmark: %s (%d records, %.1f MB, best of %d)\n", basename.c_str(), n, bytes / 1048576.0, nRuns);
+
+	double best = 1e30;
+	long long syscalls = 0;
+	for (int run = 0; run < nRuns; run++){
+		long long s0 = Metrics::counter(COUNTER_SYSCALLS);
+		long long t0 = Metrics::nowNs();
+		vector<unsigned char> record;
+		double checksum = 0.0;
+		for (int i = 0; i < n; i++)
+			if (reader.readRecord(i, record) && !record.empty())
+				checksum += record[0];
+		double ms = (Metrics::nowNs() - t0) / 1e6;
+		sink = checksum;
+		if (ms < best)
+			best = ms;
+		syscalls = Metrics::counter(COUNTER_SYSCALLS) - s0;
+	}
+	reportScan("per-record reads", best, syscalls, bytes);
+
+	// small blocks so even the sample layers span many of them and records
+	// straddle block boundaries; the default size shows the single-block case
+	const size_t blockSizes[] = { 64 << 10, 256 << 10, 16 << 20 };
+	int mismatches = 0;
+	const int depths[] = { 0, 1, 4 };
+	for (int d = 0; d < 3; d++){
+		for (int b = 0; b < 3; b++){
+			// every record the scanner serves must match a plain per-record read,
+			// in order and when skipping ahead or going back
+			for (int pass = 0; pass < 2; pass++){
+				ShapeScanner scanner(reader, blockSizes[b], depths[d]);
+				vector<unsigned char> record;
+				const unsigned char* rec;
+				size_t len;
+				for (int k = 0; k < n; k++){
+					int i = pass == 0 ? k : (k % 64 == 63 ? k / 2 : k + k % 5 * (n / 50)) % n;
+					bool ok = reader.readRecord(i, record);
+					bool scanned = scanner.read(i, rec, len);
+					if (ok != scanned || (ok && (len != record.size() || (len > 0 && memcmp(rec, &record[0], len) != 0)))){
+						if (mismatches++ < 5)
+							printf("  MISMATCH record %d (%d KB blocks, read-ahead %d)\n", i, (int)(blockSizes[b] >> 10), depths[d]);
+					}
+				}
+			}
+
+			best = 1e30;
+			long long blockReads = 0, directReads = 0;
+			for (int run = 0; run < nRuns; run++){
+				long long s0 = Metrics::counter(COUNTER_SYSCALLS);
+				long long t0 = Metrics::nowNs();
+				{
+					ShapeScanner scanner(reader, blockSizes[b], depths[d]);
+					const unsigned char* rec;
+					size_t len;
+					double checksum = 0.0;
+					for (int i = 0; i < n; i++)
+						if (scanner.read(i, rec, len) && len > 0)
+							checksum += rec[0];
+					sink = checksum;
+					blockReads = scanner.getBlockReads();
+					directReads = scanner.getDirectReads();
+				}
+				double ms = (Metrics::nowNs() - t0) / 1e6;
+				if (ms < best)
+					best = ms;
+				syscalls = Metrics::counter(COUNTER_SYSCALLS) - s0;
+			}
+			char what[64];
+			sprintf(what, "%5d KB blocks, read-ahead %d", (int)(blockSizes[b] >> 10), depths[d]);
+			reportScan(what, best, syscalls, bytes);
+			printf("  %-28s %9lld block reads %5lld direct\n", "", blockReads, directReads);
+		}
+	}
+	if (mismatches > 0){
+		printf("  %d scanned records differ from per-record reads\n", mismatches);
+		return 1;
+	}
+	printf("  scanned records match per-record reads\n");
+	return 0;
+}
+
+/*
+	Random fetch(id) from several threads sharing one ShapeReader, with the
+	feature cache off and on. Lookups are skewed (most go to a tenth of the
+	layer) and every feature returned is checked against a sequential decode.
+*/
+static bool sameFeature(const Feature& a, const Feature& b){
+	return a.shpType == b.shpType && a.partStart == b.partStart && a.x == b.x && a.y == b.y && a.z == b.z &&
+		memcmp(a.boundsMin, b.boundsMin, sizeof(a.boundsMin)) == 0 && memcmp(a.boundsMax, b.boundsMax, sizeof(a.boundsMax)) == 0;
+}
+
+static int benchReader(const string& basename){
+	ShapeReader sequential;
+	if (!sequential.open(basename)){
+		cout << "Could not open " << basename << endl;
+		return 1;
+	}
+	int n = sequential.getRecordCount();
+	if (n == 0){
+		cout << "No records in " << basename << endl;
+		return 1;
+	}
+	vector<Feature> expected(n);
+	vector<bool> readable(n);
+	{
+		ShapeScanner scanner(sequential);
+		const unsigned char* rec;
+		size_t len;
+		for (int i = 0; i < n; i++)
+			readable[i] = scanner.read(i, rec, len) && (len == 0 || decodeShapeRecord(rec, len, expected[i]));
+	}
+	const int nThreads = 4, perThread = 50000;
+	size_t capacity = max(n / 8, 16);
+	printf("reader benchmark: %s (%d records, %d threads x %d lookups, cache of %d)\n",
+		basename.c_str(), n, nThreads, perThread, (int)capacity);
+
+	int status = 0;
+	for (int cached = 0; cached < 2; cached++){
+		ShapeReader reader;
+		if (!reader.open(basename, sequential.getIndex()))
+			return 1;
+		if (cached)
+			reader.enableCache(capacity);
+		long long h0 = Metrics::counter(COUNTER_CACHE_HITS), m0 = Metrics::counter(COUNTER_CACHE_MISSES);
+		atomic<int> mismatches(0);
+		vector<thread> threads;
+		long long t0 = Metrics::nowNs();
+		for (int t = 0; t < nThreads; t++){
+			threads.push_back(thread([&, t]{
+				unsigned int seed = 12345 + t;
+				int hot = max(n / 10, 1);
+				for (int k = 0; k < perThread; k++){
+					seed = seed * 1103515245u + 12345u;
+					int id = (seed >> 8) % 10 < 8 ? (int)((seed >> 12) % hot) : (int)((seed >> 12) % n);
+					shared_ptr<const Feature> f = reader.fetch(id);
+					if (f ? !readable[id] || !sameFeature(*f, expected[id]) : readable[id])
+						mismatches++;
+				}
+			}));
+		}
+		for (int t = 0; t < nThreads; t++)
+			threads[t].join();
+		double ms = (Metrics::nowNs() - t0) / 1e6;
+		long long hits = Metrics::counter(COUNTER_CACHE_HITS) - h0, misses = Metrics::counter(COUNTER_CACHE_MISSES) - m0;
+		printf("  %-28s %9.2f ms  %8.2f Mlookups/s  %5.1f%% hits  %s\n", cached ? "fetch, cache on" : "fetch, cache off", ms,
+			nThreads * (double)perThread / ms / 1e3, hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0,
+			mismatches.load() == 0 ? "ok" : "MISMATCH");
+		if (mismatches.load() > 0)
+			status = 1;
+	}
+	return status;
+}
+
+/*
+	Record reads kept in flight through AsyncReader; each completion is decoded
+	into an arena as it arrives (completion order, not id order). -1 when a
+	read fails or comes back short.
+*/
+static long long aioShp(const ShapeReader& reader, int queueDepth){
+	const ShapeIndex& index = *reader.getIndex();
+	vector<vector<unsigned char> > buffers(queueDepth); // before aio: it drains into them when destroyed
+	AsyncReader aio(queueDepth);
+	vector<int> freeBuffers;
+	for (int i = 0; i < queueDepth; i++)
+		freeBuffers.push_back(i);
+	Arena arena;
+	ShapeView shape;
+	long long vertices = 0;
+	IORequest done;
+	int next = 0;
+	while (next < index.getRecordCount() || aio.getInFlight() > 0){
+		while (next < index.getRecordCount() && !freeBuffers.empty()){
+			int b = freeBuffers.back();
+			freeBuffers.pop_back();
+			buffers[b].resize(index.recSize[next]);
+			IORequest r = { &reader.getFile(), index.recOffset[next] + 8, buffers[b].empty() ? NULL : &buffers[b][0],
+				buffers[b].size(), 0, (void*)(size_t)b };
+			aio.submit(r);
+			next++;
+		}
+		if (!aio.wait(done) || done.result != done.len)
+			return -1;
+		int b = (int)(size_t)done.user;
+		arena.reset();
+		if (done.len > 0 && decodeShapeRecord(&buffers[b][0], done.len, arena, shape))
+			vertices += shape.nVertices;
+		freeBuffers.push_back(b);
+	}
+	return vertices;
+}
+
+/*
+	The .dbf in blocks of whole records, decoding the deletion flags of
+	every record as a completion arrives. Returns the records not deleted,
+	-1 on a failed read.
+*/
+static long long aioDbf(const PosFile& dbf, int queueDepth){
+	unsigned char header[32];
+	if (dbf.readAt(0, header, 32) != 32)
+		return -1;
+	size_t headerLen = header[8] | (header[9] << 8);
+	size_t recordLen = header[10] | (header[11] << 8);
+	size_t nRecords = header[4] | (header[5] << 8) | (header[6] << 16) | ((size_t)header[7] << 24);
+	if (recordLen == 0)
+		return -1;
+	size_t perBlock = (1 << 20) / recordLen + 1;
+	size_t nBlocks = (nRecords + perBlock - 1) / perBlock;
+
+	if ((size_t)queueDepth > nBlocks)
+		queueDepth = nBlocks > 0 ? (int)nBlocks : 1;
+	vector<vector<unsigned char> > buffers(queueDepth, vector<unsigned char>(perBlock * recordLen));
+	AsyncReader aio(queueDepth);
+	vector<int> freeBuffers;
+	for (int i = 0; i < queueDepth; i++)
+		freeBuffers.push_back(i);
+	long long live = 0;
+	IORequest done;
+	size_t next = 0;
+	while (next < nBlocks || aio.getInFlight() > 0){
+		while (next < nBlocks && !freeBuffers.empty()){
+			int b = freeBuffers.back();
+			freeBuffers.pop_back();
+			size_t first = next * perBlock;
+			size_t count = (nRecords - first < perBlock) ? nRecords - first : perBlock;
+			IORequest r = { &dbf, headerLen + (FileOffset)first * recordLen, &buffers[b][0], count * recordLen, 0, (void*)(size_t)b };
+			aio.submit(r);
+			next++;
+		}
+		if (!aio.wait(done))
+			return -1;
+		int b = (int)(size_t)done.user;
+		for (size_t i = 0; i < done.result / recordLen; i++)
+			live += buffers[b][i * recordLen] != '*';
+		freeBuffers.push_back(b);
+	}
+	return live;
+}
+
+static int benchAio(const string& basename){
+	ShapeReader reader;
+	PosFile dbf;
+	if (!reader.open(basename) || (!dbf.open((basename + ".dbf").c_str()) && !dbf.open((basename + ".DBF").c_str()))){
+		cout << "Could not open " << basename << endl;
+		return 1;
+	}
+	const ShapeIndex& index = *reader.getIndex();
+	int n = index.getRecordCount();
+	size_t shpBytes = 0;
+	for (int i = 0; i < n; i++)
+		shpBytes += index.recSize[i];
+	{
+		AsyncReader probe(1);
+		printf("aio benchmark: %s (%d records, backend: %s, best of %d)\n", basename.c_str(), n,
+			AsyncReader::backendName(probe.getBackend()), nRuns);
+	}
+
+	// what every asynchronous pass must reproduce
+	long long liveRecords = -1;
+	{
+		MappedDBF table;
+		if (table.open(basename))
+			liveRecords = table.getRecordCount() - table.getDeletedCount();
+	}
+
+	// synchronous baseline: one blocking read per record, decoded in order
+	double best = 1e30;
+	long long blockingVertices = 0;
+	for (int run = 0; run < nRuns; run++){
+		long long t0 = Metrics::nowNs();
+		Arena arena;
+		ShapeView shape;
+		vector<unsigned char> scratch;
+		long long vertices = 0;
+		for (int i = 0; i < n; i++){
+			arena.reset();
+			if (reader.readShape(i, arena, shape, scratch))
+				vertices += shape.nVertices;
+		}
+		blockingVertices = vertices;
+		double ms = (Metrics::nowNs() - t0) / 1e6;
+		if (ms < best)
+			best = ms;
+	}
+	printf("  %-28s %9.2f ms  %8.1f MB/s\n", ".shp blocking reads", best, shpBytes / 1048576.0 / (best / 1e3));
+	// the files are in the page cache after the first run, so this measures
+	// submission overhead; queue depth pays off on cold reads from the device
+
+	const int depths[] = { 1, 8, 64 };
+	bool failed = false;
+	for (int d = 0; d < 3; d++){
+		best = 1e30;
+		double bestDbf = 1e30;
+		long long syscalls = 0;
+		bool shpSame = true, dbfSame = true;
+		for (int run = 0; run < nRuns; run++){
+			long long s0 = Metrics::counter(COUNTER_SYSCALLS);
+			long long t0 = Metrics::nowNs();
+			long long vertices = aioShp(reader, depths[d]);
+			long long t1 = Metrics::nowNs();
+			syscalls = Metrics::counter(COUNTER_SYSCALLS) - s0;
+			long long live = aioDbf(dbf, depths[d]);
+			long long t2 = Metrics::nowNs();
+			shpSame = shpSame && vertices == blockingVertices;
+			dbfSame = dbfSame && live == liveRecords;
+			if ((t1 - t0) / 1e6 < best)
+				best = (t1 - t0) / 1e6;
+			if ((t2 - t1) / 1e6 < bestDbf)
+				bestDbf = (t2 - t1) / 1e6;
+		}
+		char what[64];
+		sprintf(what, ".shp records, depth %d", depths[d]);
+		printf("  %-28s %9.2f ms  %8lld syscalls  %8.1f MB/s  %s\n", what, best, syscalls,
+			shpBytes / 1048576.0 / (best / 1e3), shpSame ? "ok" : "MISMATCH");
+		sprintf(what, ".dbf blocks, depth %d", depths[d]);
+		printf("  %-28s %9.2f ms  %8.1f MB/s  %s\n", what, bestDbf, dbf.size() / 1048576.0 / (bestDbf / 1e3),
+			dbfSame ? "ok" : "MISMATCH");
+		if (!shpSame || !dbfSame)
+			failed = true;
+	}
+	return failed ? 1 : 0;
+}
+
+/*
+	Every numeric column of the layer's .dbf: DBFReadDoubleAttribute per cell
+	against the bulk column reader.
+*/
+static int benchDbf(const string& basename){
+	DBFReader bulk;
+	DBFHandle hDBF = DBFOpenLL((basename + ".dbf").c_str(), "rb", Metrics::countingHooks());
+	if (!bulk.open(basename) || hDBF == NULL){
+		cout << "Could not open " << basename << ".dbf" << endl;
+		if (hDBF)
+			DBFClose(hDBF);
+		return 1;
+	}
+	const DBFSchema& schema = bulk.getSchema();
+	vector<int> fields;
+	for (size_t i = 0; i < schema.fields.size(); i++)
+		if (schema.fields[i].type == 'N' || schema.fields[i].type == 'F')
+			fields.push_back((int)i);
+	int n = bulk.getRecordCount();
+	if (fields.empty() || n == 0){
+		cout << "No numeric columns in " << basename << ".dbf" << endl;
+		DBFClose(hDBF);
+		return 1;
+	}
+	printf("dbf benchmark: %s.dbf (%d records, %d numeric columns, best of %d)\n",
+		basename.c_str(), n, (int)fields.size(), nRuns);
+
+	vector<vector<double> > perCell(fields.size(), vector<double>(n)), columns(fields.size(), vector<double>(n));
+	vector<double*> out(fields.size());
+	for (size_t k = 0; k < fields.size(); k++)
+		out[k] = &columns[k][0];
+
+	double bestCell = 1e30, bestBulk = 1e30;
+	long long syscallsCell = 0, syscallsBulk = 0;
+	for (int run = 0; run < nRuns; run++){
+		long long s0 = Metrics::counter(COUNTER_SYSCALLS);
+		long long t0 = Metrics::nowNs();
+		for (int i = 0; i < n; i++)
+			for (size_t k = 0; k < fields.size(); k++)
+				perCell[k][i] = DBFReadDoubleAttribute(hDBF, i, fields[k]);
+		long long t1 = Metrics::nowNs();
+		long long s1 = Metrics::counter(COUNTER_SYSCALLS);
+		bulk.readNumericColumns(&fields[0], (int)fields.size(), 0, n, &out[0]);
+		long long t2 = Metrics::nowNs();
+		long long s2 = Metrics::counter(COUNTER_SYSCALLS);
+		if ((t1 - t0) / 1e6 < bestCell)
+			bestCell = (t1 - t0) / 1e6;
+		if ((t2 - t1) / 1e6 < bestBulk)
+			bestBulk = (t2 - t1) / 1e6;
+		syscallsCell = s1 - s0;
+		syscallsBulk = s2 - s1;
+	}
+	DBFClose(hDBF);
+	long long cells = (long long)n * fields.size();
+	printf("  %-28s %9.2f ms  %8lld syscalls  %8.1f Mcells/s\n", "DBFReadDoubleAttribute", bestCell, syscallsCell, cells / bestCell / 1e3);
+	printf("  %-28s %9.2f ms  %8lld syscalls  %8.1f Mcells/s  %s\n", "bulk column read", bestBulk, syscallsBulk, cells / bestBulk / 1e3,
+		perCell == columns ? "ok" : "MISMATCH");
+	bool same = perCell == columns;
+
+	// small blocks, several in flight: the sample layers fit in one default block
+	bulk.setBlockSize(16 << 10);
+	for (int depth = 1; depth <= 4; depth *= 4){
+		bulk.setReadAhead(depth);
+		for (size_t k = 0; k < fields.size(); k++)
+			fill(columns[k].begin(), columns[k].end(), 0.0);
+		double best = 1e30;
+		long long syscalls = 0;
+		bool ok = true;
+		for (int run = 0; run < nRuns; run++){
+			long long s0 = Metrics::counter(COUNTER_SYSCALLS);
+			long long t0 = Metrics::nowNs();
+			ok = bulk.readNumericColumns(&fields[0], (int)fields.size(), 0, n, &out[0]) && ok;
+			double ms = (Metrics::nowNs() - t0) / 1e6;
+			if (ms < best)
+				best = ms;
+			syscalls = Metrics::counter(COUNTER_SYSCALLS) - s0;
+		}
+		ok = ok && perCell == columns;
+		same = same && ok;
+		char what[64];
+		sprintf(what, "16 KB blocks, %d in flight", depth);
+		printf("  %-28s %9.2f ms  %8lld syscalls  %8.1f Mcells/s  %s\n", what, best, syscalls, cells / best / 1e3, ok ? "ok" : "MISMATCH");
+	}
+	return same ? 0 : 1;
+}
+
+/*
+	Every character field of a .dbf: DBFReadStringAttribute (copied out, since
+	its buffer is reused) against views into the mapped file, then the same
+	scan from several threads sharing one MappedDBF.
+*/
+static int benchStrings(const string& basename){
+	MappedDBF mapped;
+	DBFHandle hDBF = DBFOpenLL((basename + ".dbf").c_str(), "rb", Metrics::countingHooks());
+	if (!mapped.open(basename) || hDBF == NULL){
+		cout << "Could not open " << basename << ".dbf" << endl;
+		if (hDBF)
+			DBFClose(hDBF);
+		return 1;
+	}
+	const DBFSchema& schema = mapped.getSchema();
+	vector<int> fields;
+	for (size_t i = 0; i < schema.fields.size(); i++)
+		if (schema.fields[i].type == 'C')
+			fields.push_back((int)i);
+	int n = mapped.getRecordCount();
+	printf("strings benchmark: %s.dbf (%d records, %d string columns, %d deleted, best of %d)\n",
+		basename.c_str(), n, (int)fields.size(), mapped.getDeletedCount(), nRuns);
+
+	vector<string> copies((size_t)n * fields.size());
+	vector<StrView> views((size_t)n * fields.size());
+	double bestCopy = 1e30, bestView = 1e30;
+	for (int run = 0; run < nRuns; run++){
+		long long t0 = Metrics::nowNs();
+		for (int i = 0; i < n; i++)
+			for (size_t k = 0; k < fields.size(); k++)
+				copies[i * fields.size() + k] = DBFReadStringAttribute(hDBF, i, fields[k]);
+		long long t1 = Metrics::nowNs();
+		for (int i = 0; i < n; i++)
+			for (size_t k = 0; k < fields.size(); k++)
+				views[i * fields.size() + k] = mapped.getString(i, fields[k]);
+		long long t2 = Metrics::nowNs();
+		if ((t1 - t0) / 1e6 < bestCopy)
+			bestCopy = (t1 - t0) / 1e6;
+		if ((t2 - t1) / 1e6 < bestView)
+			bestView = (t2 - t1) / 1e6;
+	}
+	DBFClose(hDBF);
+	bool same = true;
+	for (size_t i = 0; i < copies.size(); i++)
+		same = same && StrView(copies[i]) == views[i];
+	printf("  %-28s %9.3f ms\n", "DBFReadStringAttribute", bestCopy);
+	printf("  %-28s %9.3f ms  %s\n", "mapped views", bestView, same ? "ok" : "MISMATCH");
+
+	// concurrent readers: each thread checks its slice against the serial views
+	const int nThreads = 4;
+	atomic<int> mismatches(0);
+	vector<thread> threads;
+	long long t0 = Metrics::nowNs();
+	for (int t = 0; t < nThreads; t++){
+		threads.push_back(thread([&, t]{
+			for (int i = t; i < n; i += nThreads)
+				for (size_t k = 0; k < fields.size(); k++)
+					if (mapped.getString(i, fields[k]) != views[i * fields.size() + k])
+						mismatches++;
+		}));
+	}
+	for (int t = 0; t < nThreads; t++)
+		threads[t].join();
+	printf("  %-28s %9.3f ms  %s\n", "mapped views, 4 threads", (Metrics::nowNs() - t0) / 1e6,
+		mismatches.load() == 0 ? "ok" : "MISMATCH");
+	return 0;
+}
+
+/*
+	Equality lookups of 100 values of one column (the first joined text
+	column, else the last column): a linear DBFRead*Attribute scan per query
+	against the attribute index, plus index build, save and reload times.
+*/
+static int benchIndex(const string& basename){
+	shared_ptr<LayerAttributes> attrs = LayerAttributes::load(basename);
+	if (!attrs){
+		cout << "Could not open " << basename << ".dbf" << endl;
+		return 1;
+	}
+	attrs->joinSideTables(basename);
+	int c = attrs->getColumnCount() - 1;
+	for (int i = 0; i < attrs->getColumnCount(); i++)
+		if (!attrs->getColumn(i).joinedFrom.empty() && !attrs->getColumn(i).isNumeric()){
+			c = i;
+			break;
+		}
+	const AttributeColumn& column = attrs->getColumn(c);
+	int n = attrs->getRowCount();
+	const int nQueries = 100;
+	printf("index benchmark: %s, column %s (%d rows, %d queries)\n", basename.c_str(), column.name.c_str(), n, nQueries);
+
+	// the per-cell path needs the table the column lives in
+	string table = basename;
+	if (!column.joinedFrom.empty()){
+		size_t slash = basename.find_last_of("/\\");
+		table = (slash == string::npos ? string() : basename.substr(0, slash + 1)) + column.joinedFrom;
+	}
+	DBFHandle hDBF = DBFOpenLL((table + ".dbf").c_str(), "rb", Metrics::countingHooks());
+	int field = hDBF ? DBFGetFieldIndex(hDBF, column.name.c_str()) : -1;
+	if (field < 0){
+		cout << "Could not open " << table << ".dbf" << endl;
+		if (hDBF)
+			DBFClose(hDBF);
+		return 1;
+	}
+	int tableRows = DBFGetRecordCount(hDBF);
+	long long t0 = Metrics::nowNs();
+	long long hits = 0;
+	for (int q = 0; q < nQueries; q++){
+		int row = (int)((long long)q * n / nQueries);
+		for (int r = 0; r < tableRows; r++){
+			if (column.isNumeric())
+				hits += DBFReadDoubleAttribute(hDBF, r, field) == column.numbers[row];
+			else
+				hits += column.strings[row] == StrView(string(DBFReadStringAttribute(hDBF, r, field)));
+		}
+	}
+	long long t1 = Metrics::nowNs();
+	DBFClose(hDBF);
+	printf("  %-28s %9.3f ms  (%s.dbf, %d records)\n", "linear DBF scans", (t1 - t0) / 1e6,
+		column.joinedFrom.empty() ? "layer" : column.joinedFrom.c_str(), tableRows);
+
+	string path = basename + "." + column.name + ".aix";
+	remove(path.c_str());
+	long long b0 = Metrics::nowNs();
+	shared_ptr<const AttributeIndex> index = attrs->getIndex(c); // builds and saves
+	long long b1 = Metrics::nowNs();
+	shared_ptr<const AttributeIndex> reloaded = AttributeIndex::load(path, *attrs, c,
+		0); // wrong stamp on purpose: must be rejected
+	printf("  %-28s %9.3f ms  %s\n", "index build + save", (b1 - b0) / 1e6, reloaded ? "STALE FILE ACCEPTED" : "");
+
+	long long q0 = Metrics::nowNs();
+	long long indexHits = 0;
+	bool same = true;
+	for (int q = 0; q < nQueries; q++){
+		int row = (int)((long long)q * n / nQueries);
+		vector<int> rows = column.isNumeric() ? index->find(column.numbers[row]) : index->find(column.strings[row]);
+		indexHits += (long long)rows.size();
+		same = same && binary_search(rows.begin(), rows.end(), row);
+	}
+	long long q1 = Metrics::nowNs();
+	printf("  %-28s %9.3f ms  %lld matching shapes  %s\n", "index lookups", (q1 - q0) / 1e6, indexHits, same ? "ok" : "MISMATCH");
+	if (column.joinedFrom.empty() && indexHits != hits)
+		printf("  linear scan found %lld matches: MISMATCH\n", hits);
+	return 0;
+}
+
+// Plain Levenshtein; with prefixMode, against the closest prefix of key.
+static int editDistance(const string& q, const string& key, bool prefixMode){
+	vector<int> prev(q.size() + 1), row(q.size() + 1);
+	for (size_t j = 0; j <= q.size(); j++)
+		prev[j] = (int)j;
+	int best = prev[q.size()];
+	for (size_t i = 0; i < key.size(); i++){
+		row[0] = (int)i + 1;
+		for (size_t j = 1; j <= q.size(); j++)
+			row[j] = min(min(prev[j] + 1, row[j - 1] + 1), prev[j - 1] + (q[j - 1] != key[i]));
+		best = min(best, row[q.size()]);
+		prev.swap(row);
+	}
+	return prefixMode ? best : prev[q.size()];
+}
+
+/*
+	Name search: prefix and edit-distance queries made from the names
+	themselves (a 3 letter prefix, a one letter typo), timed per query and
+	checked against a scan over all folded names.
+*/
+static int benchNames(const string& basename){
+	shared_ptr<LayerAttributes> attrs = LayerAttributes::load(basename);
+	if (!attrs){
+		cout << "Could not open " << basename << ".dbf" << endl;
+		return 1;
+	}
+	attrs->joinSideTables(basename);
+	int c = attrs->findColumn("strName");
+	for (int i = 0; i < attrs->getColumnCount() && c < 0; i++)
+		if (attrs->getColumn(i).type == 'C')
+			c = i;
+	if (c < 0){
+		cout << "No text column in " << basename << ".dbf" << endl;
+		return 1;
+	}
+	const AttributeColumn& column = attrs->getColumn(c);
+	shared_ptr<const LayerGeometry> geometry = ShapeFile::load(basename.c_str());
+	if (!geometry)
+		return 1;
+
+	long long b0 = Metrics::nowNs();
+	shared_ptr<const NameIndex> index = NameIndex::build(*attrs, c, geometry.get());
+	long long b1 = Metrics::nowNs();
+	printf("names benchmark: %s, column %s, code page \"%s\" (%d rows, %d keys)\n", basename.c_str(),
+		column.name.c_str(), column.codePage.c_str(), attrs->getRowCount(), index->getKeyCount());
+	printf("  %-28s %9.3f ms  %zu bytes\n", "build", (b1 - b0) / 1e6, index->getMemoryBytes());
+
+	vector<string> keys;
+	for (int r = 0; r < attrs->getRowCount(); r++)
+		keys.push_back(foldName(column.strings[r], column.codePage));
+	sort(keys.begin(), keys.end());
+	keys.erase(unique(keys.begin(), keys.end()), keys.end());
+	if (!keys.empty() && keys[0].empty())
+		keys.erase(keys.begin());
+	if (keys.empty())
+		return 0;
+
+	const int nQueries = 200;
+	const char* kinds[4] = { "prefix", "fuzzy, 1 edit", "fuzzy, 2 edits", "fuzzy prefix, 1 edit" };
+	for (int kind = 0; kind < 4; kind++){
+		vector<string> queries;
+		for (int q = 0; q < nQueries; q++){
+			string key = keys[(size_t)q * keys.size() / nQueries];
+			if (kind == 0 || kind == 3)
+				key = key.substr(0, 3 + kind);
+			if (kind > 0 && !key.empty())
+				key[key.size() / 2] = key[key.size() / 2] == 'x' ? 'y' : 'x';
+			queries.push_back(foldName(StrView(key), "UTF-8")); // as the index folds them
+		}
+		int maxEdits = kind == 2 ? 2 : 1;
+		bool prefixMode = kind == 3;
+		long long q0 = Metrics::nowNs();
+		size_t results = 0;
+		vector<size_t> counts;
+		for (int q = 0; q < nQueries; q++){
+			vector<NameMatch> m = kind == 0 ? index->prefix(queries[q], 1 << 30) : index->fuzzy(queries[q], maxEdits, prefixMode, 1 << 30);
+			results += m.size();
+			counts.push_back(m.size());
+		}
+		long long q1 = Metrics::nowNs();
+		bool same = true;
+		for (int q = 0; q < nQueries; q++){
+			size_t expected = 0;
+			for (size_t k = 0; k < keys.size(); k++)
+				expected += kind == 0 ? keys[k].compare(0, queries[q].size(), queries[q]) == 0
+					: editDistance(queries[q], keys[k], prefixMode) <= maxEdits;
+			same = same && expected == counts[q];
+		}
+		printf("  %-28s %9.2f us/query  %zu matches  %s\n", kinds[kind], (q1 - q0) / 1e3 / nQueries, results, same ? "ok" : "MISMATCH");
+	}
+	return 0;
+}
+
+/*
+	Opening a whole session: layer by layer, then all layers at once.
+	Here the argument is the .thuban file.
+*/
+static int benchSession(const string& path){
+	MapSession session;
+	if (!session.open(path)){
+		cout << "Could not read session " << path << endl;
+		return 1;
+	}
+	double ms[2];
+	size_t nLoaded = 0;
+	for (int parallel = 0; parallel < 2; parallel++){
+		long long t0 = Metrics::nowNs();
+		vector<LayerHandle> layers = session.load(parallel != 0);
+		ms[parallel] = (Metrics::nowNs() - t0) / 1e6;
+		nLoaded = layers.size();
+	}
+	printf("session benchmark: %s \"%s\" (%zu of %zu layers)\n", path.c_str(), session.getTitle().c_str(),
+		nLoaded, session.getLayers().size());
+	printf("  %-28s %9.2f ms\n", "one layer after another", ms[0]);
+	printf("  %-28s %9.2f ms\n", "all layers in parallel", ms[1]);
+	return 0;
+}
+
+/*
+	View-dependent selection while dragging: the layer is tiled until it
+	has a million parts, then a 1024x768 view zoomed in 8 times is dragged
+	across it. Reports the per-frame cost of culling and LOD, and the
+	vertices left to submit against the whole layer.
+*/
+static int benchView(const string& basename){
+	shared_ptr<const LayerGeometry> base = ShapeFile::load(basename.c_str());
+	if (!base || base->getPartCount() == 0)
+		return 1;
+	const int targetParts = 1000000;
+	int copies = 1;
+	while (copies * copies * base->getPartCount() < targetParts)
+		copies++;
+	float w = base->boundBoxMax.x - base->boundBoxMin.x, h = base->boundBoxMax.y - base->boundBoxMin.y;
+	LayerGeometry geom;
+	geom.shpType = base->shpType;
+	geom.points.reserve(base->points.size() * copies * copies);
+	for (int cy = 0; cy < copies; cy++)
+		for (int cx = 0; cx < copies; cx++){
+			vec3 shift(cx * w, cy * h, 0);
+			for (int p = 0; p < base->getPartCount(); p++){
+				const vec3* v = base->getPart(p);
+				for (int i = 0; i < base->getPartSize(p); i++)
+					geom.points.push_back(v[i] + shift);
+				geom.partStart.push_back((unsigned int)geom.points.size());
+				geom.partShape.push_back(geom.getPartCount());
+				const vec4& b = base->partBounds[p];
+				geom.partBounds.push_back(vec4(b.x + shift.x, b.y + shift.y, b.z + shift.x, b.w + shift.y));
+			}
+		}
+	printf("view benchmark: %s tiled %dx%d (%d parts, %zu vertices)\n", basename.c_str(), copies, copies,
+		geom.getPartCount(), geom.points.size());
+
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(vec4(base->boundBoxMin.x, base->boundBoxMin.y, base->boundBoxMin.x + w * copies, base->boundBoxMin.y + h * copies));
+	VisibleParts visible;
+	for (int zoomed = 0; zoomed < 2; zoomed++){
+		camera.reset();
+		if (zoomed)
+			camera.zoomAt(512, 384, 8);
+		const int nFrames = 200;
+		double totalMs = 0, maxMs = 0;
+		long long vertices = 0, dots = 0;
+		for (int f = 0; f < nFrames; f++){
+			long long t0 = Metrics::nowNs();
+			visible.clear();
+			selectVisibleParts(geom, camera.getView(), (float)camera.getWorldPerPixel(), visible);
+			double ms = (Metrics::nowNs() - t0) / 1e6;
+			totalMs += ms;
+			maxMs = max(maxMs, ms);
+			for (size_t i = 0; i < visible.detailed.size(); i++)
+				vertices += geom.getPartSize(visible.detailed[i]);
+			dots += (long long)visible.dots.size();
+			camera.pan(zoomed ? -10 : -2, 1);
+		}
+		printf("  %-28s %7.2f ms/frame (max %.2f)  %9lld vertices + %7lld dots per frame\n",
+			zoomed ? "drag, zoomed in 8x" : "drag, whole map", totalMs / nFrames, maxMs,
+			vertices / nFrames, dots / nFrames);
+	}
+	return 0;
+}
+
+static long long countDifferentPixels(const RasterImage& a, const RasterImage& b){
+	long long n = 0;
+	for (size_t i = 0; i < a.pixels.size() && i < b.pixels.size(); i++)
+		n += a.pixels[i] != b.pixels[i];
+	return n;
+}
+
+/*
+	Cached compositing of a session (the argument is the .thuban file) in a
+	1024x768 frame: frame times for the first frame, pans, hiding a layer,
+	restyling a layer and zooming. After the pans the frame is checked
+	against one composed from scratch.
+*/
+static int benchRaster(const string& path){
+	MapSession session;
+	if (!session.open(path)){
+		cout << "Could not read session " << path << endl;
+		return 1;
+	}
+	LayerRegistry registry;
+	vector<LayerHandle> loaded = session.load();
+	vec4 world;
+	for (size_t i = 0; i < loaded.size(); i++){
+		registry.add(loaded[i]);
+		vec4 b = loaded[i]->getBoundaries();
+		world = i == 0 ? b : vec4(min(world.x, b.x), min(world.y, b.y), max(world.z, b.z), max(world.w, b.w));
+	}
+	vector<LayerHandle> layers = registry.snapshot();
+	if (layers.empty())
+		return 1;
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(world);
+	camera.zoomAt(512, 384, 2);
+	LayerCompositor compositor;
+	compositor.setBackground(vec4(1, 1, 1, 1));
+	printf("raster benchmark: %s (%zu layers, 1024x768)\n", path.c_str(), layers.size());
+
+	compositor.compose(layers, camera);
+	printf("  %-28s %9.2f ms  (%d layers drawn)\n", "first frame", compositor.getStats().ms, compositor.getStats().fullRedraws);
+
+	struct Step { const char* name; int kind; };
+	const Step steps[] = { { "pan by 7,3 px", 0 }, { "hide/show one layer", 1 }, { "restyle one layer", 2 }, { "zoom", 3 } };
+	const int nFrames = 40;
+	for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++){
+		double total = 0, worst = 0;
+		int full = 0, strips = 0;
+		for (int f = 0; f < nFrames; f++){
+			if (steps[s].kind == 0)
+				camera.pan(7, f % 2 ? 3 : -3);
+			else if (steps[s].kind == 1)
+				layers[0]->setVisible(!layers[0]->isVisible());
+			else if (steps[s].kind == 2)
+				layers[layers.size() - 1]->setStyle(layers[layers.size() - 1]->getStyle());
+			else
+				camera.zoomAt(512, 384, f % 2 ? 1.25 : 0.8);
+			compositor.compose(layers, camera);
+			total += compositor.getStats().ms;
+			worst = max(worst, compositor.getStats().ms);
+			full += compositor.getStats().fullRedraws;
+			strips += compositor.getStats().stripRedraws;
+		}
+		printf("  %-28s %9.2f ms/frame (max %.2f)  %5.2f layers drawn, %4.2f patched per frame\n", steps[s].name,
+			total / nFrames, worst, (double)full / nFrames, (double)strips / nFrames);
+		if (steps[s].kind == 0){
+			LayerCompositor fresh;
+			fresh.setBackground(vec4(1, 1, 1, 1));
+			long long diff = countDifferentPixels(fresh.compose(layers, camera), compositor.getFrame());
+			printf("  %-28s %lld pixels differ  %s\n", "panned vs from scratch", diff, diff ? "MISMATCH" : "ok");
+		}
+	}
+
+	// progressive zooms: first frame within the budget, then refining frames until done
+	const double budgets[] = { 4, 8 };
+	for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++){
+		double first = 0, total = 0;
+		int zooms = 0, frames = 0;
+		for (int f = 0; f < 10; f++, zooms++){
+			camera.zoomAt(512, 384, f % 2 ? 1.25 : 0.8);
+			compositor.compose(layers, camera, budgets[b]);
+			first += compositor.getStats().ms;
+			total += compositor.getStats().ms;
+			frames++;
+			while (compositor.isRefining()){
+				compositor.compose(layers, camera, budgets[b]);
+				total += compositor.getStats().ms;
+				frames++;
+			}
+		}
+		char name[64];
+		sprintf(name, "zoom, %.0f ms budget", budgets[b]);
+		printf("  %-28s %9.2f ms first frame, %4.1f frames and %.2f ms until done\n", name,
+			first / zooms, (double)frames / zooms, total / zooms);
+	}
+	// a zoom cancelled halfway by a pan, then finished
+	camera.zoomAt(512, 384, 1.25);
+	compositor.compose(layers, camera, 1);
+	camera.pan(5, -2);
+	compositor.compose(layers, camera, 1);
+	while (compositor.isRefining())
+		compositor.compose(layers, camera, 1);
+	LayerCompositor fresh;
+	fresh.setBackground(vec4(1, 1, 1, 1));
+	long long diff = countDifferentPixels(fresh.compose(layers, camera), compositor.getFrame());
+	printf("  %-28s %lld pixels differ  %s\n", "refined vs from scratch", diff, diff ? "MISMATCH" : "ok");
+	return 0;
+}
+
+/*
+	Draw calls and GL state calls of the -direct path per frame, entity by
+	entity against sorted, merged and filtered, for the whole map and a
+	zoomed-in view. Counted without a GL context.
+*/
+static int benchBatching(const string& path){
+	MapSession session;
+	if (!session.open(path)){
+		cout << "Could not read session " << path << endl;
+		return 1;
+	}
+	vector<LayerHandle> layers = session.load();
+	if (layers.empty())
+		return 1;
+	vec4 world;
+	for (size_t i = 0; i < layers.size(); i++){
+		vec4 b = layers[i]->getBoundaries();
+		world = i == 0 ? b : vec4(min(world.x, b.x), min(world.y, b.y), max(world.z, b.z), max(world.w, b.w));
+	}
+	printf("draw batching benchmark: %s (%zu layers, 1024x768)\n", path.c_str(), layers.size());
+	printf("  %-12s %8s %16s %22s %10s\n", "view", "items", "draw calls", "state calls", "build ms");
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(world);
+	const double zooms[] = { 1, 8, 64 };
+	DrawList list;
+	for (size_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); z++){
+		camera.reset();
+		camera.zoomAt(512, 384, zooms[z]);
+		const int nFrames = 10;
+		long long t0 = Metrics::nowNs();
+		for (int f = 0; f < nFrames; f++){
+			list.clear();
+			for (size_t i = 0; i < layers.size(); i++)
+				layers[i]->addDrawItems(list, (int)i, camera.getView(), (float)camera.getWorldPerPixel());
+			list.finish();
+		}
+		double ms = (Metrics::nowNs() - t0) / 1e6 / nFrames;
+		GLStateCache counter(false);
+		list.submit(counter);
+		const DrawListStats& s = list.getStats();
+		char name[32], calls[32], state[32];
+		sprintf(name, "zoom x%.0f", zooms[z]);
+		sprintf(calls, "%d -> %d", s.perEntityDrawCalls, s.batches);
+		sprintf(state, "%d -> %d -> %d", s.perEntityStateChanges, s.stateRequests, s.stateChanges);
+		printf("  %-12s %8d %16s %22s %10.2f\n", name, s.items, calls, state, ms);
+	}
+	printf("  (state calls: entity by entity -> asked for by the batches -> left after the filter)\n");
+	return 0;
+}
+
+/*
+	POI symbols at scale: the point layer tiled to some 300000 points (types
+	kept from the original records), drawn as dots and as symbols, through
+	the GL draw list (counted, no context) and the software renderer.
+*/
+static int benchSymbols(const string& basename){
+	shared_ptr<const LayerGeometry> base = ShapeFile::load(basename.c_str());
+	shared_ptr<const LayerAttributes> attrs = ShapeFile::loadAttributes(basename.c_str());
+	if (!base || base->getPartCount() == 0 || !attrs || attrs->getTypeColumn() < 0){
+		cout << basename << ": need a point layer with a _typen side table" << endl;
+		return 1;
+	}
+	const int targetPoints = 300000;
+	int copies = 1;
+	while (copies * copies * base->getPartCount() < targetPoints)
+		copies++;
+	float w = base->boundBoxMax.x - base->boundBoxMin.x, h = base->boundBoxMax.y - base->boundBoxMin.y;
+	shared_ptr<LayerGeometry> geom(new LayerGeometry());
+	geom->shpType = base->shpType;
+	geom->boundBoxMin = base->boundBoxMin;
+	geom->boundBoxMax = vec2(base->boundBoxMin.x + w * copies, base->boundBoxMin.y + h * copies);
+	for (int cy = 0; cy < copies; cy++)
+		for (int cx = 0; cx < copies; cx++){
+			vec3 shift(cx * w, cy * h, 0);
+			for (int p = 0; p < base->getPartCount(); p++){
+				const vec3* v = base->getPart(p);
+				for (int i = 0; i < base->getPartSize(p); i++)
+					geom->points.push_back(v[i] + shift);
+				geom->partStart.push_back((unsigned int)geom->points.size());
+				geom->partShape.push_back(base->partShape[p]);
+				const vec4& b = base->partBounds[p];
+				geom->partBounds.push_back(vec4(b.x + shift.x, b.y + shift.y, b.z + shift.x, b.w + shift.y));
+			}
+		}
+	ShapeFile layer(geom, attrs);
+	printf("symbol benchmark: %s tiled %dx%d (%zu points, 1024x768)\n", basename.c_str(), copies, copies, geom->points.size());
+
+	long long t0 = Metrics::nowNs();
+	layer.setSymbols(SymbolAtlas::getDefault());
+	printf("  %-30s %9.2f ms (once per layer)\n", "symbol buffers built", (Metrics::nowNs() - t0) / 1e6);
+
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(layer.getBoundaries());
+	const double zooms[] = { 1, 8 };
+	for (size_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); z++){
+		camera.reset();
+		camera.zoomAt(512, 384, zooms[z]);
+		for (int symbols = 0; symbols < 2; symbols++){
+			layer.setSymbols(symbols ? SymbolAtlas::getDefault() : shared_ptr<const SymbolAtlas>());
+			DrawList list;
+			GLStateCache counter(false);
+			// first frame after a zoom, then a pan frame reusing the quads
+			double ms[2];
+			for (int f = 0; f < 2; f++){
+				if (f == 1)
+					camera.pan(3, 2);
+				long long t = Metrics::nowNs();
+				list.clear();
+				layer.addDrawItems(list, 0, camera.getView(), (float)camera.getWorldPerPixel());
+				list.finish();
+				ms[f] = (Metrics::nowNs() - t) / 1e6;
+			}
+			list.submit(counter);
+			RasterImage image;
+			image.resize(1024, 768);
+			double left, right, bottom, top;
+			camera.getOrtho(left, right, bottom, top);
+			SoftRenderer target(image, PixelRect(0, 0, 1024, 768), left, bottom, camera.getWorldPerPixel());
+			long long t = Metrics::nowNs();
+			layer.rasterize(target, camera.getView(), (float)camera.getWorldPerPixel());
+			double softMs = (Metrics::nowNs() - t) / 1e6;
+			char name[48];
+			sprintf(name, "zoom x%.0f, %s", zooms[z], symbols ? "symbols" : "dots");
+			printf("  %-30s GL list %7.2f ms (pan %6.2f), %6d items -> %d draw calls (%d one by one); software %7.2f ms\n",
+				name, ms[0], ms[1], list.getStats().items, list.getStats().batches, list.getStats().perEntityDrawCalls, softMs);
+		}
+	}
+	return 0;
+}
+
+/*
+	Wide strokes of a line layer at three zooms: mesh size and build time
+	(once per zoom bucket), the GL draw list from the cached mesh, the
+	software raster against the old square-stamped polylines, and a pan
+	through the layer cache against a from-scratch image.
+*/
+static int benchStroke(const string& basename){
+	shared_ptr<const LayerGeometry> geom = ShapeFile::load(basename.c_str());
+	if (!geom || geom->getPartCount() == 0)
+		return 1;
+	LayerHandle layer(new ShapeFile(geom));
+	vector<LayerHandle> layers(1, layer);
+	printf("stroke benchmark: %s (%d parts, %zu vertices, 1024x768)\n", basename.c_str(), geom->getPartCount(), geom->points.size());
+	printf("  %-24s %8s %10s %10s %8s %10s %10s %9s %9s\n", "style", "zoom", "triangles", "mesh MB", "mesh ms",
+		"list ms", "draws", "soft ms", "hairline");
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(layer->getBoundaries());
+	const char* joinNames[] = { "miter", "round", "bevel" };
+	const float widths[] = { 3, 8 };
+	const double zooms[] = { 1, 8, 64 };
+	for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+		for (int j = 0; j < 3; j++){
+			LayerStyle style = layer->getStyle();
+			style.strokeWidth = widths[w];
+			style.join = (LineJoin)j;
+			style.cap = j == JOIN_ROUND ? CAP_ROUND : CAP_BUTT;
+			for (size_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); z++){
+				layer->setStyle(style);
+				camera.reset();
+				camera.zoomAt(512, 384, zooms[z]);
+				vec4 view = camera.getView();
+				float scale = (float)camera.getWorldPerPixel();
+				// the first list builds the mesh, the second finds it cached
+				DrawList list;
+				long long t0 = Metrics::nowNs();
+				layer->addDrawItems(list, 0, view, scale);
+				long long t1 = Metrics::nowNs();
+				list.clear();
+				layer->addDrawItems(list, 0, view, scale);
+				list.finish();
+				long long t2 = Metrics::nowNs();
+				StrokeCache probe;
+				const StrokeMesh& mesh = probe.get(*geom, layer->getStyle(), 0, scale);
+
+				double left, right, bottom, top;
+				camera.getOrtho(left, right, bottom, top);
+				RasterImage image;
+				image.resize(1024, 768);
+				SoftRenderer target(image, PixelRect(0, 0, 1024, 768), left, bottom, scale);
+				long long t3 = Metrics::nowNs();
+				layer->rasterize(target, view, scale);
+				long long t4 = Metrics::nowNs();
+				// what the stamped polylines cost at the same width
+				for (int p = 0; p < geom->getPartCount(); p++)
+					target.drawPolyline(geom->getPart(p), geom->getPartSize(p), false, 0xff000000, (int)widths[w]);
+				long long t5 = Metrics::nowNs();
+
+				char name[32], zoom[16];
+				sprintf(name, "%.0f px, %s", widths[w], joinNames[j]);
+				sprintf(zoom, "x%.0f", zooms[z]);
+				printf("  %-24s %8s %10zu %10.2f %8.2f %10.2f %10d %9.2f %9.2f\n", name, zoom, mesh.indices.size() / 3,
+					(mesh.vertices.size() * sizeof(vec3) + mesh.indices.size() * sizeof(unsigned int)) / 1048576.0,
+					(t1 - t0) / 1e6, (t2 - t1) / 1e6, list.getStats().batches, (t4 - t3) / 1e6, (t5 - t4) / 1e6);
+			}
+		}
+
+	// panning a wide round stroke through the layer cache
+	LayerStyle style = layer->getStyle();
+	style.strokeWidth = 6;
+	style.join = JOIN_ROUND;
+	style.cap = CAP_ROUND;
+	layer->setStyle(style);
+	camera.reset();
+	camera.zoomAt(512, 384, 8);
+	LayerCompositor compositor;
+	compositor.compose(layers, camera);
+	for (int f = 0; f < 20; f++){
+		camera.pan(7, f % 2 ? 3 : -3);
+		compositor.compose(layers, camera);
+	}
+	LayerCompositor fresh;
+	long long diff = countDifferentPixels(fresh.compose(layers, camera), compositor.getFrame());
+	printf("  %-24s %lld pixels differ  %s\n", "panned vs from scratch", diff, diff ? "MISMATCH" : "ok");
+	return 0;
+}
+
+/*
+	Screen-space decimation of a line layer at several zooms: the vertices
+	left at 0.25, 0.5 and 1 pixel cells, the kernels' speed (and that the
+	vector one keeps what the scalar one keeps), and what dropping them
+	saves in the draw list and the software renderer. Ends with a pan
+	through the layer cache against a from-scratch image.
+*/
+static int benchDecimate(const string& basename){
+	shared_ptr<const LayerGeometry> geom = ShapeFile::load(basename.c_str());
+	if (!geom || geom->getPartCount() == 0)
+		return 1;
+	LayerHandle layer(new ShapeFile(geom));
+	vector<LayerHandle> layers(1, layer);
+	DecimateKernel scalar = decimateKernelFor(ISA_SCALAR), simd = decimateKernel();
+	printf("decimation benchmark: %s (%d parts, %zu vertices, 1024x768, %s kernel)\n", basename.c_str(),
+		geom->getPartCount(), geom->points.size(), kernelISAName(decodeKernels().isa));
+	printf("  %-6s %9s %8s %8s %8s %11s %11s %15s %15s\n", "zoom", "vertices", "0.25 px", "0.5 px", "1 px",
+		"scalar ns/v", "vector ns/v", "list ms 0/0.5", "soft ms 0/0.5");
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(layer->getBoundaries());
+	const double zooms[] = { 1, 4, 16, 64, 256 };
+	const float thresholds[] = { 0.25f, 0.5f, 1 };
+	vector<unsigned int> a(geom->points.size()), b(geom->points.size());
+	bool same = true;
+	for (size_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); z++){
+		camera.reset();
+		camera.zoomAt(512, 384, zooms[z]);
+		vec4 view = camera.getView();
+		float scale = (float)camera.getWorldPerPixel();
+		VisibleParts visible;
+		selectVisibleParts(*geom, view, scale, visible);
+		long long total = 0;
+		for (size_t i = 0; i < visible.detailed.size(); i++)
+			total += geom->getPartSize(visible.detailed[i]);
+
+		double kept[3];
+		for (int k = 0; k < 3; k++){
+			DecimateGrid grid;
+			long long n = 0;
+			if (!grid.make(layer->getBoundaries(), scale, thresholds[k]))
+				n = total;
+			else
+				for (size_t i = 0; i < visible.detailed.size(); i++){
+					int p = visible.detailed[i];
+					size_t ns = scalar(geom->getPart(p), geom->getPartSize(p), geom->partStart[p], grid, a.data());
+					size_t nv = simd(geom->getPart(p), geom->getPartSize(p), geom->partStart[p], grid, b.data());
+					same = same && ns == nv && equal(a.begin(), a.begin() + ns, b.begin());
+					n += ns;
+				}
+			kept[k] = total ? 100.0 * n / total : 0;
+		}
+
+		// kernel speed at 0.5 px, best of a few passes over the visible parts
+		DecimateGrid grid;
+		double kernelNs[2] = { 0, 0 };
+		if (grid.make(layer->getBoundaries(), scale, 0.5f) && total > 0)
+			for (int k = 0; k < 2; k++){
+				DecimateKernel kernel = k == 0 ? scalar : simd;
+				long long best = -1;
+				for (int run = 0; run < nRuns; run++){
+					long long t0 = Metrics::nowNs();
+					size_t sum = 0;
+					for (size_t i = 0; i < visible.detailed.size(); i++){
+						int p = visible.detailed[i];
+						sum += kernel(geom->getPart(p), geom->getPartSize(p), geom->partStart[p], grid, a.data());
+					}
+					long long t = Metrics::nowNs() - t0;
+					sink = (double)sum;
+					if (best < 0 || t < best)
+						best = t;
+				}
+				kernelNs[k] = (double)best / total;
+			}
+
+		// the draw list and the software renderer without and with it
+		double listMs[2], softMs[2];
+		double left, right, bottom, top;
+		camera.getOrtho(left, right, bottom, top);
+		for (int on = 0; on < 2; on++){
+			ShapeFile::setDecimation(on ? 0.5f : 0);
+			DrawList list;
+			long long t0 = Metrics::nowNs();
+			for (int f = 0; f < 10; f++){
+				list.clear();
+				layer->addDrawItems(list, 0, view, scale);
+				list.finish();
+			}
+			listMs[on] = (Metrics::nowNs() - t0) / 1e6 / 10;
+			RasterImage image;
+			image.resize(1024, 768);
+			SoftRenderer target(image, PixelRect(0, 0, 1024, 768), left, bottom, scale);
+			long long t1 = Metrics::nowNs();
+			layer->rasterize(target, view, scale);
+			softMs[on] = (Metrics::nowNs() - t1) / 1e6;
+		}
+		char name[16], list[32], soft[32];
+		sprintf(name, "x%.0f", zooms[z]);
+		sprintf(list, "%.2f / %.2f", listMs[0], listMs[1]);
+		sprintf(soft, "%.2f / %.2f", softMs[0], softMs[1]);
+		printf("  %-6s %9lld %7.1f%% %7.1f%% %7.1f%% %11.2f %11.2f %15s %15s\n", name, total, kept[0], kept[1], kept[2],
+			kernelNs[0], kernelNs[1], list, soft);
+	}
+	printf("  %-24s %s\n", "vector kernel vs scalar", same ? "same vertices  ok" : "MISMATCH");
+
+	// streaming speed: every vertex of the layer as one line, at the whole-map zoom
+	camera.reset();
+	DecimateGrid grid;
+	if (grid.make(layer->getBoundaries(), (float)camera.getWorldPerPixel(), 0.5f)){
+		double ns[2];
+		size_t n = geom->points.size(), nKept = 0;
+		for (int k = 0; k < 2; k++){
+			long long best = -1;
+			for (int run = 0; run < nRuns; run++){
+				long long t0 = Metrics::nowNs();
+				nKept = (k == 0 ? scalar : simd)(geom->points.data(), n, 0, grid, a.data());
+				long long t = Metrics::nowNs() - t0;
+				if (best < 0 || t < best)
+					best = t;
+			}
+			ns[k] = (double)best / n;
+		}
+		printf("  %-24s %.2f ns/vertex scalar, %.2f vector (%.1f%% kept)\n", "layer as one line", ns[0], ns[1], 100.0 * nKept / n);
+	}
+
+	ShapeFile::setDecimation(0.5f);
+	camera.reset();
+	camera.zoomAt(512, 384, 4);
+	LayerCompositor compositor;
+	compositor.compose(layers, camera);
+	for (int f = 0; f < 20; f++){
+		camera.pan(7, f % 2 ? 3 : -3);
+		compositor.compose(layers, camera);
+	}
+	LayerCompositor fresh;
+	long long diff = countDifferentPixels(fresh.compose(layers, camera), compositor.getFrame());
+	printf("  %-24s %lld pixels differ  %s\n", "panned vs from scratch", diff, diff ? "MISMATCH" : "ok");
+	return same && diff == 0 ? 0 : 1;
+}
+
+// Twice the signed area of a ring, by the shoelace formula.
+static double ringArea2(const vec3* v, int n){
+	double a = 0;
+	for (int i = 0, j = n - 1; i < n; j = i++)
+		a += ((double)v[j].x + v[i].x) * ((double)v[i].y - v[j].y);
+	return a;
+}
+
+static double pathLength(const vec3* v, int n, bool closed){
+	double len = 0;
+	for (int i = 1; i < n; i++)
+		len += hypot((double)v[i].x - v[i - 1].x, (double)v[i].y - v[i - 1].y);
+	if (closed && n > 2)
+		len += hypot((double)v[0].x - v[n - 1].x, (double)v[0].y - v[n - 1].y);
+	return len;
+}
+
+/*
+	Clipping: the outcode kernels over the whole layer, then the layer cut
+	into a grid of tiles at three levels, as tile generation would, with
+	polylines split by Liang-Barsky and polygon rings by Sutherland-Hodgman.
+	The pieces must stay in their tiles and add up to the layer: the same
+	length for lines, the same area for polygons. Last, the draw list and
+	the software renderer, which skip segments wholly off the view, at
+	three zooms, and a pan through the layer cache against a from-scratch
+	image.
+*/
+static int benchClip(const string& basename){
+	shared_ptr<const LayerGeometry> geom = ShapeFile::load(basename.c_str());
+	if (!geom || geom->getPartCount() == 0)
+		return 1;
+	const LayerGeometry& g = *geom;
+	bool polygons = g.shpType == SHPT_POLYGON || g.shpType == SHPT_POLYGONZ;
+	LayerHandle layer(new ShapeFile(geom));
+	vec4 bounds = layer->getBoundaries();
+	printf("clipping benchmark: %s (%s, %d parts, %zu vertices, %s kernel)\n", basename.c_str(), polygons ? "polygons" : "lines",
+		g.getPartCount(), g.points.size(), kernelISAName(decodeKernels().isa));
+	bool ok = true;
+
+	// outcodes against the middle quarter of the layer
+	vec4 mid(bounds.x + (bounds.z - bounds.x) * 0.25f, bounds.y + (bounds.w - bounds.y) * 0.25f,
+		bounds.x + (bounds.z - bounds.x) * 0.75f, bounds.y + (bounds.w - bounds.y) * 0.75f);
+	vector<unsigned char> a(g.points.size()), b(g.points.size());
+	double ns[2];
+	for (int k = 0; k < 2; k++){
+		OutcodeKernel kernel = k == 0 ? outcodeKernelFor(ISA_SCALAR) : outcodeKernel();
+		long long best = -1;
+		for (int run = 0; run < nRuns; run++){
+			long long t0 = Metrics::nowNs();
+			kernel(g.points.data(), g.points.size(), mid, (k == 0 ? a : b).data());
+			long long dt = Metrics::nowNs() - t0;
+			if (best < 0 || dt < best)
+				best = dt;
+		}
+		ns[k] = (double)best / g.points.size();
+	}
+	bool same = a == b;
+	ok = ok && same;
+	printf("  %-24s %.2f ns/vertex scalar, %.2f vector  %s\n", "outcodes", ns[0], ns[1], same ? "same codes  ok" : "MISMATCH");
+
+	// tiles
+	printf("  %-10s %8s %12s %12s %10s %10s %10s %12s\n", "tiles", "in", "out", "pieces", "ms", "Mv/s", "outside", "sum error");
+	double whole = 0;
+	for (int p = 0; p < g.getPartCount(); p++)
+		whole += polygons ? ringArea2(g.getPart(p), g.getPartSize(p)) : pathLength(g.getPart(p), g.getPartSize(p), false);
+	const int levels[] = { 4, 16, 64 };
+	vector<vec3> out;
+	vector<unsigned int> pieces;
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++){
+		int nTiles = levels[l];
+		double tw = (bounds.z - bounds.x) / nTiles, th = (bounds.w - bounds.y) / nTiles;
+		RectClipper clipper(bounds);
+		long long in = 0, nOut = 0, nPieces = 0, outside = 0;
+		double sum = 0, elapsed = 0;
+		for (int p = 0; p < g.getPartCount(); p++){
+			const vec4& pb = g.partBounds[p];
+			int tx0 = max(0, (int)((pb.x - bounds.x) / tw)), tx1 = min(nTiles - 1, (int)((pb.z - bounds.x) / tw));
+			int ty0 = max(0, (int)((pb.y - bounds.y) / th)), ty1 = min(nTiles - 1, (int)((pb.w - bounds.y) / th));
+			for (int ty = ty0; ty <= ty1; ty++)
+				for (int tx = tx0; tx <= tx1; tx++){
+					// neighbouring tiles share their edges exactly
+					vec4 tile((float)(bounds.x + tx * tw), (float)(bounds.y + ty * th),
+						tx + 1 == nTiles ? bounds.z : (float)(bounds.x + (tx + 1) * tw),
+						ty + 1 == nTiles ? bounds.w : (float)(bounds.y + (ty + 1) * th));
+					clipper.setRect(tile);
+					out.clear();
+					pieces.clear();
+					long long t0 = Metrics::nowNs();
+					int np;
+					if (polygons){
+						np = clipper.clipRing(g.getPart(p), g.getPartSize(p), out) ? 1 : 0;
+						if (np)
+							pieces.push_back(0);
+					}
+					else
+						np = clipper.clipPolyline(g.getPart(p), g.getPartSize(p), false, out, pieces);
+					elapsed += Metrics::nowNs() - t0;
+					in += g.getPartSize(p);
+					nOut += out.size();
+					nPieces += np;
+					float ex = (tile.z - tile.x) * 1e-5f, ey = (tile.w - tile.y) * 1e-5f;
+					for (size_t k = 0; k < out.size(); k++)
+						if (out[k].x < tile.x - ex || out[k].x > tile.z + ex || out[k].y < tile.y - ey || out[k].y > tile.w + ey)
+							outside++;
+					for (int k = 0; k < np; k++){
+						int begin = pieces[k], end = k + 1 < np ? pieces[k + 1] : (int)out.size();
+						sum += polygons ? ringArea2(&out[begin], end - begin) : pathLength(&out[begin], end - begin, false);
+					}
+				}
+		}
+		double error = fabs(sum - whole) / fabs(whole);
+		ok = ok && outside == 0 && error < 1e-4;
+		char name[16];
+		sprintf(name, "%dx%d", nTiles, nTiles);
+		printf("  %-10s %8lld %12lld %12lld %10.2f %10.1f %10lld %12.2e\n", name, in, nOut, nPieces, elapsed / 1e6,
+			in / (elapsed / 1e3), outside, error);
+	}
+
+	// the draw list and the software renderer
+	printf("  %-10s %12s %16s %10s\n", "view", "list ms", "segments cut", "soft ms");
+	Camera camera;
+	camera.setViewport(1024, 768);
+	camera.setWorld(bounds);
+	const double zooms[] = { 1, 8, 64 };
+	bool metrics = Metrics::isEnabled();
+	Metrics::setEnabled(true);
+	for (size_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); z++){
+		camera.reset();
+		camera.zoomAt(512, 384, zooms[z]);
+		vec4 view = camera.getView();
+		float scale = (float)camera.getWorldPerPixel();
+		long long cut0 = Metrics::counter(COUNTER_SEGMENTS_CLIPPED);
+		DrawList list;
+		long long t0 = Metrics::nowNs();
+		for (int f = 0; f < 10; f++){
+			list.clear();
+			layer->addDrawItems(list, 0, view, scale);
+			list.finish();
+		}
+		double listMs = (Metrics::nowNs() - t0) / 1e6 / 10;
+		long long cut = (Metrics::counter(COUNTER_SEGMENTS_CLIPPED) - cut0) / 10;
+		double left, right, bottom, top;
+		camera.getOrtho(left, right, bottom, top);
+		RasterImage image;
+		image.resize(1024, 768);
+		SoftRenderer target(image, PixelRect(0, 0, 1024, 768), left, bottom, scale);
+		long long t1 = Metrics::nowNs();
+		layer->rasterize(target, view, scale);
+		double softMs = (Metrics::nowNs() - t1) / 1e6;
+		char name[16];
+		sprintf(name, "zoom x%.0f", zooms[z]);
+		printf("  %-10s %12.2f %16lld %10.2f\n", name, listMs, cut, softMs);
+	}
+	Metrics::setEnabled(metrics);
+
+	vector<LayerHandle> layers(1, layer);
+	camera.reset();
+	camera.zoomAt(512, 384, 16);
+	LayerCompositor compositor;
+	compositor.compose(layers, camera);
+	for (int f = 0; f < 20; f++){
+		camera.pan(7, f % 2 ? 3 : -3);
+		compositor.compose(layers, camera);
+	}
+	LayerCompositor fresh;
+	long long diff = countDifferentPixels(fresh.compose(layers, camera), compositor.getFrame());
+	ok = ok && diff == 0;
+	printf("  %-24s %lld pixels differ  %s\n", "panned vs from scratch", diff, diff ? "MISMATCH" : "ok");
+	return ok ? 0 : 1;
+}
+
+/*
+	Last-level cache misses of this thread from the CPU's counters, where
+	the OS lets us read them (Linux perf events); read() is -1 elsewhere.
+*/
+class CacheMissCounter {
+public:
+	CacheMissCounter() : fd(-1){
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+	~CacheMissCounter(){
+#ifdef __linux__
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+	long long read() const{
+		long long n = -1;
+#ifdef __linux__
+		if (fd >= 0 && ::read(fd, &n, sizeof(n)) != sizeof(n))
+			n = -1;
+#endif
+		return n;
+	}
+
+private:
+	int fd;
+};
+
+// src's records (runs of parts with one partShape) copied in the given order.
+static void copyRecords(const LayerGeometry& src, const vector<int>& firstParts, LayerGeometry& dst){
+	dst.shpType = src.shpType;
+	dst.boundBoxMin = src.boundBoxMin;
+	dst.boundBoxMax = src.boundBoxMax;
+	dst.points.reserve(src.points.size());
+	for (size_t r = 0; r < firstParts.size(); r++)
+		for (int p = firstParts[r]; p < src.getPartCount() && (p == firstParts[r] || src.partShape[p] == src.partShape[p - 1]); p++){
+			dst.points.insert(dst.points.end(), src.points.begin() + src.partStart[p], src.points.begin() + src.partStart[p + 1]);
+			dst.partStart.push_back((unsigned int)dst.points.size());
+			dst.partShape.push_back(src.partShape[p]);
+			dst.partBounds.push_back(src.partBounds[p]);
+		}
+	buildBlockBounds(dst);
+}
+
+/*
+	Spatial ordering: the layer tiled to some million parts (well past the
+	caches), in three layouts: the file's record order, records shuffled,
+	and along a Hilbert curve. Each answers the same random viewports,
+	culling and then reading the vertices of what is visible, as drawing
+	does. Reported per query: time, cache misses when the CPU counters can
+	be read, and the 64 byte lines of vertex data touched and the separate
+	runs they come in, which is what the misses follow.
+*/
+static int benchHilbert(const string& basename){
+	shared_ptr<const LayerGeometry> base = ShapeFile::load(basename.c_str());
+	if (!base || base->getPartCount() == 0 || base->partBounds.empty())
+		return 1;
+	const int targetParts = 1000000;
+	int copies = 1;
+	while (copies * copies * base->getPartCount() < targetParts)
+		copies++;
+	float w = base->boundBoxMax.x - base->boundBoxMin.x, h = base->boundBoxMax.y - base->boundBoxMin.y;
+	LayerGeometry tiled;
+	tiled.shpType = base->shpType;
+	tiled.boundBoxMin = base->boundBoxMin;
+	tiled.boundBoxMax = vec2(base->boundBoxMin.x + w * copies, base->boundBoxMin.y + h * copies);
+	tiled.points.reserve(base->points.size() * copies * copies);
+	for (int cy = 0; cy < copies; cy++)
+		for (int cx = 0; cx < copies; cx++){
+			vec3 shift(cx * w, cy * h, 0);
+			int shapeBase = (cy * copies + cx) * (base->partShape.back() + 1);
+			for (int p = 0; p < base->getPartCount(); p++){
+				const vec3* v = base->getPart(p);
+				for (int i = 0; i < base->getPartSize(p); i++)
+					tiled.points.push_back(v[i] + shift);
+				tiled.partStart.push_back((unsigned int)tiled.points.size());
+				tiled.partShape.push_back(shapeBase + base->partShape[p]);
+				const vec4& b = base->partBounds[p];
+				tiled.partBounds.push_back(vec4(b.x + shift.x, b.y + shift.y, b.z + shift.x, b.w + shift.y));
+			}
+		}
+	buildBlockBounds(tiled);
+
+	// the records shuffled, and along the curve
+	vector<int> firstParts;
+	for (int p = 0; p < tiled.getPartCount(); p++)
+		if (p == 0 || tiled.partShape[p] != tiled.partShape[p - 1])
+			firstParts.push_back(p);
+	unsigned int seed = 12345;
+	for (size_t i = firstParts.size() - 1; i > 0; i--){
+		seed = seed * 1103515245u + 12345u;
+		swap(firstParts[i], firstParts[(seed >> 8) % (i + 1)]);
+	}
+	LayerGeometry shuffled;
+	copyRecords(tiled, firstParts, shuffled);
+	LayerGeometry hilbert = tiled;
+	long long t0 = Metrics::nowNs();
+	reorderAlongHilbert(hilbert);
+	double reorderMs = (Metrics::nowNs() - t0) / 1e6;
+
+	// the curve layout holds the same records with the same vertices
+	bool same = hilbert.points.size() == tiled.points.size() && hilbert.getPartCount() == tiled.getPartCount();
+	vector<int> firstTiled(tiled.partShape.back() + 1, -1), firstHilbert(firstTiled);
+	for (int p = tiled.getPartCount() - 1; p >= 0; p--){
+		firstTiled[tiled.partShape[p]] = p;
+		if (p < hilbert.getPartCount())
+			firstHilbert[hilbert.partShape[p]] = p;
+	}
+	for (int p = 0; same && p < tiled.getPartCount(); p++){
+		int shape = tiled.partShape[p];
+		int q = firstHilbert[shape] + (p - firstTiled[shape]); // the same part of the record
+		same = firstHilbert[shape] >= 0 && q < hilbert.getPartCount() && hilbert.partShape[q] == shape
+			&& hilbert.getPartSize(q) == tiled.getPartSize(p)
+			&& equal(tiled.getPart(p), tiled.getPart(p) + tiled.getPartSize(p), hilbert.getPart(q),
+				[](const vec3& a, const vec3& b){ return a.x == b.x && a.y == b.y; });
+	}
+
+	printf("spatial order benchmark: %s tiled %dx%d (%d parts, %zu vertices, %.1f MB of vertices)\n", basename.c_str(),
+		copies, copies, tiled.getPartCount(), tiled.points.size(), tiled.points.size() * sizeof(vec3) / 1048576.0);
+	printf("  %-24s %.1f ms, %s\n", "Hilbert reorder", reorderMs, same ? "same records and vertices  ok" : "MISMATCH");
+
+	// random viewports, 1/4 to 1/64 of the map across, 4:3
+	const int nViews = 400;
+	vector<vec4> views;
+	for (int i = 0; i < nViews; i++){
+		seed = seed * 1103515245u + 12345u;
+		float vw = w * copies / (float)(4 << ((seed >> 8) % 5));
+		seed = seed * 1103515245u + 12345u;
+		float cx = tiled.boundBoxMin.x + (seed >> 8) % 10000 / 10000.0f * w * copies;
+		seed = seed * 1103515245u + 12345u;
+		float cy = tiled.boundBoxMin.y + (seed >> 8) % 10000 / 10000.0f * h * copies;
+		views.push_back(vec4(cx - vw / 2, cy - vw * 3 / 8, cx + vw / 2, cy + vw * 3 / 8));
+	}
+	printf("  %-12s %10s %10s %14s %12s %10s\n", "layout", "parts", "query ms", "cache misses", "lines", "runs");
+	CacheMissCounter misses;
+	const LayerGeometry* layouts[] = { &tiled, &shuffled, &hilbert };
+	const char* names[] = { "file order", "shuffled", "Hilbert" };
+	VisibleParts visible;
+	vector<pair<unsigned int, unsigned int> > ranges;
+	for (int l = 0; l < 3; l++){
+		const LayerGeometry& g = *layouts[l];
+		long long parts = 0, elapsed = 0, missed = 0, lines = 0, runs = 0;
+		double sum = 0;
+		for (int v = 0; v < nViews; v++){
+			float minExtent = (views[v].z - views[v].x) / 1024;
+			long long m0 = misses.read();
+			long long q0 = Metrics::nowNs();
+			visible.clear();
+			selectVisibleParts(g, views[v], minExtent, visible);
+			for (size_t i = 0; i < visible.detailed.size(); i++){
+				const vec3* pv = g.getPart(visible.detailed[i]);
+				for (int k = 0; k < g.getPartSize(visible.detailed[i]); k++)
+					sum += pv[k].x + pv[k].y;
+			}
+			for (size_t i = 0; i < visible.dots.size(); i++)
+				sum += g.getPart(visible.dots[i])->x;
+			elapsed += Metrics::nowNs() - q0;
+			long long m1 = misses.read();
+			missed += m0 >= 0 && m1 >= 0 ? m1 - m0 : 0;
+			parts += visible.detailed.size() + visible.dots.size();
+
+			// vertex bytes read, as 64 byte lines, merged where parts adjoin
+			ranges.clear();
+			for (size_t i = 0; i < visible.detailed.size(); i++){
+				int p = visible.detailed[i];
+				ranges.push_back(make_pair((unsigned int)(g.partStart[p] * sizeof(vec3) / 64),
+					(unsigned int)((g.partStart[p + 1] * sizeof(vec3) - 1) / 64)));
+			}
+			for (size_t i = 0; i < visible.dots.size(); i++){
+				unsigned int line = (unsigned int)(g.partStart[visible.dots[i]] * sizeof(vec3) / 64);
+				ranges.push_back(make_pair(line, line));
+			}
+			sort(ranges.begin(), ranges.end());
+			for (size_t i = 0; i < ranges.size(); ){
+				unsigned int lo = ranges[i].first, hi = ranges[i].second;
+				for (i++; i < ranges.size() && ranges[i].first <= hi + 1; i++)
+					hi = max(hi, ranges[i].second);
+				lines += hi - lo + 1;
+				runs++;
+			}
+		}
+		sink = sum;
+		char missText[32];
+		if (misses.read() >= 0)
+			sprintf(missText, "%lld", missed / nViews);
+		else
+			sprintf(missText, "n/a");
+		printf("  %-12s %10lld %10.3f %14s %12lld %10lld\n", names[l], parts / nViews, elapsed / 1e6 / nViews, missText,
+			lines / nViews, runs / nViews);
+	}
+	if (misses.read() < 0)
+		printf("  (no hardware counters here: lines and runs stand in for the misses)\n");
+	return same ? 0 : 1;
+}
+
+/*
+	Input against a busy renderer: pans and zooms are posted every 4 ms to
+	a RenderThread, as the window would, and timed on the posting side
+	(what input handling pays) and until a published frame shows them.
+*/
+static int benchRender(const string& path){
+	MapSession session;
+	if (!session.open(path)){
+		cout << "Could not read session " << path << endl;
+		return 1;
+	}
+	LayerRegistry registry;
+	vector<LayerHandle> loaded = session.load();
+	if (loaded.empty())
+		return 1;
+	ViewCommand world = ViewCommand::make(VIEW_WORLD);
+	for (size_t i = 0; i < loaded.size(); i++){
+		registry.add(loaded[i]);
+		vec4 b = loaded[i]->getBoundaries();
+		world.world = i == 0 ? b : vec4(min(world.world.x, b.x), min(world.world.y, b.y), max(world.world.z, b.z), max(world.world.w, b.w));
+	}
+	printf("render thread benchmark: %s (%zu layers, 1024x768)\n", path.c_str(), loaded.size());
+
+	const double budgets[] = { 0, 8 };
+	for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++){
+		RenderThread renderer(registry);
+		renderer.post(ViewCommand::make(VIEW_RESIZE, 1024, 768));
+		renderer.post(world);
+		renderer.post(ViewCommand::make(VIEW_ZOOM, 512, 384, 2));
+		renderer.start(vec4(1, 1, 1, 1), budgets[b]);
+		unsigned int posted = 3;
+		while (renderer.getPublishedCommands() < posted)
+			this_thread::sleep_for(chrono::milliseconds(1));
+
+		const int nCommands = 300;
+		vector<long long> postedAt(nCommands + 1);
+		double postTotal = 0, postMax = 0, latTotal = 0, latMax = 0;
+		unsigned int seen = 0;
+		long long next = Metrics::nowNs();
+		for (int k = 0; k < nCommands; k++){
+			next += 4000000;
+			while (Metrics::nowNs() < next){
+				this_thread::sleep_for(chrono::microseconds(500));
+				for (unsigned int done = renderer.getPublishedCommands() - posted; seen < done && seen < (unsigned int)k; seen++){
+					double ms = (Metrics::nowNs() - postedAt[seen]) / 1e6;
+					latTotal += ms;
+					latMax = max(latMax, ms);
+				}
+			}
+			ViewCommand c = k % 25 == 24 ? ViewCommand::make(VIEW_ZOOM, 512, 384, (k / 25) % 2 ? 1.25 : 0.8)
+				: ViewCommand::make(VIEW_PAN, k % 2 ? 5 : -4, 3 - k % 7);
+			long long t0 = Metrics::nowNs();
+			renderer.post(c);
+			long long t1 = Metrics::nowNs();
+			postedAt[k] = t1;
+			postTotal += (t1 - t0) / 1e3;
+			postMax = max(postMax, (t1 - t0) / 1e3);
+		}
+		while (renderer.getPublishedCommands() - posted < (unsigned int)nCommands)
+			this_thread::sleep_for(chrono::microseconds(500));
+		for (; seen < (unsigned int)nCommands; seen++){
+			double ms = (Metrics::nowNs() - postedAt[seen]) / 1e6;
+			latTotal += ms;
+			latMax = max(latMax, ms);
+		}
+		renderer.stop();
+		printf("  budget %4.0f ms: post %6.2f us (max %6.2f), command to frame %6.2f ms (max %6.2f)\n",
+			budgets[b], postTotal / nCommands, postMax, latTotal / nCommands, latMax);
+	}
+	return 0;
+}
+
+int runBenchmark(const string& name, const string& basename){
+	Metrics::setEnabled(true);
+	if (name == "decode")
+		return benchDecode(basename);
+	if (name == "kernels")
+		return benchKernels(basename);
+	if (name == "shx")
+		return benchShx(basename);
+	if (name == "scan")
+		return benchScan(basename);
+	if (name == "reader")
+		return benchReader(basename);
+	if (name == "aio")
+		return benchAio(basename);
+	if (name == "dbf")
+		return benchDbf(basename);
+	if (name == "strings")
+		return benchStrings(basename);
+	if (name == "index")
+		return benchIndex(basename);
+	if (name == "names")
+		return benchNames(basename);
+	if (name == "session")
+		return benchSession(basename);
+	if (name == "view")
+		return benchView(basename);
+	if (name == "raster")
+		return benchRaster(basename);
+	if (name == "render")
+		return benchRender(basename);
+	if (name == "batching")
+		return benchBatching(basename);
+	if (name == "symbols")
+		return benchSymbols(basename);
+	if (name == "stroke")
+		return benchStroke(basename);
+	if (name == "decimate")
+		return benchDecimate(basename);
+	if (name == "clip")
+		return benchClip(basename);
+	if (name == "hilbert")
+		return benchHilbert(basename);
+	cout << "Unknown benchmark: " << name << endl;
+	cout << "Available: decode, kernels, shx, scan, reader, aio, dbf, strings, index, names, session, view, raster, render, batching, symbols, stroke, decimate, clip, hilbert" << endl;
+	return 1;
+}
@@ -0,0 +1,26 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef BENCHMARKS_H_DEF
+#define BENCHMARKS_H_DEF
+
+#include <string>
+
+using namespace std;
+
+/*
+	Console benchmarks, run with
+		GLRenderSHP -bench <name> <shapefile without extension>
+	No window is opened. Returns the process exit code.
+*/
+int runBenchmark(const string& name, const string& basename);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Camera.h"
+
+using namespace std;
+
+static const double maxZoomOut = 4.0;     // times the whole world
+static const double maxZoomIn = 100000.0;
+
+Camera::Camera() : world(-180, -90, 180, 90), width(1), height(1), centerX(0), centerY(0), scale(1), fitScale(1), revision(0){
+	reset();
+}
+
+void Camera::setWorld(const vec4& extent){
+	world = extent;
+	reset();
+}
+
+/*
+	Resizing keeps the centre and scale, so the map does not jump; the
+	fitted scale is redone for reset and the zoom limits.
+*/
+void Camera::setViewport(int w, int h){
+	width = w > 0 ? w : 1;
+	height = h > 0 ? h : 1;
+	double sx = ((double)world.z - world.x) / width;
+	double sy = ((double)world.w - world.y) / height;
+	fitScale = sx > sy ? sx : sy;
+	if (fitScale <= 0)
+		fitScale = 1;
+	clampScale();
+	revision++;
+}
+
+void Camera::reset(){
+	centerX = ((double)world.x + world.z) / 2;
+	centerY = ((double)world.y + world.w) / 2;
+	setViewport(width, height);
+	scale = fitScale;
+}
+
+void Camera::clampScale(){
+	if (scale > fitScale * maxZoomOut)
+		scale = fitScale * maxZoomOut;
+	if (scale < fitScale / maxZoomIn)
+		scale = fitScale / maxZoomIn;
+}
+
+void Camera::pan(double dx, double dy){
+	if (dx == 0 && dy == 0)
+		return;
+	centerX -= dx * scale;
+	centerY += dy * scale;
+	revision++;
+}
+
+void Camera::zoomAt(int x, int y, double factor){
+	double left, right, bottom, top;
+	getOrtho(left, right, bottom, top);
+	double px = left + (x + 0.5) * scale;
+	double py = top - (y + 0.5) * scale;
+	double old = scale;
+	scale /= factor;
+	clampScale();
+	centerX = px + (centerX - px) * (scale / old);
+	centerY = py + (centerY - py) * (scale / old);
+	revision++;
+}
+
+void Camera::getOrtho(double& left, double& right, double& bottom, double& top) const{
+	left = centerX - width * scale / 2;
+	right = centerX + width * scale / 2;
+	bottom = centerY - height * scale / 2;
+	top = centerY + height * scale / 2;
+}
+
+vec4 Camera::getView() const{
+	double left, right, bottom, top;
+	getOrtho(left, right, bottom, top);
+	return vec4((float)left, (float)bottom, (float)right, (float)top);
+}
@@ -0,0 +1,57 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef CAMERA_H_DEF
+#define CAMERA_H_DEF
+
+#include "Vectors.h"
+
+/*
+	2D view over the map: a centre and a scale (world units per pixel) for
+	a viewport of width x height pixels. The aspect ratio is kept, so the
+	world extent is fitted, not stretched. Positions are doubles; map
+	coordinates are too large for float steps at close zoom.
+	No GL here; the renderers take the view rectangle from getOrtho().
+*/
+class Camera {
+public:
+	Camera();
+
+	// Extent the view starts from and zooms back to.
+	void setWorld(const vec4& extent);
+	void setViewport(int width, int height);
+	void reset();
+
+	// Screen pixels, y down, as GLUT reports the mouse.
+	void pan(double dx, double dy);
+	// factor > 1 zooms in; the world point under (x, y) stays where it is.
+	void zoomAt(int x, int y, double factor);
+
+	void getOrtho(double& left, double& right, double& bottom, double& top) const;
+	vec4 getView() const; // (minX, minY, maxX, maxY)
+	double getWorldPerPixel() const { return scale; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	// Changes with every pan, zoom or resize.
+	unsigned int getRevision() const { return revision; }
+
+private:
+	vec4 world;
+	int width, height;
+	double centerX, centerY, scale;
+	double fitScale;
+	unsigned int revision;
+
+	void clampScale();
+};
+
+#endif
@@ -0,0 +1,274 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Clip.h"
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CLIP_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define CLIP_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+static inline unsigned char outcodeOf(float x, float y, const vec4& r){
+	return (unsigned char)((x < r.x ? OUT_LEFT : 0) | (x > r.z ? OUT_RIGHT : 0)
+		| (y < r.y ? OUT_BOTTOM : 0) | (y > r.w ? OUT_TOP : 0));
+}
+
+static void scalarOutcodes(const vec3* v, size_t n, const vec4& rect, unsigned char* codes){
+	for (size_t i = 0; i < n; i++)
+		codes[i] = outcodeOf(v[i].x, v[i].y, rect);
+}
+
+#ifdef CLIP_SSE2
+/*
+	4 vertices per step, deinterleaved as in Decimate.cpp. The four compares
+	give all-ones lanes that are masked to their bit and or-ed; two packs
+	narrow the 32 bit codes to the 4 bytes stored.
+*/
+static void sse2Outcodes(const vec3* v, size_t n, const vec4& rect, unsigned char* codes){
+	const __m128 minX = _mm_set1_ps(rect.x), minY = _mm_set1_ps(rect.y);
+	const __m128 maxX = _mm_set1_ps(rect.z), maxY = _mm_set1_ps(rect.w);
+	const __m128i left = _mm_set1_epi32(OUT_LEFT), right = _mm_set1_epi32(OUT_RIGHT);
+	const __m128i bottom = _mm_set1_epi32(OUT_BOTTOM), top = _mm_set1_epi32(OUT_TOP);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		const float* f = &v[i].x;
+		__m128 a = _mm_loadu_ps(f), b = _mm_loadu_ps(f + 4), c = _mm_loadu_ps(f + 8);
+		__m128 xa = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 0));
+		__m128 xb = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 x = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(2, 0, 1, 0));
+		__m128 ya = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		__m128 yb = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		__m128 y = _mm_shuffle_ps(ya, yb, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128i code = _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(x, minX)), left),
+				_mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, maxX)), right)),
+			_mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(y, minY)), bottom),
+				_mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y, maxY)), top)));
+		__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(code, code), code);
+		int packed = _mm_cvtsi128_si32(bytes);
+		memcpy(codes + i, &packed, 4);
+	}
+	scalarOutcodes(v + i, n - i, rect, codes + i);
+}
+#endif
+
+#ifdef CLIP_NEON
+// 4 vertices per step, vld3 splits x, y and z; two narrows make the bytes.
+static void neonOutcodes(const vec3* v, size_t n, const vec4& rect, unsigned char* codes){
+	const float32x4_t minX = vdupq_n_f32(rect.x), minY = vdupq_n_f32(rect.y);
+	const float32x4_t maxX = vdupq_n_f32(rect.z), maxY = vdupq_n_f32(rect.w);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		float32x4x3_t p = vld3q_f32(&v[i].x);
+		uint32x4_t code = vorrq_u32(
+			vorrq_u32(vandq_u32(vcltq_f32(p.val[0], minX), vdupq_n_u32(OUT_LEFT)),
+				vandq_u32(vcgtq_f32(p.val[0], maxX), vdupq_n_u32(OUT_RIGHT))),
+			vorrq_u32(vandq_u32(vcltq_f32(p.val[1], minY), vdupq_n_u32(OUT_BOTTOM)),
+				vandq_u32(vcgtq_f32(p.val[1], maxY), vdupq_n_u32(OUT_TOP))));
+		uint16x4_t half = vmovn_u32(code);
+		uint8x8_t bytes = vmovn_u16(vcombine_u16(half, half));
+		vst1_lane_u32((uint32_t*)(codes + i), vreinterpret_u32_u8(bytes), 0);
+	}
+	scalarOutcodes(v + i, n - i, rect, codes + i);
+}
+#endif
+
+OutcodeKernel outcodeKernelFor(KernelISA isa){
+	if (decodeKernelsFor(isa) == NULL)
+		return NULL;
+	switch (isa){
+	case ISA_SCALAR:
+		return scalarOutcodes;
+#ifdef CLIP_SSE2
+	case ISA_SSE2:
+	case ISA_AVX2:
+		return sse2Outcodes;
+#endif
+#ifdef CLIP_NEON
+	case ISA_NEON:
+		return neonOutcodes;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static OutcodeKernel selectKernel(){
+	OutcodeKernel k = outcodeKernelFor(decodeKernels().isa);
+	return k ? k : scalarOutcodes;
+}
+
+OutcodeKernel outcodeKernel(){
+	static const OutcodeKernel selected = selectKernel();
+	return selected;
+}
+
+/*
+	For each edge, the parameter where the line crosses it; entering
+	crossings raise t0, leaving ones lower t1.
+*/
+bool clipSegment(const vec3& a, const vec3& b, const vec4& rect, double& t0, double& t1){
+	double dx = (double)b.x - a.x, dy = (double)b.y - a.y;
+	double p[4] = { -dx, dx, -dy, dy };
+	double q[4] = { (double)a.x - rect.x, (double)rect.z - a.x, (double)a.y - rect.y, (double)rect.w - a.y };
+	t0 = 0;
+	t1 = 1;
+	for (int k = 0; k < 4; k++){
+		if (p[k] == 0){
+			if (q[k] < 0)
+				return false; // parallel to the edge and outside it
+			continue;
+		}
+		double t = q[k] / p[k];
+		if (p[k] < 0){
+			if (t > t1)
+				return false;
+			if (t > t0)
+				t0 = t;
+		}
+		else {
+			if (t < t0)
+				return false;
+			if (t < t1)
+				t1 = t;
+		}
+	}
+	return true;
+}
+
+static inline vec3 lerp(const vec3& a, const vec3& b, double t){
+	return vec3((float)(a.x + (b.x - a.x) * t), (float)(a.y + (b.y - a.y) * t), (float)(a.z + (b.z - a.z) * t));
+}
+
+int RectClipper::clipPolyline(const vec3* v, int n, bool closed, vector<vec3>& out, vector<unsigned int>& pieces){
+	if (n <= 0)
+		return 0;
+	codes.resize(n);
+	outcodeKernel()(v, n, rect, codes.data());
+	int nPieces = 0;
+	if (n == 1){
+		if (codes[0] == 0){
+			pieces.push_back((unsigned int)out.size());
+			out.push_back(v[0]);
+			nPieces++;
+		}
+		return nPieces;
+	}
+	int nSegments = closed && n > 2 ? n : n - 1;
+	bool open = false; // the last piece ends at the current vertex
+	for (int i = 0; i < nSegments; i++){
+		int j = i + 1 < n ? i + 1 : 0;
+		unsigned char ca = codes[i], cb = codes[j];
+		if (ca & cb){
+			open = false;
+			continue;
+		}
+		if ((ca | cb) == 0){
+			if (!open){
+				pieces.push_back((unsigned int)out.size());
+				out.push_back(v[i]);
+				nPieces++;
+			}
+			out.push_back(v[j]);
+			open = true;
+			continue;
+		}
+		double t0, t1;
+		if (!clipSegment(v[i], v[j], rect, t0, t1)){
+			open = false;
+			continue;
+		}
+		if (!open || ca != 0){
+			pieces.push_back((unsigned int)out.size());
+			out.push_back(ca ? lerp(v[i], v[j], t0) : v[i]);
+			nPieces++;
+		}
+		out.push_back(cb ? lerp(v[i], v[j], t1) : v[j]);
+		open = cb == 0;
+	}
+	return nPieces;
+}
+
+/*
+	One Sutherland–Hodgman stage: the ring in src against one edge of the
+	rectangle (axis 0 for x, 1 for y; keep the side >= bound when upper is
+	false, <= bound when true), into dst.
+*/
+static void clipAgainstEdge(const vector<vec3>& src, int axis, float bound, bool upper, vector<vec3>& dst){
+	dst.clear();
+	size_t n = src.size();
+	for (size_t i = 0; i < n; i++){
+		const vec3& a = src[i == 0 ? n - 1 : i - 1];
+		const vec3& b = src[i];
+		float ca = axis == 0 ? a.x : a.y, cb = axis == 0 ? b.x : b.y;
+		bool inA = upper ? ca <= bound : ca >= bound;
+		bool inB = upper ? cb <= bound : cb >= bound;
+		if (inA != inB){
+			vec3 p = lerp(a, b, ((double)bound - ca) / ((double)cb - ca));
+			// pin the crossing to the edge against rounding
+			if (axis == 0)
+				p.x = bound;
+			else
+				p.y = bound;
+			dst.push_back(p);
+		}
+		if (inB)
+			dst.push_back(b);
+	}
+}
+
+int RectClipper::clipRing(const vec3* v, int n, vector<vec3>& out){
+	if (n < 3)
+		return 0;
+	codes.resize(n);
+	outcodeKernel()(v, n, rect, codes.data());
+	unsigned char all = 15, any = 0;
+	for (int i = 0; i < n; i++){
+		all &= codes[i];
+		any |= codes[i];
+	}
+	if (all != 0)
+		return 0; // wholly off one side
+	if (any == 0){
+		out.insert(out.end(), v, v + n);
+		return n;
+	}
+	ringA.assign(v, v + n);
+	// only the edges some vertex lies beyond can cut
+	if (any & OUT_LEFT){
+		clipAgainstEdge(ringA, 0, rect.x, false, ringB);
+		ringA.swap(ringB);
+	}
+	if (any & OUT_RIGHT){
+		clipAgainstEdge(ringA, 0, rect.z, true, ringB);
+		ringA.swap(ringB);
+	}
+	if (any & OUT_BOTTOM){
+		clipAgainstEdge(ringA, 1, rect.y, false, ringB);
+		ringA.swap(ringB);
+	}
+	if (any & OUT_TOP){
+		clipAgainstEdge(ringA, 1, rect.w, true, ringB);
+		ringA.swap(ringB);
+	}
+	if (ringA.size() < 3)
+		return 0;
+	out.insert(out.end(), ringA.begin(), ringA.end());
+	return (int)ringA.size();
+}
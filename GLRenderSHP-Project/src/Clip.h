@@ -0,0 +1,84 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef CLIP_H_DEF
+#define CLIP_H_DEF
+
+#include "Vectors.h"
+#include "DecodeKernels.h"
+#include <vector>
+#include <stddef.h>
+
+using namespace std;
+
+// Cohen–Sutherland outcode bits: which sides of the rectangle a vertex lies beyond.
+enum Outcode {
+	OUT_LEFT = 1,
+	OUT_RIGHT = 2,
+	OUT_BOTTOM = 4,
+	OUT_TOP = 8
+};
+
+/*
+	Outcodes of v[0, n) against rect (minX, minY, maxX, maxY), one byte per
+	vertex. A segment whose ends share a bit lies wholly off that side; one
+	whose ends are both 0 lies wholly inside.
+*/
+typedef void (*OutcodeKernel)(const vec3* v, size_t n, const vec4& rect, unsigned char* codes);
+
+// The kernel for decodeKernels().isa; AVX2 uses the SSE2 one.
+OutcodeKernel outcodeKernel();
+// A given set, or NULL when it is not built in or not supported by the CPU.
+OutcodeKernel outcodeKernelFor(KernelISA isa);
+
+/*
+	Liang–Barsky: the part of a-b inside rect is a + t (b - a) for t in
+	[t0, t1]. False when the segment misses the rectangle.
+*/
+bool clipSegment(const vec3& a, const vec3& b, const vec4& rect, double& t0, double& t1);
+
+/*
+	Clipping of map geometry to a rectangle (a tile, a viewport), on the
+	flat vertex arrays of LayerGeometry. Outcodes, computed for a whole part
+	at once, accept and reject most segments; only those that cross an edge
+	are cut. Keeps its work buffers between calls, so one clipper per thread.
+*/
+class RectClipper {
+public:
+	RectClipper(const vec4& rect) : rect(rect) {}
+
+	const vec4& getRect() const { return rect; }
+	void setRect(const vec4& r) { rect = r; }
+
+	/*
+		A polyline (closed: a ring drawn as lines) split into the pieces that
+		lie inside: their vertices are appended to out and the index in out
+		where each one starts to pieces; a piece ends where the next starts,
+		the last at out.size(). Returns the number of pieces.
+	*/
+	int clipPolyline(const vec3* v, int n, bool closed, vector<vec3>& out, vector<unsigned int>& pieces);
+
+	/*
+		Sutherland–Hodgman: a polygon ring clipped to the rectangle, appended
+		to out; returns its vertex count, 0 when nothing is left. Rings of a
+		polygon with holes are clipped one by one: filled even-odd the results
+		are the clipped polygon, though a concave ring can come back with
+		edges running along the rectangle's border.
+	*/
+	int clipRing(const vec3* v, int n, vector<vec3>& out);
+
+private:
+	vec4 rect;
+	vector<unsigned char> codes;
+	vector<vec3> ringA, ringB;
+};
+
+#endif
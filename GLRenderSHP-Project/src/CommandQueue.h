@@ -0,0 +1,87 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef COMMANDQUEUE_H_DEF
+#define COMMANDQUEUE_H_DEF
+
+#include <atomic>
+#include <stddef.h>
+
+using namespace std;
+
+/*
+	Bounded lock-free queue for any number of producers and one consumer.
+	Every slot carries a sequence number: a producer claims a slot by
+	advancing tail with a compare-exchange, writes the value and publishes
+	it by bumping the slot's sequence; the consumer reads a slot once its
+	sequence says it is full and hands it back for the next lap. Nobody
+	waits on anybody: push() fails when the queue is full, pop() when it
+	is empty. Capacity must be a power of two.
+*/
+template <class T, size_t Capacity>
+class CommandQueue {
+public:
+	CommandQueue() : head(0), tail(0){
+		for (size_t i = 0; i < Capacity; i++)
+			slots[i].sequence.store(i, memory_order_relaxed);
+	}
+
+	bool push(const T& value){
+		size_t pos = tail.load(memory_order_relaxed);
+		for (;;){
+			Slot& s = slots[pos & (Capacity - 1)];
+			size_t seq = s.sequence.load(memory_order_acquire);
+			if (seq == pos){
+				if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+					s.value = value;
+					s.sequence.store(pos + 1, memory_order_release);
+					return true;
+				}
+			}
+			else if (seq < pos)
+				return false; // full: the consumer has not emptied this slot yet
+			else
+				pos = tail.load(memory_order_relaxed);
+		}
+	}
+
+	// Consumer thread only.
+	bool pop(T& value){
+		Slot& s = slots[head & (Capacity - 1)];
+		if (s.sequence.load(memory_order_acquire) != head + 1)
+			return false;
+		value = s.value;
+		s.sequence.store(head + Capacity, memory_order_release);
+		head++;
+		return true;
+	}
+
+	// Consumer thread only; a push may land right after.
+	bool empty() const {
+		return slots[head & (Capacity - 1)].sequence.load(memory_order_acquire) != head + 1;
+	}
+
+private:
+	struct Slot {
+		atomic<size_t> sequence;
+		T value;
+	};
+
+	Slot slots[Capacity];
+	size_t head;                  // consumer's
+	char pad[64];                 // keep the producers' counter off the consumer's cache line
+	atomic<size_t> tail;
+
+	CommandQueue(const CommandQueue&);
+	CommandQueue& operator=(const CommandQueue&);
+};
+
+#endif
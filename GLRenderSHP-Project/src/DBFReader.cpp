@@ -0,0 +1,337 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "DBFReader.h"
+#include "Metrics.h"
+#include "AsyncIO.h"
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+// SSE2 is part of every x64 target, so no runtime dispatch is needed here
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DBF_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+int DBFSchema::findField(const string& name) const{
+	for (size_t i = 0; i < fields.size(); i++){
+		const string& f = fields[i].name;
+		if (f.size() != name.size())
+			continue;
+		size_t j = 0;
+		while (j < f.size() && toupper((unsigned char)f[j]) == toupper((unsigned char)name[j]))
+			j++;
+		if (j == f.size())
+			return (int)i;
+	}
+	return -1;
+}
+
+bool DBFSchema::parse(const unsigned char* header, size_t len, DBFSchema& out){
+	if (len < 32)
+		return false;
+	out.nRecords = (int)(header[4] | (header[5] << 8) | (header[6] << 16) | ((unsigned int)header[7] << 24));
+	out.headerLength = header[8] | (header[9] << 8);
+	out.recordLength = header[10] | (header[11] << 8);
+	out.languageDriver = header[29];
+	if (out.nRecords < 0 || out.headerLength < 32 || out.recordLength < 1 || (size_t)out.headerLength > len)
+		return false;
+
+	out.fields.clear();
+	int nFields = (out.headerLength - 32) / 32;
+	for (int i = 0; i < nFields; i++)
+		if (header[32 + i * 32] == 0x0d){ // header terminator
+			nFields = i;
+			break;
+		}
+	/*
+		Character fields over 255 bytes keep the high byte of their width in
+		the decimals byte. Other writers leave a formatting hint there, so it
+		only counts when the widths then add up to the record length.
+	*/
+	int narrow = 1, wide = 1;
+	for (int i = 0; i < nFields; i++){
+		const unsigned char* info = header + 32 + i * 32;
+		narrow += info[16];
+		wide += info[16] + (info[11] == 'C' ? info[17] * 256 : 0);
+	}
+	bool wideChars = wide != narrow && wide == out.recordLength;
+
+	int offset = 1; // deletion flag
+	for (int i = 0; i < nFields; i++){
+		const unsigned char* info = header + 32 + i * 32;
+		DBFField f;
+		char name[12];
+		memcpy(name, info, 11);
+		name[11] = '\0';
+		f.name = name;
+		f.type = (char)info[11];
+		f.width = info[16] + (wideChars && f.type == 'C' ? info[17] * 256 : 0);
+		f.decimals = (f.type == 'N' || f.type == 'F') ? info[17] : 0;
+		f.offset = offset;
+		offset += f.width;
+		if (offset > out.recordLength)
+			return false;
+		out.fields.push_back(f);
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Numbers
+////////////////////////////////////////////////////////////////////////////////
+
+static const double powersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+	Eight ASCII digits at once: subtract '0', then pairwise multiply-add
+	(d0*10+d1, then *100, then *10000). Returns false if any byte is not a digit.
+*/
+static inline bool parse8Digits(const char* p, unsigned int& value){
+#ifdef DBF_SSE2
+	__m128i d = _mm_sub_epi8(_mm_loadl_epi64((const __m128i*)p), _mm_set1_epi8('0'));
+	__m128i bad = _mm_or_si128(_mm_cmplt_epi8(d, _mm_setzero_si128()), _mm_cmpgt_epi8(d, _mm_set1_epi8(9)));
+	if ((_mm_movemask_epi8(bad) & 0xff) != 0)
+		return false;
+	__m128i d16 = _mm_unpacklo_epi8(d, _mm_setzero_si128());
+	__m128i pairs = _mm_madd_epi16(d16, _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1));
+	__m128i quads = _mm_madd_epi16(_mm_packs_epi32(pairs, pairs), _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+	value = (unsigned int)_mm_cvtsi128_si32(quads) * 10000 + (unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(quads, 4));
+	return true;
+#else
+	unsigned int v = 0;
+	for (int i = 0; i < 8; i++){
+		unsigned int d = (unsigned int)(p[i] - '0');
+		if (d > 9)
+			return false;
+		v = v * 10 + d;
+	}
+	value = v;
+	return true;
+#endif
+}
+
+/*
+	Appends the digit run at p to mantissa. Digits past the 19th no longer fit
+	and only scale the value (dropped).
+*/
+static const char* parseDigits(const char* p, const char* end, unsigned long long& mantissa,
+	int& nDigits, int& dropped){
+	while (end - p >= 8 && nDigits + 8 <= 19){
+		unsigned int v;
+		if (!parse8Digits(p, v))
+			break;
+		if (mantissa == 0) // leading zeros are not significant
+			for (unsigned int r = v; r != 0; r /= 10)
+				nDigits++;
+		else
+			nDigits += 8;
+		mantissa = mantissa * 100000000ull + v;
+		p += 8;
+	}
+	for (; p < end && (unsigned int)(*p - '0') <= 9; p++){
+		if (nDigits < 19){
+			mantissa = mantissa * 10 + (unsigned int)(*p - '0');
+			if (mantissa != 0)
+				nDigits++;
+		}
+		else
+			dropped++;
+	}
+	return p;
+}
+
+// strtod with '.' as the separator whatever LC_NUMERIC the host program set.
+static double strtodC(const char* text){
+#ifdef _WIN32
+	static _locale_t cLocale = _create_locale(LC_NUMERIC, "C");
+	return _strtod_l(text, NULL, cLocale);
+#else
+	static locale_t cLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+	return strtod_l(text, NULL, cLocale);
+#endif
+}
+
+bool parseDBFNumber(const char* field, int width, double& out){
+	const char* p = field;
+	const char* end = field + width;
+	while (p < end && (*p == ' ' || *p == '\0'))
+		p++;
+	while (end > p && (end[-1] == ' ' || end[-1] == '\0'))
+		end--;
+	out = 0.0;
+	if (p == end)
+		return false;
+	const char* start = p;
+
+	bool negative = false;
+	if (*p == '-' || *p == '+'){
+		negative = (*p == '-');
+		p++;
+	}
+	unsigned long long mantissa = 0;
+	int nDigits = 0, dropped = 0, fraction = 0;
+	p = parseDigits(p, end, mantissa, nDigits, dropped);
+	int exponent = dropped;
+	if (p < end && *p == '.'){
+		const char* f = p + 1;
+		int droppedBefore = dropped;
+		p = parseDigits(f, end, mantissa, nDigits, dropped);
+		// fraction digits that did not fit are simply lost, they do not scale
+		fraction = (int)(p - f) - (dropped - droppedBefore);
+	}
+	exponent -= fraction;
+	if (p < end && (*p == 'e' || *p == 'E')){
+		p++;
+		bool expNegative = false;
+		if (p < end && (*p == '-' || *p == '+')){
+			expNegative = (*p == '-');
+			p++;
+		}
+		int e = 0;
+		for (; p < end && (unsigned int)(*p - '0') <= 9; p++)
+			if (e < 10000)
+				e = e * 10 + (*p - '0');
+		exponent += expNegative ? -e : e;
+	}
+
+	// both operands exact: one correctly rounded operation, same result as strtod
+	if (mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22){
+		double v = (double)mantissa;
+		if (exponent < 0)
+			v /= powersOf10[-exponent];
+		else
+			v *= powersOf10[exponent];
+		out = negative ? -v : v;
+		return true;
+	}
+	// more than 15-16 significant digits or a large exponent: rare, leave it to strtod
+	char copy[256];
+	size_t len = (size_t)(end - start) < sizeof(copy) - 1 ? (size_t)(end - start) : sizeof(copy) - 1;
+	memcpy(copy, start, len);
+	copy[len] = '\0';
+	out = strtodC(copy);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// DBFReader
+////////////////////////////////////////////////////////////////////////////////
+
+DBFReader::DBFReader() : blockSize(4 << 20), readAheadBlocks(4){
+	schema.nRecords = schema.headerLength = schema.recordLength = schema.languageDriver = 0;
+}
+
+bool DBFReader::open(const string& basename){
+	if (!file.open((basename + ".dbf").c_str()) && !file.open((basename + ".DBF").c_str()))
+		return false;
+	unsigned char start[32];
+	if (file.readAt(0, start, 32) != 32)
+		return false;
+	size_t headerLength = start[8] | (start[9] << 8);
+	if (headerLength < 32)
+		return false;
+	vector<unsigned char> header(headerLength);
+	if (file.readAt(0, &header[0], headerLength) != headerLength)
+		return false;
+	return DBFSchema::parse(&header[0], headerLength, schema);
+}
+
+bool DBFReader::readNumericColumn(int field, int first, int count, double* out, unsigned char* nulls) const{
+	return readNumericColumns(&field, 1, first, count, &out, nulls ? &nulls : NULL);
+}
+
+bool DBFReader::readNumericColumns(const int* fields, int nFields, int first, int count,
+	double* const* out, unsigned char* const* nulls) const{
+	if (first < 0 || count < 0 || first + count > schema.nRecords)
+		return false;
+	for (int k = 0; k < nFields; k++)
+		if (fields[k] < 0 || fields[k] >= (int)schema.fields.size())
+			return false;
+	ScopedTimer timer(PHASE_DBF_READ);
+
+	size_t recordLength = (size_t)schema.recordLength;
+	size_t perBlock = blockSize / recordLength;
+	if (perBlock == 0)
+		perBlock = 1;
+	if (perBlock > (size_t)count)
+		perBlock = (size_t)count;
+	int nBlocks = (int)((count + perBlock - 1) / perBlock);
+	int depth = nBlocks < readAheadBlocks ? nBlocks : readAheadBlocks;
+	if (depth < 1)
+		return true;
+
+	// up to depth blocks are read at once; each is parsed when its read
+	// completes, and its slot reused for the next block
+	vector<unsigned char> buffers((size_t)depth * perBlock * recordLength);
+	vector<int> slotBlock(depth);
+	AsyncReader* aio = depth > 1 ? new AsyncReader(depth, depth) : NULL;
+	int next = 0, parsed = 0;
+	bool ok = true;
+	while (parsed < nBlocks){
+		IORequest r;
+		if (aio){
+			for (; ok && next < nBlocks && aio->getInFlight() < depth; next++){
+				int slot = next % depth;
+				int n = (count - next * (int)perBlock < (int)perBlock) ? count - next * (int)perBlock : (int)perBlock;
+				IORequest q = { &file, (FileOffset)schema.headerLength + (FileOffset)(first + next * (int)perBlock) * recordLength,
+					&buffers[(size_t)slot * perBlock * recordLength], (size_t)n * recordLength, 0, (void*)(size_t)slot };
+				slotBlock[slot] = next;
+				aio->submit(q);
+			}
+			if (!aio->wait(r))
+				break;
+		}
+		else {
+			int n = (count - next * (int)perBlock < (int)perBlock) ? count - next * (int)perBlock : (int)perBlock;
+			r.offset = (FileOffset)schema.headerLength + (FileOffset)(first + next * (int)perBlock) * recordLength;
+			r.dst = &buffers[0];
+			r.len = (size_t)n * recordLength;
+			r.result = file.readAt(r.offset, r.dst, r.len);
+			r.user = (void*)(size_t)0;
+			slotBlock[0] = next++;
+		}
+		parsed++;
+		if (r.result != r.len){
+			ok = false; // the reads still in flight are drained before leaving
+			if (aio == NULL)
+				break;
+			continue;
+		}
+		if (!ok)
+			continue;
+		int done = slotBlock[(int)(size_t)r.user] * (int)perBlock;
+		int n = (int)(r.len / recordLength);
+		for (int k = 0; k < nFields; k++){
+			const DBFField& f = schema.fields[fields[k]];
+			const char* cell = (const char*)r.dst + f.offset;
+			double* o = out[k] + done;
+			unsigned char* isNull = nulls ? nulls[k] + done : NULL;
+			for (int i = 0; i < n; i++, cell += recordLength){
+				bool present = parseDBFNumber(cell, f.width, o[i]);
+				if (isNull)
+					isNull[i] = present ? 0 : 1;
+			}
+		}
+	}
+	delete aio;
+	return ok && parsed == nBlocks;
+}
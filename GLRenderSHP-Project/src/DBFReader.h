@@ -0,0 +1,86 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef DBFREADER_H_DEF
+#define DBFREADER_H_DEF
+
+#include "FileIO.h"
+#include <vector>
+#include <string>
+
+using namespace std;
+
+struct DBFField {
+	string name;
+	char type;     // 'C', 'N', 'F', 'D', 'L'
+	int width;
+	int decimals;
+	int offset;    // within the record, after the deletion flag
+};
+
+/*
+	The .dbf header: record geometry and field layout, as DBFOpenLL reads it.
+*/
+struct DBFSchema {
+	int nRecords;
+	int headerLength;
+	int recordLength;
+	int languageDriver; // LDID, header byte 29
+	vector<DBFField> fields;
+
+	// Case-insensitive, as DBFGetFieldIndex. Returns -1 if not found.
+	int findField(const string& name) const;
+
+	// Parses the first 32 bytes plus the field descriptors.
+	static bool parse(const unsigned char* header, size_t len, DBFSchema& out);
+};
+
+/*
+	Parses a fixed-width numeric field: blanks around, optional sign, digits,
+	'.', exponent. Always '.' as separator, whatever the C locale.
+	Returns false for a blank field (out = 0, as DBFReadDoubleAttribute).
+*/
+bool parseDBFNumber(const char* field, int width, double& out);
+
+/*
+	Column-at-a-time access to a .dbf. Records are read in large sequential
+	blocks and only the requested fields are parsed, instead of one
+	DBFLoadRecord seek/read and one atof per cell.
+*/
+class DBFReader {
+public:
+	DBFReader();
+
+	bool open(const string& basename); // tries .dbf, then .DBF
+	const DBFSchema& getSchema() const { return schema; }
+	int getRecordCount() const { return schema.nRecords; }
+	void setBlockSize(size_t bytes) { blockSize = bytes; }
+	// blocks kept in flight through an AsyncReader; 1 reads them one by one
+	void setReadAhead(int blocks) { readAheadBlocks = blocks < 1 ? 1 : blocks; }
+
+	/*
+		Numeric values of nFields fields for records [first, first + count):
+		out[k][i] is field fields[k] of record first + i. When nulls is given,
+		nulls[k][i] is set to 1 for blank fields. Returns false on a read error
+		or a bad field/record range.
+	*/
+	bool readNumericColumns(const int* fields, int nFields, int first, int count,
+		double* const* out, unsigned char* const* nulls = NULL) const;
+	bool readNumericColumn(int field, int first, int count, double* out, unsigned char* nulls = NULL) const;
+
+private:
+	PosFile file;
+	DBFSchema schema;
+	size_t blockSize;
+	int readAheadBlocks;
+};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Decimate.h"
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DECIMATE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define DECIMATE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+bool DecimateGrid::make(const vec4& bounds, float worldPerPixel, float thresholdPx){
+	if (thresholdPx <= 0 || worldPerPixel <= 0)
+		return false;
+	double inv = 1.0 / ((double)thresholdPx * worldPerPixel);
+	double extent = max(bounds.z - bounds.x, bounds.w - bounds.y);
+	if (extent * inv > 1e9)
+		return false;
+	originX = bounds.x;
+	originY = bounds.y;
+	invCell = (float)inv;
+	return true;
+}
+
+/*
+	Vertices left of or below the origin (bounds rounded on the way to float)
+	truncate into cell 0 with those just inside it, which only keeps a vertex
+	fewer.
+*/
+static inline int cellOf(float v, float origin, float inv){
+	return (int)((v - origin) * inv);
+}
+
+// Vertices [begin, n) against the cell of v[begin - 1]; appends to out.
+static size_t scalarTail(const vec3* v, size_t begin, size_t n, unsigned int first, const DecimateGrid& g,
+	unsigned int* out, size_t kept){
+	int px = cellOf(v[begin - 1].x, g.originX, g.invCell), py = cellOf(v[begin - 1].y, g.originY, g.invCell);
+	for (size_t i = begin; i < n; i++){
+		int cx = cellOf(v[i].x, g.originX, g.invCell), cy = cellOf(v[i].y, g.originY, g.invCell);
+		if (cx != px || cy != py)
+			out[kept++] = first + (unsigned int)i;
+		px = cx;
+		py = cy;
+	}
+	return kept;
+}
+
+// The first vertex is always drawn, the last too so the line ends where it should.
+static size_t finishPath(size_t n, unsigned int first, unsigned int* out, size_t kept){
+	if (out[kept - 1] != first + (unsigned int)(n - 1))
+		out[kept++] = first + (unsigned int)(n - 1);
+	return kept;
+}
+
+static size_t scalarDecimate(const vec3* v, size_t n, unsigned int first, const DecimateGrid& g, unsigned int* out){
+	if (n == 0)
+		return 0;
+	out[0] = first;
+	return finishPath(n, first, out, scalarTail(v, 1, n, first, g, out, 1));
+}
+
+/*
+	The vector loops write the vertices a 4 bit keep mask selects without
+	branching: all four slots are stored, the kept lanes packed first, and
+	the count moves on by how many there were. The slots past the count are
+	overwritten later or lie beyond the result; they never pass out[n - 1],
+	since at step i at most i vertices have been kept.
+*/
+static const unsigned char keptLanes[16][5] = { // lanes, then their number
+	{ 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 1 }, { 1, 0, 0, 0, 1 }, { 0, 1, 0, 0, 2 },
+	{ 2, 0, 0, 0, 1 }, { 0, 2, 0, 0, 2 }, { 1, 2, 0, 0, 2 }, { 0, 1, 2, 0, 3 },
+	{ 3, 0, 0, 0, 1 }, { 0, 3, 0, 0, 2 }, { 1, 3, 0, 0, 2 }, { 0, 1, 3, 0, 3 },
+	{ 2, 3, 0, 0, 2 }, { 0, 2, 3, 0, 3 }, { 1, 2, 3, 0, 3 }, { 0, 1, 2, 3, 4 }
+};
+
+static inline size_t storeKept(unsigned int* out, size_t kept, unsigned int base, unsigned int mask){
+	const unsigned char* l = keptLanes[mask];
+	out[kept] = base + l[0];
+	out[kept + 1] = base + l[1];
+	out[kept + 2] = base + l[2];
+	out[kept + 3] = base + l[3];
+	return kept + l[4];
+}
+
+#ifdef DECIMATE_SSE2
+/*
+	4 vertices per step. The 48 bytes of four vec3 are three loads,
+	a = [x0 y0 z0 x1], b = [y1 z1 x2 y2], c = [z2 x3 y3 z3], shuffled into
+	x and y. Each vertex's cell is compared with the one before it, the
+	previous step's last cell shifted in at the bottom; the compare mask says
+	which to keep.
+*/
+static size_t sse2Decimate(const vec3* v, size_t n, unsigned int first, const DecimateGrid& g, unsigned int* out){
+	if (n == 0)
+		return 0;
+	out[0] = first;
+	size_t kept = 1;
+	const __m128 ox = _mm_set1_ps(g.originX), oy = _mm_set1_ps(g.originY), inv = _mm_set1_ps(g.invCell);
+	__m128i prevX = _mm_set1_epi32(cellOf(v[0].x, g.originX, g.invCell));
+	__m128i prevY = _mm_set1_epi32(cellOf(v[0].y, g.originY, g.invCell));
+	size_t i = 1;
+	for (; i + 4 <= n; i += 4){
+		const float* f = &v[i].x;
+		__m128 a = _mm_loadu_ps(f), b = _mm_loadu_ps(f + 4), c = _mm_loadu_ps(f + 8);
+		__m128 xa = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 0));  // [x0 x1 . .]
+		__m128 xb = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));  // [x2 . x3 .]
+		__m128 x = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(2, 0, 1, 0));
+		__m128 ya = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));  // [y0 . y1 .]
+		__m128 yb = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));  // [y2 . y3 .]
+		__m128 y = _mm_shuffle_ps(ya, yb, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128i cx = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(x, ox), inv));
+		__m128i cy = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(y, oy), inv));
+		// [prev c0 c1 c2]: the cells of the vertices before these
+		__m128i bx = _mm_or_si128(_mm_slli_si128(cx, 4), _mm_srli_si128(prevX, 12));
+		__m128i by = _mm_or_si128(_mm_slli_si128(cy, 4), _mm_srli_si128(prevY, 12));
+		__m128i same = _mm_and_si128(_mm_cmpeq_epi32(cx, bx), _mm_cmpeq_epi32(cy, by));
+		unsigned int moved = ~_mm_movemask_ps(_mm_castsi128_ps(same)) & 15;
+		kept = storeKept(out, kept, first + (unsigned int)i, moved);
+		prevX = cx;
+		prevY = cy;
+	}
+	if (i < n)
+		kept = scalarTail(v, i, n, first, g, out, kept);
+	return finishPath(n, first, out, kept);
+}
+#endif
+
+#ifdef DECIMATE_NEON
+// 4 vertices per step, vld3 splits x, y and z.
+static size_t neonDecimate(const vec3* v, size_t n, unsigned int first, const DecimateGrid& g, unsigned int* out){
+	if (n == 0)
+		return 0;
+	out[0] = first;
+	size_t kept = 1;
+	const float32x4_t ox = vdupq_n_f32(g.originX), oy = vdupq_n_f32(g.originY);
+	static const uint32_t bitValues[4] = { 1, 2, 4, 8 };
+	const uint32x4_t bits = vld1q_u32(bitValues);
+	int32x4_t prevX = vdupq_n_s32(cellOf(v[0].x, g.originX, g.invCell));
+	int32x4_t prevY = vdupq_n_s32(cellOf(v[0].y, g.originY, g.invCell));
+	size_t i = 1;
+	for (; i + 4 <= n; i += 4){
+		float32x4x3_t p = vld3q_f32(&v[i].x);
+		int32x4_t cx = vcvtq_s32_f32(vmulq_n_f32(vsubq_f32(p.val[0], ox), g.invCell));
+		int32x4_t cy = vcvtq_s32_f32(vmulq_n_f32(vsubq_f32(p.val[1], oy), g.invCell));
+		uint32x4_t same = vandq_u32(vceqq_s32(cx, vextq_s32(prevX, cx, 3)), vceqq_s32(cy, vextq_s32(prevY, cy, 3)));
+		unsigned int moved = vaddvq_u32(vbicq_u32(bits, same));
+		kept = storeKept(out, kept, first + (unsigned int)i, moved);
+		prevX = cx;
+		prevY = cy;
+	}
+	if (i < n)
+		kept = scalarTail(v, i, n, first, g, out, kept);
+	return finishPath(n, first, out, kept);
+}
+#endif
+
+DecimateKernel decimateKernelFor(KernelISA isa){
+	if (decodeKernelsFor(isa) == NULL)
+		return NULL;
+	switch (isa){
+	case ISA_SCALAR:
+		return scalarDecimate;
+#ifdef DECIMATE_SSE2
+	case ISA_SSE2:
+	case ISA_AVX2:
+		return sse2Decimate;
+#endif
+#ifdef DECIMATE_NEON
+	case ISA_NEON:
+		return neonDecimate;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static DecimateKernel selectKernel(){
+	DecimateKernel k = decimateKernelFor(decodeKernels().isa);
+	return k ? k : scalarDecimate;
+}
+
+DecimateKernel decimateKernel(){
+	static const DecimateKernel selected = selectKernel();
+	return selected;
+}
@@ -0,0 +1,53 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef DECIMATE_H_DEF
+#define DECIMATE_H_DEF
+
+#include "Vectors.h"
+#include "DecodeKernels.h"
+#include <stddef.h>
+
+using namespace std;
+
+/*
+	Square cells of the threshold's size on screen, anchored at a corner of
+	the layer rather than of the view, so panning keeps the same vertices and
+	a strip of an image draws as the whole image does.
+*/
+struct DecimateGrid {
+	float originX, originY;
+	float invCell; // cells per world unit
+
+	/*
+		Cells of thresholdPx pixels over bounds (minX, minY, maxX, maxY).
+		False when thresholdPx <= 0 or when the cells are so small that their
+		numbers would not fit an int: at that zoom nothing would be dropped.
+	*/
+	bool make(const vec4& bounds, float worldPerPixel, float thresholdPx);
+};
+
+/*
+	Screen-space decimation of a polyline, in one pass and without any
+	preprocessing: writes to out the indices (first + i) of the vertices of
+	v[0, n) to draw, which are the first, every vertex in another cell than
+	the one before it, and the last. A dropped vertex shares a cell with the
+	last one kept, so the line moves by less than a cell's diagonal.
+	Returns the count; out has room for n.
+*/
+typedef size_t (*DecimateKernel)(const vec3* v, size_t n, unsigned int first, const DecimateGrid& grid, unsigned int* out);
+
+// The kernel for decodeKernels().isa; AVX2 gains nothing over SSE2 here and uses it.
+DecimateKernel decimateKernel();
+// A given set, or NULL when it is not built in or not supported by the CPU.
+DecimateKernel decimateKernelFor(KernelISA isa);
+
+#endif
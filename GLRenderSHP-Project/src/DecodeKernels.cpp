@@ -0,0 +1,561 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "DecodeKernels.h"
+#include "ShapeDecode.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mutex>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang only emit AVX2 code in functions that ask for it; MSVC always can.
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+using namespace std;
+
+static void mergeBounds(CoordBounds* b, double minX, double minY, double maxX, double maxY){
+	if (b == NULL)
+		return;
+	if (minX < b->minX) b->minX = minX;
+	if (minY < b->minY) b->minY = minY;
+	if (maxX > b->maxX) b->maxX = maxX;
+	if (maxY > b->maxY) b->maxY = maxY;
+}
+
+static int quantize(double v, double origin, double scale){
+	double q = (v - origin) * scale;
+	return (int)(q < 0.0 ? q - 0.5 : q + 0.5);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar, also the tail of the vector loops and the only path on big-endian hosts
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+	The destination layouts. The vector loops hand their leftovers (n % width)
+	to the scalar store of the same policy.
+*/
+struct DoubleOut {
+	double* x;
+	double* y;
+	void store1(size_t i, double vx, double vy) { x[i] = vx; y[i] = vy; }
+};
+
+struct FloatSoAOut {
+	float* x;
+	float* y;
+	void store1(size_t i, double vx, double vy) { x[i] = (float)vx; y[i] = (float)vy; }
+};
+
+struct Vec3Out {
+	vec3* out;
+	void store1(size_t i, double vx, double vy) { out[i].x = (float)vx; out[i].y = (float)vy; out[i].z = 0.0f; }
+};
+
+struct QuantizedOut {
+	int* x;
+	int* y;
+	QuantizeParams q;
+	void store1(size_t i, double vx, double vy) { x[i] = quantize(vx, q.originX, q.scale); y[i] = quantize(vy, q.originY, q.scale); }
+};
+
+template <class Out>
+static void scalarDecode(const unsigned char* xy, size_t begin, size_t n, Out& out,
+	double& minX, double& minY, double& maxX, double& maxY){
+	for (size_t i = begin; i < n; i++){
+		double vx = readLEDouble(xy + i * 16);
+		double vy = readLEDouble(xy + i * 16 + 8);
+		out.store1(i, vx, vy);
+		if (vx < minX) minX = vx;
+		if (vx > maxX) maxX = vx;
+		if (vy < minY) minY = vy;
+		if (vy > maxY) maxY = vy;
+	}
+}
+
+template <class Out>
+static void scalarKernel(const unsigned char* xy, size_t n, Out& out, CoordBounds* bounds){
+	double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+	scalarDecode(xy, 0, n, out, minX, minY, maxX, maxY);
+	mergeBounds(bounds, minX, minY, maxX, maxY);
+}
+
+static void scalarToDouble(const unsigned char* xy, size_t n, double* x, double* y, CoordBounds* b){
+	DoubleOut o = { x, y };
+	scalarKernel(xy, n, o, b);
+}
+static void scalarToFloatSoA(const unsigned char* xy, size_t n, float* x, float* y, CoordBounds* b){
+	FloatSoAOut o = { x, y };
+	scalarKernel(xy, n, o, b);
+}
+static void scalarToVec3(const unsigned char* xy, size_t n, vec3* out, CoordBounds* b){
+	Vec3Out o = { out };
+	scalarKernel(xy, n, o, b);
+}
+static void scalarToQuantized(const unsigned char* xy, size_t n, const QuantizeParams& q, int* x, int* y, CoordBounds* b){
+	QuantizedOut o = { x, y, q };
+	scalarKernel(xy, n, o, b);
+}
+
+static void scalarShxEntries(const unsigned char* shx, size_t n, unsigned long long* offsets, unsigned int* sizes){
+	for (size_t i = 0; i < n; i++){
+		offsets[i] = (unsigned long long)readBEUInt(shx + i * 8) * 2;
+		sizes[i] = readBEUInt(shx + i * 8 + 4) * 2;
+	}
+}
+
+static const DecodeKernels scalarKernels = {
+	ISA_SCALAR, scalarToDouble, scalarToFloatSoA, scalarToVec3, scalarToQuantized, scalarShxEntries
+};
+
+#ifdef KERNELS_X86
+////////////////////////////////////////////////////////////////////////////////
+// SSE2: 2 points per step. p0 = [x0 y0], p1 = [x1 y1]
+////////////////////////////////////////////////////////////////////////////////
+
+struct SSE2DoubleOut : DoubleOut {
+	void store2(size_t i, __m128d, __m128d, __m128d xv, __m128d yv){
+		_mm_storeu_pd(x + i, xv);
+		_mm_storeu_pd(y + i, yv);
+	}
+};
+
+struct SSE2FloatSoAOut : FloatSoAOut {
+	void store2(size_t i, __m128d, __m128d, __m128d xv, __m128d yv){
+		_mm_storel_pi((__m64*)(x + i), _mm_cvtpd_ps(xv));
+		_mm_storel_pi((__m64*)(y + i), _mm_cvtpd_ps(yv));
+	}
+};
+
+struct SSE2Vec3Out : Vec3Out {
+	void store2(size_t i, __m128d p0, __m128d p1, __m128d, __m128d){
+		_mm_storel_pi((__m64*)&out[i].x, _mm_cvtpd_ps(p0));
+		_mm_storel_pi((__m64*)&out[i + 1].x, _mm_cvtpd_ps(p1));
+		out[i].z = 0.0f;
+		out[i + 1].z = 0.0f;
+	}
+};
+
+/*
+	Half away from zero, as quantize(): cvtpd rounds half to even, so add
+	0.5 with the value's sign and truncate.
+*/
+static inline __m128i sse2Round(__m128d v){
+	__m128d half = _mm_or_pd(_mm_and_pd(v, _mm_set1_pd(-0.0)), _mm_set1_pd(0.5));
+	return _mm_cvttpd_epi32(_mm_add_pd(v, half));
+}
+
+struct SSE2QuantizedOut : QuantizedOut {
+	void store2(size_t i, __m128d, __m128d, __m128d xv, __m128d yv){
+		__m128d sc = _mm_set1_pd(q.scale);
+		__m128i qx = sse2Round(_mm_mul_pd(_mm_sub_pd(xv, _mm_set1_pd(q.originX)), sc));
+		__m128i qy = sse2Round(_mm_mul_pd(_mm_sub_pd(yv, _mm_set1_pd(q.originY)), sc));
+		_mm_storel_epi64((__m128i*)(x + i), qx);
+		_mm_storel_epi64((__m128i*)(y + i), qy);
+	}
+};
+
+template <class Out>
+static void sse2Kernel(const unsigned char* xy, size_t n, Out& out, CoordBounds* bounds){
+	__m128d vmin = _mm_set1_pd(1e300), vmax = _mm_set1_pd(-1e300);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2){
+		__m128d p0 = _mm_loadu_pd((const double*)(xy + i * 16));
+		__m128d p1 = _mm_loadu_pd((const double*)(xy + i * 16 + 16));
+		vmin = _mm_min_pd(vmin, _mm_min_pd(p0, p1));
+		vmax = _mm_max_pd(vmax, _mm_max_pd(p0, p1));
+		out.store2(i, p0, p1, _mm_unpacklo_pd(p0, p1), _mm_unpackhi_pd(p0, p1));
+	}
+	double mn[2], mx[2];
+	_mm_storeu_pd(mn, vmin);
+	_mm_storeu_pd(mx, vmax);
+	scalarDecode(xy, i, n, out, mn[0], mn[1], mx[0], mx[1]);
+	mergeBounds(bounds, mn[0], mn[1], mx[0], mx[1]);
+}
+
+static void sse2ToDouble(const unsigned char* xy, size_t n, double* x, double* y, CoordBounds* b){
+	SSE2DoubleOut o;
+	o.x = x; o.y = y;
+	sse2Kernel(xy, n, o, b);
+}
+static void sse2ToFloatSoA(const unsigned char* xy, size_t n, float* x, float* y, CoordBounds* b){
+	SSE2FloatSoAOut o;
+	o.x = x; o.y = y;
+	sse2Kernel(xy, n, o, b);
+}
+static void sse2ToVec3(const unsigned char* xy, size_t n, vec3* out, CoordBounds* b){
+	SSE2Vec3Out o;
+	o.out = out;
+	sse2Kernel(xy, n, o, b);
+}
+static void sse2ToQuantized(const unsigned char* xy, size_t n, const QuantizeParams& q, int* x, int* y, CoordBounds* b){
+	SSE2QuantizedOut o;
+	o.x = x; o.y = y; o.q = q;
+	sse2Kernel(xy, n, o, b);
+}
+
+/*
+	2 entries per step: [o0 l0 o1 l1] as big-endian 32 bit words.
+	SSE2 has no byte shuffle, so the swap is done with shifts.
+*/
+static void sse2ShxEntries(const unsigned char* shx, size_t n, unsigned long long* offsets, unsigned int* sizes){
+	const __m128i low32 = _mm_set_epi32(0, -1, 0, -1);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2){
+		__m128i v = _mm_loadu_si128((const __m128i*)(shx + i * 8));
+		v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		// offsets widen to 64 bit before doubling, sizes stay 32 bit
+		_mm_storeu_si128((__m128i*)(offsets + i), _mm_slli_epi64(_mm_and_si128(v, low32), 1));
+		__m128i len = _mm_shuffle_epi32(_mm_srli_epi64(v, 32), _MM_SHUFFLE(3, 3, 2, 0));
+		_mm_storel_epi64((__m128i*)(sizes + i), _mm_slli_epi32(len, 1));
+	}
+	scalarShxEntries(shx + i * 8, n - i, offsets + i, sizes + i);
+}
+
+static const DecodeKernels sse2Kernels = {
+	ISA_SSE2, sse2ToDouble, sse2ToFloatSoA, sse2ToVec3, sse2ToQuantized, sse2ShxEntries
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX2: 4 points per step. a = [x0 y0 x1 y1], b = [x2 y2 x3 y3]
+////////////////////////////////////////////////////////////////////////////////
+
+struct AVX2DoubleOut : DoubleOut {
+	TARGET_AVX2 void store4(size_t i, __m256d, __m256d, __m256d xv, __m256d yv){
+		_mm256_storeu_pd(x + i, xv);
+		_mm256_storeu_pd(y + i, yv);
+	}
+};
+
+struct AVX2FloatSoAOut : FloatSoAOut {
+	TARGET_AVX2 void store4(size_t i, __m256d, __m256d, __m256d xv, __m256d yv){
+		_mm_storeu_ps(x + i, _mm256_cvtpd_ps(xv));
+		_mm_storeu_ps(y + i, _mm256_cvtpd_ps(yv));
+	}
+};
+
+struct AVX2Vec3Out : Vec3Out {
+	TARGET_AVX2 void store4(size_t i, __m256d a, __m256d b, __m256d, __m256d){
+		__m128 fa = _mm256_cvtpd_ps(a);
+		__m128 fb = _mm256_cvtpd_ps(b);
+		_mm_storel_pi((__m64*)&out[i].x, fa);
+		_mm_storeh_pi((__m64*)&out[i + 1].x, fa);
+		_mm_storel_pi((__m64*)&out[i + 2].x, fb);
+		_mm_storeh_pi((__m64*)&out[i + 3].x, fb);
+		out[i].z = out[i + 1].z = out[i + 2].z = out[i + 3].z = 0.0f;
+	}
+};
+
+// Half away from zero, as sse2Round.
+TARGET_AVX2 static inline __m128i avx2Round(__m256d v){
+	__m256d half = _mm256_or_pd(_mm256_and_pd(v, _mm256_set1_pd(-0.0)), _mm256_set1_pd(0.5));
+	return _mm256_cvttpd_epi32(_mm256_add_pd(v, half));
+}
+
+struct AVX2QuantizedOut : QuantizedOut {
+	TARGET_AVX2 void store4(size_t i, __m256d, __m256d, __m256d xv, __m256d yv){
+		__m256d sc = _mm256_set1_pd(q.scale);
+		__m128i qx = avx2Round(_mm256_mul_pd(_mm256_sub_pd(xv, _mm256_set1_pd(q.originX)), sc));
+		__m128i qy = avx2Round(_mm256_mul_pd(_mm256_sub_pd(yv, _mm256_set1_pd(q.originY)), sc));
+		_mm_storeu_si128((__m128i*)(x + i), qx);
+		_mm_storeu_si128((__m128i*)(y + i), qy);
+	}
+};
+
+template <class Out>
+TARGET_AVX2 static void avx2Kernel(const unsigned char* xy, size_t n, Out& out, CoordBounds* bounds){
+	__m256d vmin = _mm256_set1_pd(1e300), vmax = _mm256_set1_pd(-1e300);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		__m256d a = _mm256_loadu_pd((const double*)(xy + i * 16));
+		__m256d b = _mm256_loadu_pd((const double*)(xy + i * 16 + 32));
+		vmin = _mm256_min_pd(vmin, _mm256_min_pd(a, b));
+		vmax = _mm256_max_pd(vmax, _mm256_max_pd(a, b));
+		// unpack gives [x0 x2 x1 x3]; the lane permute puts them in order
+		__m256d xv = _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), 0xD8);
+		__m256d yv = _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), 0xD8);
+		out.store4(i, a, b, xv, yv);
+	}
+	__m128d mn2 = _mm_min_pd(_mm256_castpd256_pd128(vmin), _mm256_extractf128_pd(vmin, 1));
+	__m128d mx2 = _mm_max_pd(_mm256_castpd256_pd128(vmax), _mm256_extractf128_pd(vmax, 1));
+	double mn[2], mx[2];
+	_mm_storeu_pd(mn, mn2);
+	_mm_storeu_pd(mx, mx2);
+	scalarDecode(xy, i, n, out, mn[0], mn[1], mx[0], mx[1]);
+	mergeBounds(bounds, mn[0], mn[1], mx[0], mx[1]);
+}
+
+TARGET_AVX2 static void avx2ToDouble(const unsigned char* xy, size_t n, double* x, double* y, CoordBounds* b){
+	AVX2DoubleOut o;
+	o.x = x; o.y = y;
+	avx2Kernel(xy, n, o, b);
+}
+TARGET_AVX2 static void avx2ToFloatSoA(const unsigned char* xy, size_t n, float* x, float* y, CoordBounds* b){
+	AVX2FloatSoAOut o;
+	o.x = x; o.y = y;
+	avx2Kernel(xy, n, o, b);
+}
+TARGET_AVX2 static void avx2ToVec3(const unsigned char* xy, size_t n, vec3* out, CoordBounds* b){
+	AVX2Vec3Out o;
+	o.out = out;
+	avx2Kernel(xy, n, o, b);
+}
+TARGET_AVX2 static void avx2ToQuantized(const unsigned char* xy, size_t n, const QuantizeParams& q, int* x, int* y, CoordBounds* b){
+	AVX2QuantizedOut o;
+	o.x = x; o.y = y; o.q = q;
+	avx2Kernel(xy, n, o, b);
+}
+
+/*
+	4 entries per step: byte swap with one shuffle, then gather the offsets
+	into the low half and the sizes into the high half.
+*/
+TARGET_AVX2 static void avx2ShxEntries(const unsigned char* shx, size_t n, unsigned long long* offsets, unsigned int* sizes){
+	const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		__m256i v = _mm256_loadu_si256((const __m256i*)(shx + i * 8));
+		v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, swap), split);
+		__m256i off = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v));
+		_mm256_storeu_si256((__m256i*)(offsets + i), _mm256_slli_epi64(off, 1));
+		_mm_storeu_si128((__m128i*)(sizes + i), _mm_slli_epi32(_mm256_extracti128_si256(v, 1), 1));
+	}
+	scalarShxEntries(shx + i * 8, n - i, offsets + i, sizes + i);
+}
+
+static const DecodeKernels avx2Kernels = {
+	ISA_AVX2, avx2ToDouble, avx2ToFloatSoA, avx2ToVec3, avx2ToQuantized, avx2ShxEntries
+};
+
+static bool cpuHasSSE2(){
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2") != 0;
+#else
+	int r[4];
+	__cpuid(r, 1);
+	return (r[3] & (1 << 26)) != 0;
+#endif
+}
+
+static bool cpuHasAVX2(){
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	int r[4];
+	__cpuid(r, 0);
+	if (r[0] < 7)
+		return false;
+	__cpuid(r, 1);
+	bool osxsave = (r[2] & (1 << 27)) != 0, avx = (r[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) // OS saves the YMM registers
+		return false;
+	__cpuidex(r, 7, 0);
+	return (r[1] & (1 << 5)) != 0;
+#endif
+}
+#endif // KERNELS_X86
+
+#ifdef KERNELS_NEON
+////////////////////////////////////////////////////////////////////////////////
+// NEON (AArch64): 2 points per step, vld2 splits x and y
+////////////////////////////////////////////////////////////////////////////////
+
+struct NEONDoubleOut : DoubleOut {
+	void store2(size_t i, float64x2_t xv, float64x2_t yv){
+		vst1q_f64(x + i, xv);
+		vst1q_f64(y + i, yv);
+	}
+};
+
+struct NEONFloatSoAOut : FloatSoAOut {
+	void store2(size_t i, float64x2_t xv, float64x2_t yv){
+		vst1_f32(x + i, vcvt_f32_f64(xv));
+		vst1_f32(y + i, vcvt_f32_f64(yv));
+	}
+};
+
+struct NEONVec3Out : Vec3Out {
+	void store2(size_t i, float64x2_t xv, float64x2_t yv){
+		float32x2_t fx = vcvt_f32_f64(xv), fy = vcvt_f32_f64(yv);
+		out[i].x = vget_lane_f32(fx, 0);
+		out[i].y = vget_lane_f32(fy, 0);
+		out[i + 1].x = vget_lane_f32(fx, 1);
+		out[i + 1].y = vget_lane_f32(fy, 1);
+		out[i].z = out[i + 1].z = 0.0f;
+	}
+};
+
+/*
+	As quantize(): add 0.5 with the value's sign and truncate. vcvta rounds
+	the exact value instead, which differs for 0.49999999999999994; the narrow
+	saturates like the scalar conversion does on AArch64.
+*/
+static inline int32x2_t neonRound(float64x2_t v){
+	uint64x2_t sign = vandq_u64(vreinterpretq_u64_f64(v), vdupq_n_u64(0x8000000000000000ull));
+	float64x2_t half = vreinterpretq_f64_u64(vorrq_u64(sign, vreinterpretq_u64_f64(vdupq_n_f64(0.5))));
+	return vqmovn_s64(vcvtq_s64_f64(vaddq_f64(v, half)));
+}
+
+struct NEONQuantizedOut : QuantizedOut {
+	void store2(size_t i, float64x2_t xv, float64x2_t yv){
+		float64x2_t sc = vdupq_n_f64(q.scale);
+		vst1_s32(x + i, neonRound(vmulq_f64(vsubq_f64(xv, vdupq_n_f64(q.originX)), sc)));
+		vst1_s32(y + i, neonRound(vmulq_f64(vsubq_f64(yv, vdupq_n_f64(q.originY)), sc)));
+	}
+};
+
+template <class Out>
+static void neonKernel(const unsigned char* xy, size_t n, Out& out, CoordBounds* bounds){
+	float64x2_t vminX = vdupq_n_f64(1e300), vminY = vminX;
+	float64x2_t vmaxX = vdupq_n_f64(-1e300), vmaxY = vmaxX;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2){
+		float64x2x2_t p = vld2q_f64((const double*)(xy + i * 16));
+		vminX = vminq_f64(vminX, p.val[0]);
+		vmaxX = vmaxq_f64(vmaxX, p.val[0]);
+		vminY = vminq_f64(vminY, p.val[1]);
+		vmaxY = vmaxq_f64(vmaxY, p.val[1]);
+		out.store2(i, p.val[0], p.val[1]);
+	}
+	double minX = vminvq_f64(vminX), minY = vminvq_f64(vminY);
+	double maxX = vmaxvq_f64(vmaxX), maxY = vmaxvq_f64(vmaxY);
+	scalarDecode(xy, i, n, out, minX, minY, maxX, maxY);
+	mergeBounds(bounds, minX, minY, maxX, maxY);
+}
+
+static void neonToDouble(const unsigned char* xy, size_t n, double* x, double* y, CoordBounds* b){
+	NEONDoubleOut o;
+	o.x = x; o.y = y;
+	neonKernel(xy, n, o, b);
+}
+static void neonToFloatSoA(const unsigned char* xy, size_t n, float* x, float* y, CoordBounds* b){
+	NEONFloatSoAOut o;
+	o.x = x; o.y = y;
+	neonKernel(xy, n, o, b);
+}
+static void neonToVec3(const unsigned char* xy, size_t n, vec3* out, CoordBounds* b){
+	NEONVec3Out o;
+	o.out = out;
+	neonKernel(xy, n, o, b);
+}
+static void neonToQuantized(const unsigned char* xy, size_t n, const QuantizeParams& q, int* x, int* y, CoordBounds* b){
+	NEONQuantizedOut o;
+	o.x = x; o.y = y; o.q = q;
+	neonKernel(xy, n, o, b);
+}
+
+// 4 entries per step: vld2 splits offsets from sizes, vrev32 swaps the bytes
+static void neonShxEntries(const unsigned char* shx, size_t n, unsigned long long* offsets, unsigned int* sizes){
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		uint32x4x2_t e = vld2q_u32((const uint32_t*)(shx + i * 8));
+		uint32x4_t off = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(e.val[0])));
+		uint32x4_t len = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(e.val[1])));
+		vst1q_u64((uint64_t*)(offsets + i), vshlq_n_u64(vmovl_u32(vget_low_u32(off)), 1));
+		vst1q_u64((uint64_t*)(offsets + i + 2), vshlq_n_u64(vmovl_u32(vget_high_u32(off)), 1));
+		vst1q_u32(sizes + i, vshlq_n_u32(len, 1));
+	}
+	scalarShxEntries(shx + i * 8, n - i, offsets + i, sizes + i);
+}
+
+static const DecodeKernels neonKernels = {
+	ISA_NEON, neonToDouble, neonToFloatSoA, neonToVec3, neonToQuantized, neonShxEntries
+};
+#endif // KERNELS_NEON
+
+////////////////////////////////////////////////////////////////////////////////
+// Selection
+////////////////////////////////////////////////////////////////////////////////
+
+const DecodeKernels* decodeKernelsFor(KernelISA isa){
+	// the vector kernels read little-endian doubles directly
+	if (isa != ISA_SCALAR && hostIsBigEndian())
+		return NULL;
+	switch (isa){
+	case ISA_SCALAR:
+		return &scalarKernels;
+#ifdef KERNELS_X86
+	case ISA_SSE2:
+		return cpuHasSSE2() ? &sse2Kernels : NULL;
+	case ISA_AVX2:
+		return cpuHasAVX2() ? &avx2Kernels : NULL;
+#endif
+#ifdef KERNELS_NEON
+	case ISA_NEON:
+		return &neonKernels;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+const char* kernelISAName(KernelISA isa){
+	switch (isa){
+	case ISA_SCALAR:	return "scalar";
+	case ISA_SSE2:		return "sse2";
+	case ISA_AVX2:		return "avx2";
+	case ISA_NEON:		return "neon";
+	default:			return "unknown";
+	}
+}
+
+static const DecodeKernels* sSelected = NULL;
+static once_flag sSelectOnce;
+
+static void selectKernels(){
+	const char* forced = getenv("GLRENDERSHP_KERNELS");
+	if (forced){
+		for (int i = 0; i < ISA_COUNT; i++){
+			if (strcmp(forced, kernelISAName((KernelISA)i)) == 0 && decodeKernelsFor((KernelISA)i)){
+				sSelected = decodeKernelsFor((KernelISA)i);
+				return;
+			}
+		}
+	}
+	// best first
+	const KernelISA order[] = { ISA_AVX2, ISA_NEON, ISA_SSE2, ISA_SCALAR };
+	for (int i = 0; i < 4; i++){
+		if (decodeKernelsFor(order[i])){
+			sSelected = decodeKernelsFor(order[i]);
+			return;
+		}
+	}
+}
+
+const DecodeKernels& decodeKernels(){
+	call_once(sSelectOnce, selectKernels);
+	return *sSelected;
+}
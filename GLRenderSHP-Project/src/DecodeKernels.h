@@ -0,0 +1,63 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef DECODEKERNELS_H_DEF
+#define DECODEKERNELS_H_DEF
+
+#include "Vectors.h"
+#include <stddef.h>
+
+enum KernelISA {
+	ISA_SCALAR,
+	ISA_SSE2,
+	ISA_AVX2,
+	ISA_NEON,
+	ISA_COUNT
+};
+
+/*
+	Running min/max of decoded coordinates. Kernels only widen it,
+	so one CoordBounds can be passed through several calls.
+*/
+struct CoordBounds {
+	double minX, minY, maxX, maxY;
+	CoordBounds() : minX(1e300), minY(1e300), maxX(-1e300), maxY(-1e300) {}
+};
+
+// x' = round((x - originX) * scale), same for y
+struct QuantizeParams {
+	double originX, originY;
+	double scale;
+};
+
+/*
+	Conversions of the XY point block of a .shp record (n interleaved
+	little-endian x,y doubles, any alignment) into a destination layout, in one
+	pass. bounds may be NULL.
+*/
+struct DecodeKernels {
+	KernelISA isa;
+	void (*toDouble)(const unsigned char* xy, size_t n, double* x, double* y, CoordBounds* bounds);
+	void (*toFloatSoA)(const unsigned char* xy, size_t n, float* x, float* y, CoordBounds* bounds);
+	void (*toVec3)(const unsigned char* xy, size_t n, vec3* out, CoordBounds* bounds); // z = 0
+	void (*toQuantized)(const unsigned char* xy, size_t n, const QuantizeParams& q, int* x, int* y, CoordBounds* bounds);
+
+	// n .shx entries (big-endian offset, length in 16 bit words) to byte offsets and sizes
+	void (*shxEntries)(const unsigned char* shx, size_t n, unsigned long long* offsets, unsigned int* sizes);
+};
+
+// Best kernels for this CPU. GLRENDERSHP_KERNELS=scalar|sse2|avx2|neon forces a set.
+const DecodeKernels& decodeKernels();
+// A given set, or NULL when it is not built in or not supported by the CPU.
+const DecodeKernels* decodeKernelsFor(KernelISA isa);
+const char* kernelISAName(KernelISA isa);
+
+#endif
@@ -0,0 +1,187 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "DrawList.h"
+#include "Metrics.h"
+#include "PointSymbols.h"
+#include <algorithm>
+#include <string.h>
+#include <GL/glut.h>
+
+using namespace std;
+
+void GLStateCache::invalidate(){
+	vertices = NULL;
+	knownColor = false;
+	lineWidth = pointSize = -1;
+	smooth = -1;
+	texCoords = NULL;
+	atlas = NULL;
+	knownAtlas = false;
+}
+
+void GLStateCache::apply(const DrawState& s){
+	requests += 2;
+	if (s.vertices != vertices){
+		if (issue)
+			glVertexPointer(3, GL_FLOAT, sizeof(vec3), s.vertices);
+		vertices = s.vertices;
+		changes++;
+	}
+	if (!knownColor || s.color.x != color.x || s.color.y != color.y || s.color.z != color.z || s.color.w != color.w){
+		if (issue)
+			glColor4f(s.color.x, s.color.y, s.color.z, s.color.w);
+		color = s.color;
+		knownColor = true;
+		changes++;
+	}
+	if (s.mode == DRAW_LINES){
+		requests++;
+		if (s.size != lineWidth){
+			if (issue)
+				glLineWidth(s.size);
+			lineWidth = s.size;
+			changes++;
+		}
+	}
+	else if (s.mode == DRAW_POINTS){
+		requests += 2;
+		if (s.size != pointSize){
+			if (issue)
+				glPointSize(s.size);
+			pointSize = s.size;
+			changes++;
+		}
+		if ((int)s.smooth != smooth){
+			if (issue){
+				if (s.smooth)
+					glEnable(GL_POINT_SMOOTH);
+				else
+					glDisable(GL_POINT_SMOOTH);
+			}
+			smooth = s.smooth;
+			changes++;
+		}
+	}
+	requests++;
+	if (!knownAtlas || s.atlas != atlas){
+		if (issue){
+			if (s.atlas != NULL){
+				glEnable(GL_TEXTURE_2D);
+				glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+				s.atlas->bind();
+			}
+			else {
+				glDisable(GL_TEXTURE_2D);
+				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			}
+		}
+		atlas = s.atlas;
+		knownAtlas = true;
+		texCoords = NULL;
+		changes++;
+	}
+	if (s.atlas != NULL){
+		requests++;
+		if (s.texCoords != texCoords){
+			if (issue)
+				glTexCoordPointer(2, GL_FLOAT, sizeof(vec2), s.texCoords);
+			texCoords = s.texCoords;
+			changes++;
+		}
+	}
+}
+
+void DrawList::clear(){
+	items.clear();
+	indices.clear();
+	batches.clear();
+	merged.clear();
+	memset(&stats, 0, sizeof(stats));
+}
+
+void DrawList::beginItem(unsigned long long key, const DrawState& state){
+	if (!items.empty())
+		items.back().end = indices.size();
+	Item it;
+	it.key = key;
+	it.state = state;
+	it.begin = it.end = indices.size();
+	items.push_back(it);
+}
+
+void DrawList::addStrip(unsigned int first, int n, bool closed){
+	for (int i = 1; i < n; i++){
+		indices.push_back(first + i - 1);
+		indices.push_back(first + i);
+	}
+	if (closed && n > 2){
+		indices.push_back(first + n - 1);
+		indices.push_back(first);
+	}
+}
+
+void DrawList::addPath(const unsigned int* path, int n, bool closed){
+	for (int i = 1; i < n; i++){
+		indices.push_back(path[i - 1]);
+		indices.push_back(path[i]);
+	}
+	if (closed && n > 2){
+		indices.push_back(path[n - 1]);
+		indices.push_back(path[0]);
+	}
+}
+
+void DrawList::finish(){
+	if (!items.empty())
+		items.back().end = indices.size();
+	stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b){ return a.key < b.key; });
+	merged.reserve(indices.size());
+	for (size_t i = 0; i < items.size(); i++){
+		const Item& it = items[i];
+		if (it.end == it.begin)
+			continue;
+		if (batches.empty() || batches.back().state != it.state){
+			Batch b;
+			b.state = it.state;
+			b.begin = merged.size();
+			b.count = 0;
+			batches.push_back(b);
+		}
+		merged.insert(merged.end(), indices.begin() + it.begin, indices.begin() + it.end);
+		batches.back().count += it.end - it.begin;
+	}
+	stats.items = (int)items.size();
+	stats.batches = (int)batches.size();
+	stats.indices = (long long)merged.size();
+}
+
+void DrawList::submit(GLStateCache& state){
+	static const GLenum modes[] = { GL_TRIANGLES, GL_LINES, GL_POINTS, GL_QUADS };
+	int requests = state.getRequests(), changes = state.getChanges();
+	if (state.issues())
+		glEnableClientState(GL_VERTEX_ARRAY);
+	for (size_t i = 0; i < batches.size(); i++){
+		const Batch& b = batches[i];
+		state.apply(b.state);
+		if (state.issues())
+			glDrawElements(modes[b.state.mode], (GLsizei)b.count, GL_UNSIGNED_INT, &merged[b.begin]);
+	}
+	if (state.issues())
+		glDisableClientState(GL_VERTEX_ARRAY);
+	stats.stateRequests = state.getRequests() - requests;
+	stats.stateChanges = state.getChanges() - changes;
+	if (state.issues()){
+		Metrics::add(COUNTER_DRAW_CALLS, (long long)batches.size());
+		Metrics::add(COUNTER_VERTICES, (long long)merged.size());
+		Metrics::add(COUNTER_STATE_CHANGES, stats.stateChanges);
+	}
+}
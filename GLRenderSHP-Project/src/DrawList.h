@@ -0,0 +1,147 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef DRAWLIST_H_DEF
+#define DRAWLIST_H_DEF
+
+#include "Vectors.h"
+#include <vector>
+
+using namespace std;
+
+enum DrawMode {
+	DRAW_TRIANGLES,
+	DRAW_LINES,     // index pairs
+	DRAW_POINTS,
+	DRAW_QUADS      // textured, four indices each
+};
+
+class SymbolAtlas;
+
+// Everything a draw depends on besides its indices.
+struct DrawState {
+	DrawMode mode;
+	const vec3* vertices;  // the array the indices refer to
+	vec4 color;
+	float size;            // line width or point size
+	bool smooth;           // round points
+	const vec2* texCoords; // DRAW_QUADS: per vertex, into atlas
+	const SymbolAtlas* atlas;
+
+	bool operator==(const DrawState& o) const {
+		return mode == o.mode && vertices == o.vertices && color.x == o.color.x && color.y == o.color.y
+			&& color.z == o.color.z && color.w == o.color.w && size == o.size && smooth == o.smooth
+			&& texCoords == o.texCoords && atlas == o.atlas;
+	}
+	bool operator!=(const DrawState& o) const { return !(*this == o); }
+};
+
+// Layer draw order first, then what is drawn (fills under lines under points), then the style.
+inline unsigned long long drawKey(int layerOrder, DrawMode mode, unsigned int style){
+	return ((unsigned long long)layerOrder << 40) | ((unsigned long long)mode << 32) | style;
+}
+
+/*
+	Filter in front of the GL state the draw list uses: a call is made only
+	when the value differs from what was set last. invalidate() forgets
+	everything (at the start of a frame, or after other code touched GL).
+	With issue = false nothing is sent to GL, for counting without a context.
+*/
+class GLStateCache {
+public:
+	GLStateCache(bool issue = true) : issue(issue), requests(0), changes(0) { invalidate(); }
+
+	void invalidate();
+	void apply(const DrawState& s);
+
+	bool issues() const { return issue; }
+	int getRequests() const { return requests; } // state calls asked for
+	int getChanges() const { return changes; }   // state calls made
+	void resetCounts() { requests = changes = 0; }
+
+private:
+	bool issue;
+	const vec3* vertices;
+	vec4 color;
+	float lineWidth, pointSize;
+	int smooth;            // -1 unknown
+	bool knownColor;
+	const vec2* texCoords;
+	const SymbolAtlas* atlas;
+	bool knownAtlas;
+	int requests, changes;
+};
+
+struct DrawListStats {
+	int items;              // entities added
+	int batches;            // draw calls after merging
+	long long indices;
+	int stateRequests;      // before the redundant-state filter
+	int stateChanges;       // after it
+	int perEntityDrawCalls; // what drawing entity by entity costs
+	int perEntityStateChanges;
+};
+
+/*
+	One frame's drawing as a list of items, one per entity: a sort key, the
+	state it needs and its indices. finish() sorts the items by key (stable,
+	so entities keep their order within a key) and merges runs of items
+	with equal state into one indexed draw; submit() sends those through a
+	GLStateCache, so a batch sets only what changed since the one before.
+
+	Items of different layers have different vertex arrays and are never
+	merged, so layer order is kept; they share state calls when their
+	styles agree.
+*/
+class DrawList {
+public:
+	DrawList() : stats() {}
+
+	void clear();
+	// Starts an item; the indices added until the next one belong to it.
+	void beginItem(unsigned long long key, const DrawState& state);
+	void addIndex(unsigned int i) { indices.push_back(i); }
+	void addIndices(const unsigned int* i, size_t n) { indices.insert(indices.end(), i, i + n); }
+	// A line strip of n vertices from first, as segments; closed adds the last one back to first.
+	void addStrip(unsigned int first, int n, bool closed);
+	// The same through the n vertices listed in path.
+	void addPath(const unsigned int* path, int n, bool closed);
+	// The cost of the same items drawn one by one, for getStats().
+	void addPerEntityCost(int drawCalls, int stateChanges){
+		stats.perEntityDrawCalls += drawCalls;
+		stats.perEntityStateChanges += stateChanges;
+	}
+
+	void finish();
+	// Draws the batches; with a cache that does not issue, only counts.
+	void submit(GLStateCache& state);
+
+	const DrawListStats& getStats() const { return stats; }
+
+private:
+	struct Item {
+		unsigned long long key;
+		DrawState state;
+		size_t begin, end;
+	};
+	struct Batch {
+		DrawState state;
+		size_t begin, count;
+	};
+
+	vector<Item> items;
+	vector<unsigned int> indices;   // as added
+	vector<Batch> batches;
+	vector<unsigned int> merged;    // batch by batch
+	DrawListStats stats;
+};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "FileIO.h"
+#include "Metrics.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <errno.h>
+#endif
+
+PosFile::PosFile() : fileSize(0){
+#ifdef _WIN32
+	handle = INVALID_HANDLE_VALUE;
+#else
+	fd = -1;
+#endif
+}
+
+PosFile::~PosFile(){
+	close();
+}
+
+bool PosFile::open(const char* path){
+	close();
+	ScopedTimer timer(PHASE_FILE_OPEN);
+	Metrics::add(COUNTER_SYSCALLS);
+#ifdef _WIN32
+	HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (h == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER sz;
+	if (!GetFileSizeEx(h, &sz)){
+		CloseHandle(h);
+		return false;
+	}
+	handle = h;
+	fileSize = (FileOffset)sz.QuadPart;
+#else
+	int f = ::open(path, O_RDONLY);
+	if (f < 0)
+		return false;
+	struct stat st;
+	if (fstat(f, &st) != 0){
+		::close(f);
+		return false;
+	}
+	fd = f;
+	fileSize = (FileOffset)st.st_size;
+#endif
+	return true;
+}
+
+void PosFile::close(){
+#ifdef _WIN32
+	if (handle != INVALID_HANDLE_VALUE)
+		CloseHandle((HANDLE)handle);
+	handle = INVALID_HANDLE_VALUE;
+#else
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+#endif
+	fileSize = 0;
+}
+
+bool PosFile::isOpen() const{
+#ifdef _WIN32
+	return handle != INVALID_HANDLE_VALUE;
+#else
+	return fd >= 0;
+#endif
+}
+
+size_t PosFile::readAt(FileOffset offset, void* dst, size_t len) const{
+	size_t done = 0;
+	char* out = (char*)dst;
+	while (done < len){
+#ifdef _WIN32
+		OVERLAPPED ov = {};
+		FileOffset pos = offset + done;
+		ov.Offset = (DWORD)(pos & 0xffffffffu);
+		ov.OffsetHigh = (DWORD)(pos >> 32);
+		DWORD chunk = (len - done > 0x40000000u) ? 0x40000000u : (DWORD)(len - done);
+		DWORD got = 0;
+		if (!ReadFile((HANDLE)handle, out + done, chunk, &got, &ov) || got == 0)
+			break;
+#else
+		ssize_t got = pread(fd, out + done, len - done, (off_t)(offset + done));
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			break;
+#endif
+		done += (size_t)got;
+		Metrics::add(COUNTER_SYSCALLS);
+	}
+	Metrics::add(COUNTER_BYTES_READ, (long long)done);
+	return done;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// MappedFile
+////////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile() : base(NULL), fileSize(0), writeTime(0){
+#ifdef _WIN32
+	mapping = NULL;
+#endif
+}
+
+MappedFile::~MappedFile(){
+	close();
+}
+
+bool MappedFile::open(const char* path){
+	close();
+	ScopedTimer timer(PHASE_FILE_OPEN);
+	Metrics::add(COUNTER_SYSCALLS);
+#ifdef _WIN32
+	HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (h == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER sz;
+	FILETIME ft;
+	if (!GetFileSizeEx(h, &sz) || sz.QuadPart == 0 || (unsigned long long)sz.QuadPart > (size_t)-1
+		|| !GetFileTime(h, NULL, NULL, &ft)){
+		CloseHandle(h);
+		return false;
+	}
+	HANDLE m = CreateFileMappingA(h, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(h); // the mapping keeps the file open
+	if (m == NULL)
+		return false;
+	void* p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+	if (p == NULL){
+		CloseHandle(m);
+		return false;
+	}
+	mapping = m;
+	base = (const unsigned char*)p;
+	fileSize = (FileOffset)sz.QuadPart;
+	writeTime = ((unsigned long long)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+#else
+	int f = ::open(path, O_RDONLY);
+	if (f < 0)
+		return false;
+	struct stat st;
+	if (fstat(f, &st) != 0 || st.st_size == 0 || (unsigned long long)st.st_size > (size_t)-1){
+		::close(f);
+		return false;
+	}
+	void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+	::close(f); // the mapping keeps the file open
+	if (p == MAP_FAILED)
+		return false;
+	base = (const unsigned char*)p;
+	fileSize = (FileOffset)st.st_size;
+#ifdef __APPLE__
+	writeTime = (unsigned long long)st.st_mtimespec.tv_sec * 1000000000ull + st.st_mtimespec.tv_nsec;
+#else
+	writeTime = (unsigned long long)st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+#endif
+#endif
+	return true;
+}
+
+void MappedFile::close(){
+	if (base == NULL)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(base);
+	CloseHandle((HANDLE)mapping);
+	mapping = NULL;
+#else
+	munmap((void*)base, (size_t)fileSize);
+#endif
+	base = NULL;
+	fileSize = 0;
+	writeTime = 0;
+}
@@ -0,0 +1,82 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef FILEIO_H_DEF
+#define FILEIO_H_DEF
+
+#include <stddef.h>
+
+typedef unsigned long long FileOffset;
+
+/*
+	Read-only file opened for positional reads (pread / ReadFile+OVERLAPPED).
+	readAt() never touches a shared file position, so one PosFile can be
+	used by many threads at the same time.
+*/
+class PosFile {
+public:
+	PosFile();
+	~PosFile();
+
+	bool open(const char* path);
+	void close();
+	bool isOpen() const;
+	FileOffset size() const { return fileSize; }
+
+	// Reads up to len bytes at offset into dst. Returns the number of bytes read.
+	size_t readAt(FileOffset offset, void* dst, size_t len) const;
+
+#ifndef _WIN32
+	int getFD() const { return fd; } // for the io_uring backend of AsyncReader
+#endif
+
+private:
+#ifdef _WIN32
+	void* handle;
+#else
+	int fd;
+#endif
+	FileOffset fileSize;
+
+	PosFile(const PosFile&);
+	PosFile& operator=(const PosFile&);
+};
+
+/*
+	Whole file mapped read-only. open() fails for empty files and when the
+	address space is too small (32 bit builds), so callers keep a read() fallback.
+*/
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* path);
+	void close();
+	bool isOpen() const { return base != NULL; }
+	const unsigned char* data() const { return base; }
+	FileOffset size() const { return fileSize; }
+	// Last write time at open(), in the platform's units (ns on POSIX, 100 ns on Windows).
+	unsigned long long modTime() const { return writeTime; }
+
+private:
+	const unsigned char* base;
+	FileOffset fileSize;
+	unsigned long long writeTime;
+#ifdef _WIN32
+	void* mapping;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif
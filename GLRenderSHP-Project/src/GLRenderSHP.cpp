@@ -16,13 +16,37 @@ Using ShapeLib version 1.3
 
 #include "shapefil.h"
 #include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 
 #include "ShapeFile.h"
+#include "LayerRegistry.h"
+#include "MapSession.h"
+#include "Camera.h"
+#include "DrawList.h"
+#include "RenderThread.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Benchmarks.h"
 
 using namespace std;
 
 vec4 shpBoundaries;
-vector<ShapeFile> g_Shapefiles;
+LayerRegistry g_Layers;
+Camera g_Camera;          // -direct only; otherwise the render thread has the camera
+DrawList g_DrawList;      // -direct only, rebuilt every frame
+GLStateCache g_GLState;
+RenderThread g_Renderer(g_Layers);
+thread g_Loader;
+atomic<bool> g_StopLoading(false); // set at exit: the loader starts no further layer
+bool g_DirectGL = false;
+double g_FrameBudgetMs = 12; // drawing time per composited frame before refining in later frames
+int g_WindowW = 600, g_WindowH = 600;
+int g_DragX, g_DragY; // last mouse position of a left-button drag
+bool g_Dragging = false;
+string g_MetricsFile = "metrics.json";
+string g_SessionFile = "Shapefiles/overview.thuban";
 
 void initializeGL()
 {
@@ -44,52 +68,255 @@ void initializeGL()
 	shpBoundaries.w = 90.0f;
 }
 
+/*
+	Every view change goes through here: to the render thread, or with
+	-direct straight to the camera this thread draws with.
+*/
+void postView(const ViewCommand& c){
+	if (g_DirectGL){
+		applyViewCommand(g_Camera, g_Layers.snapshot(), c);
+		glutPostRedisplay();
+	}
+	else
+		g_Renderer.post(c);
+}
+
 void resizeGL(int w, int h)
 {
 	if (h <= 0) h = 1;
 	glViewport(0, 0, (GLsizei)w, (GLsizei)h);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	//Assign Bounding Box Coordinates of Shapefile to glOrtho()
-	glOrtho(shpBoundaries.x, shpBoundaries.z, shpBoundaries.y, shpBoundaries.w, -1, 1);
-	glMatrixMode(GL_MODELVIEW);
+	g_WindowW = w;
+	g_WindowH = h;
+	postView(ViewCommand::make(VIEW_RESIZE, w, h));
+}
+
+// Asks for a redisplay when the render thread has finished a frame.
+void frameTimerCB(int){
+	if (g_Renderer.hasNewFrame())
+		glutPostRedisplay();
+	glutTimerFunc(4, frameTimerCB, 0);
 }
 
 void render()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glColor3f(0.0, 0.0, 1.0);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	if (!g_DirectGL){
+		// the render thread's newest frame; it may still be of the size before a resize
+		const RasterImage& frame = g_Renderer.acquireFrame();
+		glOrtho(0, g_WindowW, 0, g_WindowH, -1, 1);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glDisable(GL_BLEND);
+		glRasterPos2i(0, 0);
+		{
+			ScopedTimer upload(PHASE_UPLOAD);
+			glDrawPixels(frame.width, frame.height, GL_RGBA, GL_UNSIGNED_BYTE, frame.pixels.data());
+		}
+		glEnable(GL_BLEND);
+		Metrics::add(COUNTER_DRAW_CALLS);
+		glutSwapBuffers();
+		return;
+	}
+	ScopedTimer frameTimer(PHASE_FRAME_RENDER);
+	TraceScope trace("frame", "render");
+	Metrics::add(COUNTER_FRAMES);
+	vector<LayerHandle> layers = g_Layers.snapshot();
+	double left, right, bottom, top;
+	g_Camera.getOrtho(left, right, bottom, top);
+	glOrtho(left, right, bottom, top, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
-	/// render all shapes
-	for (int i = 0; i < g_Shapefiles.size(); i++){
-		g_Shapefiles[i].render();
+	/// render all shapes, batched
+	vec4 view = g_Camera.getView();
+	float worldPerPixel = (float)g_Camera.getWorldPerPixel();
+	g_DrawList.clear();
+	for (int i = 0; i < layers.size(); i++){
+		if (layers[i]->isVisible())
+			layers[i]->addDrawItems(g_DrawList, i, view, worldPerPixel);
 	}
-	glFlush();
+	g_DrawList.finish();
+	g_GLState.invalidate();
+	g_DrawList.submit(g_GLState);
+	glutSwapBuffers();
+}
+
+/*
+	The view changes only here, and only here a redraw is asked for:
+	left drag pans, the wheel (buttons 3 and 4 in freeglut) zooms at the cursor.
+*/
+void mouseCB(int button, int state, int x, int y){
+	if (button == GLUT_LEFT_BUTTON){
+		g_Dragging = (state == GLUT_DOWN);
+		g_DragX = x;
+		g_DragY = y;
+	}
+	else if ((button == 3 || button == 4) && state == GLUT_DOWN){
+		postView(ViewCommand::make(VIEW_ZOOM, x, y, button == 3 ? 1.25 : 1 / 1.25));
+	}
+}
+
+void motionCB(int x, int y){
+	if (!g_Dragging)
+		return;
+	postView(ViewCommand::make(VIEW_PAN, x - g_DragX, y - g_DragY));
+	g_DragX = x;
+	g_DragY = y;
+}
+
+void dumpMetrics(){
+	if (!Metrics::isEnabled())
+		return;
+	if (Metrics::dumpJSON(g_MetricsFile.c_str()))
+		cout << "Metrics written to " << g_MetricsFile << endl;
+	else
+		cout << "Could not write metrics to " << g_MetricsFile << endl;
+}
+
+void writeTrace(){
+	if (Trace::write())
+		cout << "Trace written" << endl;
 }
 
 void keyCB(unsigned char key, int x, int y){
+	if (key == '+' || key == '-'){ // zoom at the centre
+		postView(ViewCommand::make(VIEW_ZOOM, g_WindowW / 2, g_WindowH / 2, key == '+' ? 1.5 : 1 / 1.5));
+	}
+	if (key >= '1' && key <= '9'){ // show/hide a layer, in drawing order
+		ViewCommand c = ViewCommand::make(VIEW_TOGGLE_LAYER);
+		c.layer = key - '1';
+		postView(c);
+	}
+	if (key == 'r' || key == 'R'){ // whole map
+		postView(ViewCommand::make(VIEW_RESET));
+	}
+	if (key == 'm' || key == 'M'){ // metrics snapshot
+		dumpMetrics();
+		cout << Metrics::toJSON();
+		if (g_DirectGL){
+			const DrawListStats& s = g_DrawList.getStats();
+			cout << "last frame: " << s.items << " items, " << s.batches << " draw calls (" << s.perEntityDrawCalls
+				<< " one by one), " << s.stateChanges << " state changes (" << s.perEntityStateChanges << " one by one)" << endl;
+		}
+	}
 	if (int(key) == 27){ // esc
 		cout << "Viewer terminating..." << endl;
-		g_Shapefiles.clear();
+		g_StopLoading = true;
+		g_Layers.clear();
 		exit(1);
 	}
 }
 
+/*
+	Before the globals go: the threads still use them. The loader finishes
+	only the layers it is reading, so exit does not wait for a whole session.
+*/
+void stopThreads(){
+	g_StopLoading = true;
+	if (g_Loader.joinable())
+		g_Loader.join();
+	g_Renderer.stop();
+}
+
+/*
+	Loads the session's layers (in parallel), adds them in session order
+	and gives the extent of them all. False if none could be opened or
+	loading was stopped.
+*/
+bool loadLayers(const MapSession& session, vec4& world){
+	vector<LayerHandle> layers = session.load(true, &g_StopLoading);
+	if (g_StopLoading)
+		return false;
+	if (layers.empty()){
+		cout << "No layer of " << g_SessionFile << " could be opened" << endl;
+		return false;
+	}
+	for (size_t i = 0; i < layers.size(); i++){
+		g_Layers.add(layers[i]);
+		vec4 b = layers[i]->getBoundaries();
+		if (i == 0)
+			world = b;
+		world = vec4(min(world.x, b.x), min(world.y, b.y), max(world.z, b.z), max(world.w, b.w));
+	}
+	return true;
+}
+
 int main(int argc, char** argv)
 {
+	// -bench <name> <layer>: console benchmark, no window
+	if (argc >= 4 && string(argv[1]) == "-bench")
+		return runBenchmark(argv[2], argv[3]);
+
 	glutInit(&argc, argv);
-	glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);
+	// -metrics [file.json]: collect load/render counters, dumped on 'm' and at exit
+	for (int i = 1; i < argc; i++){
+		if (string(argv[i]) == "-metrics"){
+			Metrics::setEnabled(true);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				g_MetricsFile = argv[++i];
+			atexit(dumpMetrics);
+		}
+		// -trace [file.json]: Chrome trace-event timeline of loading and rendering, written at exit
+		else if (string(argv[i]) == "-trace"){
+			Trace::start((i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "trace.json");
+			Trace::setThreadName("main");
+			atexit(writeTrace);
+		}
+		// -direct: draw every layer with GL each frame instead of compositing cached layer images
+		else if (string(argv[i]) == "-direct")
+			g_DirectGL = true;
+		// -budget ms: drawing time per frame, 0 to finish every frame before showing it
+		else if (string(argv[i]) == "-budget" && i + 1 < argc)
+			g_FrameBudgetMs = atof(argv[++i]);
+		// -decimate px: hairline vertices closer than this on screen are dropped, 0 keeps them all
+		else if (string(argv[i]) == "-decimate" && i + 1 < argc)
+			ShapeFile::setDecimation((float)atof(argv[++i]));
+		// -hilbert: lay each layer's features out along a Hilbert curve, nearby ones together in memory
+		else if (string(argv[i]) == "-hilbert")
+			ShapeFile::setSpatialOrder(true);
+		// -session file.thuban: the map to open
+		else if (string(argv[i]) == "-session" && i + 1 < argc)
+			g_SessionFile = argv[++i];
+	}
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
 	glutInitWindowSize(600, 600);
 	glutCreateWindow("ShapeFile Viewer");
 	initializeGL();
 
-	g_Shapefiles.push_back(*(new ShapeFile("Shapefiles\\strassen"))); //line
-	g_Shapefiles.push_back(*(new ShapeFile("Shapefiles\\poi"))); //point
-	g_Shapefiles.push_back(*(new ShapeFile("Shapefiles\\gruenflaechen"))); //polygon
-	shpBoundaries = g_Shapefiles[0].getBoundaries();
+	MapSession session;
+	if (!session.open(g_SessionFile)){
+		cout << "Could not read session " << g_SessionFile << endl;
+		return 1;
+	}
+	if (!session.getTitle().empty())
+		glutSetWindowTitle(session.getTitle().c_str());
+	glClearColor(1.0, 1.0, 1.0, 0.0); // sessions are styled for Thuban's white canvas
+
+	if (g_DirectGL){
+		if (!loadLayers(session, shpBoundaries))
+			return 1;
+		g_Camera.setViewport(g_WindowW, g_WindowH);
+		g_Camera.setWorld(shpBoundaries);
+	}
+	else {
+		// the window is up (empty) at once; the map appears when its layers are in
+		atexit(stopThreads);
+		g_Renderer.post(ViewCommand::make(VIEW_RESIZE, g_WindowW, g_WindowH));
+		g_Renderer.start(vec4(1, 1, 1, 1), g_FrameBudgetMs);
+		g_Loader = thread([session]{
+			Trace::setThreadName("loader");
+			ViewCommand c = ViewCommand::make(VIEW_WORLD);
+			if (loadLayers(session, c.world))
+				g_Renderer.post(c);
+		});
+		glutTimerFunc(4, frameTimerCB, 0);
+	}
 
 	glutKeyboardFunc(keyCB);
+	glutMouseFunc(mouseCB);
+	glutMotionFunc(motionCB);
 	glutReshapeFunc(resizeGL);
 	glutDisplayFunc(render);
 	glutMainLoop();
@@ -0,0 +1,214 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "LayerAttributes.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Parallel.h"
+#include <unordered_map>
+#include <ctype.h>
+
+using namespace std;
+
+static const int rowsPerTask = 4096;
+
+static AttributeColumn makeColumn(const DBFField& f, int nRows, const string& joinedFrom, const string& codePage){
+	AttributeColumn c;
+	c.codePage = codePage;
+	c.name = f.name;
+	c.type = f.type;
+	c.joinedFrom = joinedFrom;
+	if (c.isNumeric())
+		c.numbers.resize(nRows);
+	else
+		c.strings.resize(nRows);
+	return c;
+}
+
+shared_ptr<LayerAttributes> LayerAttributes::load(const string& basename){
+	TraceScope trace("attributes", "load");
+	shared_ptr<MappedDBF> table(new MappedDBF());
+	if (!table->open(basename))
+		return shared_ptr<LayerAttributes>();
+	ScopedTimer timer(PHASE_DBF_READ);
+
+	shared_ptr<LayerAttributes> attrs(new LayerAttributes());
+	attrs->nRows = table->getRecordCount();
+	const DBFSchema& schema = table->getSchema();
+	for (size_t f = 0; f < schema.fields.size(); f++)
+		attrs->columns.push_back(makeColumn(schema.fields[f], attrs->nRows, string(), table->getCodePage()));
+
+	vector<AttributeColumn>& columns = attrs->columns;
+	const MappedDBF& t = *table;
+	parallelFor(attrs->nRows, rowsPerTask, [&](int begin, int end){
+		for (int i = begin; i < end; i++)
+			for (size_t f = 0; f < columns.size(); f++){
+				if (columns[f].isNumeric())
+					columns[f].numbers[i] = t.getDouble(i, (int)f);
+				else
+					columns[f].strings[i] = t.getString(i, (int)f);
+			}
+	});
+	attrs->tables.push_back(table);
+	attrs->basename = basename;
+	return attrs;
+}
+
+int LayerAttributes::findColumn(const string& name) const{
+	for (size_t c = 0; c < columns.size(); c++){
+		const string& n = columns[c].name;
+		if (n.size() != name.size())
+			continue;
+		size_t j = 0;
+		while (j < n.size() && toupper((unsigned char)n[j]) == toupper((unsigned char)name[j]))
+			j++;
+		if (j == n.size())
+			return (int)c;
+	}
+	return -1;
+}
+
+bool LayerAttributes::join(const shared_ptr<const MappedDBF>& side, const string& sideName,
+	const string& key, const string& sideKey){
+	int k = findColumn(key);
+	int sk = side->getSchema().findField(sideKey);
+	if (k < 0 || sk < 0)
+		return false;
+	TraceScope trace("join", "load");
+	ScopedTimer timer(PHASE_INDEX_BUILD);
+
+	// hash index on the side key; the first live record wins, as a lookup table
+	bool numeric = columns[k].isNumeric();
+	unordered_map<double, int> numberIndex;
+	unordered_map<StrView, int, StrViewHash> textIndex;
+	for (int r = 0; r < side->getRecordCount(); r++){
+		if (side->isDeleted(r))
+			continue;
+		if (numeric)
+			numberIndex.insert(make_pair(side->getDouble(r, sk), r));
+		else
+			textIndex.insert(make_pair(side->getString(r, sk), r));
+	}
+
+	const DBFSchema& sideSchema = side->getSchema();
+	vector<int> sideFields;
+	size_t firstNew = columns.size();
+	for (size_t f = 0; f < sideSchema.fields.size(); f++){
+		if ((int)f == sk)
+			continue;
+		sideFields.push_back((int)f);
+		columns.push_back(makeColumn(sideSchema.fields[f], nRows, sideName, side->getCodePage()));
+	}
+
+	// probe and gather, rows split across threads
+	const AttributeColumn& keyColumn = columns[k]; // after the push_backs above
+	const MappedDBF& s = *side;
+	parallelFor(nRows, rowsPerTask, [&](int begin, int end){
+		for (int i = begin; i < end; i++){
+			int match = -1;
+			if (numeric){
+				unordered_map<double, int>::const_iterator it = numberIndex.find(keyColumn.numbers[i]);
+				if (it != numberIndex.end())
+					match = it->second;
+			}
+			else{
+				unordered_map<StrView, int, StrViewHash>::const_iterator it = textIndex.find(keyColumn.strings[i]);
+				if (it != textIndex.end())
+					match = it->second;
+			}
+			if (match < 0)
+				continue; // columns start out as 0 / empty
+			for (size_t j = 0; j < sideFields.size(); j++){
+				AttributeColumn& c = columns[firstNew + j];
+				if (c.isNumeric())
+					c.numbers[i] = s.getDouble(match, sideFields[j]);
+				else
+					c.strings[i] = s.getString(match, sideFields[j]);
+			}
+		}
+	});
+	tables.push_back(side);
+	return true;
+}
+
+int LayerAttributes::joinSideTables(const string& basename){
+	static const char* suffixes[] = { "_namen", "_typen" };
+	const int nSuffixes = 2;
+
+	vector<shared_ptr<MappedDBF> > sides(nSuffixes);
+	vector<thread> openers;
+	for (int i = 0; i < nSuffixes; i++){
+		openers.push_back(thread([&, i]{
+			shared_ptr<MappedDBF> t(new MappedDBF());
+			if (t->open(basename + suffixes[i]))
+				sides[i] = t;
+		}));
+	}
+	for (int i = 0; i < nSuffixes; i++)
+		openers[i].join();
+
+	size_t slash = basename.find_last_of("/\\");
+	string layerName = (slash == string::npos) ? basename : basename.substr(slash + 1);
+	int joined = 0;
+	for (int i = 0; i < nSuffixes; i++){
+		if (!sides[i] || sides[i]->getSchema().fields.empty())
+			continue;
+		const string& key = sides[i]->getSchema().fields[0].name;
+		if (!join(sides[i], layerName + suffixes[i], key, key))
+			continue;
+		if (string(suffixes[i]) == "_typen")
+			typeColumn = findColumn(key);
+		joined++;
+	}
+	return joined;
+}
+
+/*
+	Size, write time and 32-byte header (record count, last update date) of
+	every table the columns came from, so an index goes stale when any of
+	them changes, including edits that keep the file size.
+*/
+unsigned long long LayerAttributes::sourceStamp() const{
+	unsigned long long h = 14695981039346656037ull;
+	for (size_t i = 0; i < tables.size(); i++){
+		const MappedDBF& t = *tables[i];
+		unsigned long long words[2] = { t.getFileSize(), t.getModTime() };
+		const unsigned char* bytes = (const unsigned char*)words;
+		for (size_t j = 0; j < sizeof(words); j++){
+			h ^= bytes[j];
+			h *= 1099511628211ull;
+		}
+		const unsigned char* header = t.getHeader();
+		for (size_t j = 0; j < 32; j++){
+			h ^= header[j];
+			h *= 1099511628211ull;
+		}
+	}
+	return h;
+}
+
+shared_ptr<const AttributeIndex> LayerAttributes::getIndex(int c) const{
+	if (c < 0 || c >= (int)columns.size())
+		return shared_ptr<const AttributeIndex>();
+	lock_guard<mutex> guard(indexLock);
+	if (indexes.size() != columns.size())
+		indexes.resize(columns.size());
+	if (!indexes[c]){
+		string path = basename + "." + columns[c].name + ".aix";
+		unsigned long long stamp = sourceStamp();
+		indexes[c] = AttributeIndex::load(path, *this, c, stamp);
+		if (!indexes[c]){
+			indexes[c] = AttributeIndex::build(*this, c);
+			indexes[c]->save(path, stamp); // read-only data directories just rebuild next time
+		}
+	}
+	return indexes[c];
+}
@@ -0,0 +1,91 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef LAYERATTRIBUTES_H_DEF
+#define LAYERATTRIBUTES_H_DEF
+
+#include "MappedDBF.h"
+#include "AttributeIndex.h"
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+struct AttributeColumn {
+	string name;
+	char type;                // dBase type of the source field
+	vector<double> numbers;   // 'N' and 'F' fields
+	vector<StrView> strings;  // every other type, trimmed
+	string joinedFrom;        // side table name, empty for the layer's own .dbf
+	string codePage;          // of the source table, see MappedDBF::getCodePage
+
+	bool isNumeric() const { return type == 'N' || type == 'F'; }
+};
+
+/*
+	Column store of a layer's attributes; row i belongs to shape i.
+	Holds the columns of <layer>.dbf plus columns joined in from side tables.
+	Numeric fields are parsed once, character fields are views into the
+	mapped tables, which the store keeps open.
+*/
+class LayerAttributes {
+public:
+	// NULL if <basename>.dbf cannot be opened.
+	static shared_ptr<LayerAttributes> load(const string& basename);
+
+	/*
+		Hash join: adds every column of side except sideKey, taking for each row
+		the side record whose sideKey equals the row's key column. Numeric keys
+		compare by value, others by trimmed text. Rows without a match get 0 or
+		an empty string. Returns false if either key column is missing.
+	*/
+	bool join(const shared_ptr<const MappedDBF>& side, const string& sideName, const string& key, const string& sideKey);
+
+	/*
+		The side tables of the sample data: <basename>_namen.dbf and
+		<basename>_typen.dbf, joined on their first field. The tables are opened
+		in parallel. Returns the number of tables joined.
+	*/
+	int joinSideTables(const string& basename);
+	// The key column <basename>_typen.dbf was joined on (the feature type id), -1 if none.
+	int getTypeColumn() const { return typeColumn; }
+
+	int getRowCount() const { return nRows; }
+	int getColumnCount() const { return (int)columns.size(); }
+	const AttributeColumn& getColumn(int c) const { return columns[c]; }
+	// Case-insensitive. Returns -1 if not found.
+	int findColumn(const string& name) const;
+
+	/*
+		Index of a column, built on first use (in parallel) and saved as
+		<basename>.<column>.aix; later runs load that file while the tables
+		it was built from keep their size, write time and header.
+	*/
+	shared_ptr<const AttributeIndex> getIndex(int c) const;
+
+	double getNumber(int c, int row) const { return columns[c].isNumeric() ? columns[c].numbers[row] : 0.0; }
+	StrView getString(int c, int row) const { return columns[c].isNumeric() ? StrView() : columns[c].strings[row]; }
+
+private:
+	int nRows;
+	int typeColumn;
+	vector<AttributeColumn> columns;
+	vector<shared_ptr<const MappedDBF> > tables; // owners of the string views
+	string basename;
+
+	mutable mutex indexLock;
+	mutable vector<shared_ptr<const AttributeIndex> > indexes;
+
+	LayerAttributes() : nRows(0), typeColumn(-1) {}
+	unsigned long long sourceStamp() const;
+};
+
+#endif
@@ -0,0 +1,248 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "LayerCompositor.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+using namespace std;
+
+static const double coarseExtentPixels = 16; // parts at least this large make the coarse image
+static const size_t trianglesPerSlice = 2048;
+static const size_t partsPerSlice = 256;
+
+/*
+	Draws the layer into rectangle r of its image. Shapes are culled
+	against r widened by the reach of the layer's marks (points, symbols,
+	stroke width), so marks centred just outside still reach in.
+*/
+void LayerCompositor::drawRect(CachedLayer& c, ShapeFile& layer, const PixelRect& r){
+	fillRect(c.image, r, 0);
+	SoftRenderer target(c.image, r, c.left, c.bottom, c.scale);
+	double margin = (layer.getMarkRadius() + 4) * c.scale;
+	vec4 view((float)(c.left + r.x0 * c.scale - margin), (float)(c.bottom + r.y0 * c.scale - margin),
+		(float)(c.left + r.x1 * c.scale + margin), (float)(c.bottom + r.y1 * c.scale + margin));
+	layer.rasterize(target, view, (float)c.scale);
+}
+
+// dst, sized w x h, shows src (drawn for srcLeft, srcBottom, srcScale) from the view left, bottom, scale.
+static void resampleInto(RasterImage& dst, const RasterImage& src, double srcLeft, double srcBottom, double srcScale,
+	int w, int h, double left, double bottom, double scale){
+	if (dst.width != w || dst.height != h)
+		dst.resize(w, h);
+	resampleImage(src, srcLeft, srcBottom, srcScale, dst, left, bottom, scale);
+}
+
+/*
+	A new image for the camera's view: the preview is made from what is on
+	screen now, the parts to draw are put in coarse-to-fine order.
+*/
+void LayerCompositor::startJob(CachedLayer& c, ShapeFile& layer, const Camera& camera){
+	RefineJob& job = c.job;
+	int w = camera.getWidth(), h = camera.getHeight();
+	double left, right, bottom, top;
+	camera.getOrtho(left, right, bottom, top);
+	double scale = camera.getWorldPerPixel();
+
+	// the preview is whatever is on screen now, seen from the new view
+	bool hasPreview = c.valid || job.active;
+	if (hasPreview){
+		if (!job.active)
+			resampleInto(c.preview, c.image, c.left, c.bottom, c.scale, w, h, left, bottom, scale);
+		else if (job.showWork)
+			resampleInto(c.preview, c.work, job.left, job.bottom, job.scale, w, h, left, bottom, scale);
+		else {
+			// work is free until it is cleared below
+			resampleInto(c.work, c.preview, c.previewLeft, c.previewBottom, c.previewScale, w, h, left, bottom, scale);
+			swap(c.preview, c.work);
+		}
+		c.previewLeft = left;
+		c.previewBottom = bottom;
+		c.previewScale = scale;
+	}
+	job.left = left;
+	job.bottom = bottom;
+	job.scale = scale;
+	job.geometry = layer.getGeometry().get();
+	job.styleRevision = layer.getStyleRevision();
+	if (c.work.width != w || c.work.height != h)
+		c.work.resize(w, h);
+	else
+		fillRect(c.work, PixelRect(0, 0, w, h), 0);
+
+	const LayerGeometry& geom = *job.geometry;
+	double margin = (layer.getMarkRadius() + 4) * scale;
+	vec4 view((float)(left - margin), (float)(bottom - margin), (float)(right + margin), (float)(top + margin));
+	VisibleParts visible;
+	if (layer.getStyle().hasStroke())
+		selectVisibleParts(geom, view, (float)job.scale, visible);
+	Metrics::add(COUNTER_PARTS_CULLED, visible.culled);
+	job.parts.swap(visible.detailed);
+	if (!geom.partBounds.empty()){
+		const vec4* b = geom.partBounds.data();
+		stable_sort(job.parts.begin(), job.parts.end(), [b](int p, int q){
+			return max(b[p].z - b[p].x, b[p].w - b[p].y) > max(b[q].z - b[q].x, b[q].w - b[q].y);
+		});
+	}
+	job.nDetailed = job.parts.size();
+	job.nCoarse = 0;
+	float coarse = (float)(coarseExtentPixels * job.scale);
+	while (job.nCoarse < job.nDetailed && !geom.partBounds.empty()){
+		const vec4& b = geom.partBounds[job.parts[job.nCoarse]];
+		if (max(b.z - b.x, b.w - b.y) < coarse)
+			break;
+		job.nCoarse++;
+	}
+	job.parts.insert(job.parts.end(), visible.dots.begin(), visible.dots.end());
+	job.nTriangles = layer.getFillTriangleCount();
+	job.trianglesDone = job.partsDone = 0;
+	job.showWork = !hasPreview;
+	job.active = true;
+}
+
+/*
+	Draws slices of the job until it is done or the deadline (0: none) has
+	passed. A layer reached after the deadline waits for the next frame.
+*/
+void LayerCompositor::runJob(CachedLayer& c, ShapeFile& layer, long long deadline){
+	RefineJob& job = c.job;
+	SoftRenderer target(c.work, PixelRect(0, 0, c.work.width, c.work.height), job.left, job.bottom, job.scale);
+	for (;;){
+		if (deadline && Metrics::nowNs() > deadline)
+			return;
+		if (job.trianglesDone < job.nTriangles){
+			size_t n = min(trianglesPerSlice, job.nTriangles - job.trianglesDone);
+			layer.rasterizeFill(target, job.trianglesDone, n);
+			job.trianglesDone += n;
+		}
+		else if (job.partsDone < job.parts.size()){
+			bool dots = job.partsDone >= job.nDetailed;
+			size_t end = min(job.partsDone + partsPerSlice, dots ? job.parts.size() : job.nDetailed);
+			layer.rasterizeParts(target, &job.parts[job.partsDone], end - job.partsDone, dots);
+			job.partsDone = end;
+		}
+		else
+			break;
+		if (job.trianglesDone == job.nTriangles && job.partsDone >= job.nCoarse)
+			job.showWork = true;
+	}
+	swap(c.image, c.work);
+	c.left = job.left;
+	c.bottom = job.bottom;
+	c.scale = job.scale;
+	c.geometry = job.geometry;
+	c.styleRevision = job.styleRevision;
+	c.valid = true;
+	job.active = false;
+	stats.fullRedraws++;
+	Metrics::add(COUNTER_LAYER_REDRAWS);
+}
+
+void LayerCompositor::update(CachedLayer& c, ShapeFile& layer, const Camera& camera, long long deadline){
+	int w = camera.getWidth(), h = camera.getHeight();
+	double left, right, bottom, top;
+	camera.getOrtho(left, right, bottom, top);
+	double scale = camera.getWorldPerPixel();
+	const LayerGeometry* geometry = layer.getGeometry().get();
+	unsigned int revision = layer.getStyleRevision();
+
+	if (c.job.active){
+		RefineJob& job = c.job;
+		if (job.left != left || job.bottom != bottom || job.scale != scale || c.work.width != w || c.work.height != h
+			|| job.geometry != geometry || job.styleRevision != revision)
+			startJob(c, layer, camera); // stale
+		runJob(c, layer, deadline);
+		return;
+	}
+
+	bool full = !c.valid || c.image.width != w || c.image.height != h || c.scale != scale
+		|| c.geometry != geometry || c.styleRevision != revision;
+	int dx = 0, dy = 0;
+	if (!full){
+		// where the image content has to move; pans are whole pixels, anything else is a redraw
+		double sx = (c.left - left) / scale, sy = (c.bottom - bottom) / scale;
+		dx = (int)floor(sx + 0.5);
+		dy = (int)floor(sy + 0.5);
+		full = fabs(sx - dx) > 1e-3 || fabs(sy - dy) > 1e-3 || abs(dx) >= w || abs(dy) >= h;
+	}
+	if (full){
+		startJob(c, layer, camera);
+		runJob(c, layer, deadline);
+		return;
+	}
+	if (dx == 0 && dy == 0){
+		stats.reused++;
+		return;
+	}
+	// stay on the lattice the rest of the image was drawn on
+	c.left -= dx * c.scale;
+	c.bottom -= dy * c.scale;
+	shiftImage(c.image, dx, dy);
+	// the uncovered columns over the full height, then the uncovered rows beside them
+	PixelRect cols = dx > 0 ? PixelRect(0, 0, dx, h) : PixelRect(w + dx, 0, w, h);
+	PixelRect rows = dy > 0 ? PixelRect(0, 0, w, dy) : PixelRect(0, h + dy, w, h);
+	if (dx > 0)
+		rows.x0 = dx;
+	else
+		rows.x1 = w + dx;
+	if (!cols.empty())
+		drawRect(c, layer, cols);
+	if (!rows.empty())
+		drawRect(c, layer, rows);
+	stats.stripRedraws++;
+	Metrics::add(COUNTER_STRIP_REDRAWS);
+}
+
+const RasterImage& LayerCompositor::compose(const vector<LayerHandle>& layers, const Camera& camera, double budgetMs){
+	TraceScope trace("compose", "render");
+	long long t0 = Metrics::nowNs();
+	long long deadline = budgetMs > 0 ? t0 + (long long)(budgetMs * 1e6) : 0;
+	stats.fullRedraws = stats.stripRedraws = stats.reused = stats.refining = 0;
+	for (unordered_map<int, CachedLayer>::iterator it = cache.begin(); it != cache.end(); ++it)
+		it->second.seen = false;
+
+	vector<const RasterImage*> images;
+	for (size_t i = 0; i < layers.size(); i++){
+		CachedLayer& c = cache[layers[i]->getID()];
+		c.seen = true;
+		if (!layers[i]->isVisible())
+			continue;
+		update(c, *layers[i], camera, deadline);
+		if (c.job.active)
+			stats.refining++;
+		images.push_back(&c.shown());
+	}
+	// band by band, so a band stays in cache while every layer is blended into it
+	if (frame.width != camera.getWidth() || frame.height != camera.getHeight())
+		frame.resize(camera.getWidth(), camera.getHeight());
+	parallelFor(frame.height, 64, [&](int y0, int y1){
+		for (int y = y0; y < y1; y += 16){
+			int end = min(y + 16, y1);
+			fillRect(frame, PixelRect(0, y, frame.width, end), background);
+			for (size_t i = 0; i < images.size(); i++)
+				if (images[i]->width == frame.width && images[i]->height == frame.height)
+					blendOver(frame, *images[i], y, end);
+		}
+	});
+
+	for (unordered_map<int, CachedLayer>::iterator it = cache.begin(); it != cache.end();){
+		if (it->second.seen)
+			++it;
+		else
+			it = cache.erase(it);
+	}
+	stats.ms = (Metrics::nowNs() - t0) / 1e6;
+	return frame;
+}
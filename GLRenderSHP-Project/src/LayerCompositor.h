@@ -0,0 +1,104 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef LAYERCOMPOSITOR_H_DEF
+#define LAYERCOMPOSITOR_H_DEF
+
+#include "LayerRegistry.h"
+#include "Camera.h"
+#include "SoftRaster.h"
+#include <unordered_map>
+
+using namespace std;
+
+struct CompositorStats {
+	int fullRedraws;   // layers whose new image was finished
+	int stripRedraws;  // layers shifted, with only the uncovered strips drawn
+	int reused;        // layers whose image was still right
+	int refining;      // layers still being drawn for the current view
+	double ms;
+};
+
+/*
+	Frame = background + one cached image per layer, blended in draw order.
+	A layer's image is kept with the view it was drawn for:
+	- a pan by whole pixels shifts the image and draws only the strips that
+	  came into view,
+	- a zoom, resize or style change (ShapeFile::getStyleRevision) redraws
+	  that layer alone,
+	- hiding or showing a layer only blends again.
+	Images of layers no longer registered are dropped.
+
+	Redraws are progressive. The old image, resampled to the new view, is
+	shown at once; meanwhile the new one is drawn coarse to fine (fills,
+	then parts from the largest down, sub-pixel parts last) and replaces
+	the preview as soon as the large parts are in. compose() stops drawing
+	when its time budget is spent and carries on in the next call; a view
+	change in between drops the unfinished work and starts over.
+*/
+class LayerCompositor {
+public:
+	LayerCompositor() : background(0), stats() {}
+
+	void setBackground(const vec4& rgba) { background = packColor(rgba); }
+	// budgetMs <= 0 draws everything before returning.
+	const RasterImage& compose(const vector<LayerHandle>& layers, const Camera& camera, double budgetMs = 0);
+	// True while some layer shows less than its final image; call compose() again.
+	bool isRefining() const { return stats.refining > 0; }
+	const RasterImage& getFrame() const { return frame; }
+	const CompositorStats& getStats() const { return stats; }
+	void clear() { cache.clear(); }
+
+private:
+	struct RefineJob {
+		bool active;
+		bool showWork;          // work is further along than the preview
+		double left, bottom, scale;
+		const LayerGeometry* geometry;
+		unsigned int styleRevision;
+		vector<int> parts;      // detailed parts, largest first, then the dots
+		size_t nDetailed;
+		size_t nCoarse;         // parts needed before work is shown
+		size_t nTriangles, trianglesDone, partsDone;
+
+		RefineJob() : active(false), showWork(false), left(0), bottom(0), scale(0), geometry(NULL), styleRevision(0),
+			nDetailed(0), nCoarse(0), nTriangles(0), trianglesDone(0), partsDone(0) {}
+	};
+
+	struct CachedLayer {
+		RasterImage image;      // finished, for the view below
+		RasterImage work;       // being drawn for job's view
+		RasterImage preview;    // shown while work is too coarse
+		const LayerGeometry* geometry;
+		unsigned int styleRevision;
+		double left, bottom, scale;
+		double previewLeft, previewBottom, previewScale;
+		bool valid;
+		bool seen;
+		RefineJob job;
+
+		CachedLayer() : geometry(NULL), styleRevision(0), left(0), bottom(0), scale(0),
+			previewLeft(0), previewBottom(0), previewScale(0), valid(false), seen(false) {}
+		const RasterImage& shown() const { return !job.active ? image : (job.showWork ? work : preview); }
+	};
+
+	unordered_map<int, CachedLayer> cache; // by layer id
+	RasterImage frame;
+	unsigned int background;
+	CompositorStats stats;
+
+	void update(CachedLayer& c, ShapeFile& layer, const Camera& camera, long long deadline);
+	void drawRect(CachedLayer& c, ShapeFile& layer, const PixelRect& r);
+	void startJob(CachedLayer& c, ShapeFile& layer, const Camera& camera);
+	void runJob(CachedLayer& c, ShapeFile& layer, long long deadline);
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef LAYERGEOMETRY_H_DEF
+#define LAYERGEOMETRY_H_DEF
+
+#include "Vectors.h"
+#include <vector>
+#include <string>
+
+using namespace std;
+
+/*
+	Geometry of a loaded shapefile, stored flat: all vertices of all parts in
+	one array, and part p spanning points[partStart[p]] .. points[partStart[p+1]-1].
+	A point layer has one part per point record.
+
+	Parts are in .shp record order, or, when the layer was loaded with
+	spatial ordering (SpatialOrder.h), in the order of a Hilbert curve over
+	the layer; either way the parts of a record are consecutive and in their
+	order, and partShape gives the record (the .dbf row) of each part.
+
+	It is never modified after loading, so it is shared (not copied) between
+	layers, views and threads.
+*/
+struct LayerGeometry {
+	static const int partBlockSize = 64;
+
+	string filename;
+	int shpType;
+	vec2 boundBoxMin, boundBoxMax;
+
+	vector<vec3> points;
+	vector<unsigned int> partStart; // nParts + 1 entries
+	vector<int> partShape;          // record id of each part
+	vector<vec4> partBounds;        // (minX, minY, maxX, maxY) of each part
+	vector<vec4> blockBounds;       // of each run of partBlockSize parts, for skipping them in view queries
+
+	LayerGeometry() : shpType(0) { partStart.push_back(0); }
+
+	int getPartCount() const { return (int)partShape.size(); }
+	int getPartSize(int p) const { return (int)(partStart[p + 1] - partStart[p]); }
+	const vec3* getPart(int p) const { return points.data() + partStart[p]; }
+};
+
+#endif
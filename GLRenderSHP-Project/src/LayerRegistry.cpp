@@ -0,0 +1,71 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "LayerRegistry.h"
+
+using namespace std;
+
+LayerRegistry::LayerRegistry() : nextID(1){
+}
+
+int LayerRegistry::add(const LayerHandle& layer){
+	lock_guard<mutex> guard(lock);
+	int id = nextID++;
+	layer->setID(id);
+	layers.push_back(make_pair(id, layer));
+	byID[id] = --layers.end();
+	return id;
+}
+
+bool LayerRegistry::remove(int id){
+	lock_guard<mutex> guard(lock);
+	unordered_map<int, LayerList::iterator>::iterator it = byID.find(id);
+	if (it == byID.end())
+		return false;
+	layers.erase(it->second);
+	byID.erase(it);
+	return true;
+}
+
+void LayerRegistry::clear(){
+	lock_guard<mutex> guard(lock);
+	layers.clear();
+	byID.clear();
+}
+
+LayerHandle LayerRegistry::get(int id) const{
+	lock_guard<mutex> guard(lock);
+	unordered_map<int, LayerList::iterator>::const_iterator it = byID.find(id);
+	if (it == byID.end())
+		return LayerHandle();
+	return it->second->second;
+}
+
+LayerHandle LayerRegistry::first() const{
+	lock_guard<mutex> guard(lock);
+	if (layers.empty())
+		return LayerHandle();
+	return layers.front().second;
+}
+
+size_t LayerRegistry::size() const{
+	lock_guard<mutex> guard(lock);
+	return layers.size();
+}
+
+vector<LayerHandle> LayerRegistry::snapshot() const{
+	lock_guard<mutex> guard(lock);
+	vector<LayerHandle> out;
+	out.reserve(layers.size());
+	for (LayerList::const_iterator it = layers.begin(); it != layers.end(); ++it)
+		out.push_back(it->second);
+	return out;
+}
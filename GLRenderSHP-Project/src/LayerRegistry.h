@@ -0,0 +1,57 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef LAYERREGISTRY_H_DEF
+#define LAYERREGISTRY_H_DEF
+
+#include "ShapeFile.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+typedef shared_ptr<ShapeFile> LayerHandle;
+
+/*
+	Ordered set of layers (first added is drawn first).
+	Layers are held by handle, so adding or removing one never copies
+	or moves the others, and a layer removed while a renderer still holds
+	a snapshot stays alive until that snapshot is dropped.
+*/
+class LayerRegistry {
+public:
+	LayerRegistry();
+
+	int add(const LayerHandle& layer); // returns the layer id
+	bool remove(int id);
+	void clear();
+
+	LayerHandle get(int id) const;
+	LayerHandle first() const;
+	size_t size() const;
+
+	// Copy of the handles in draw order, safe to iterate without holding the lock
+	vector<LayerHandle> snapshot() const;
+
+private:
+	typedef list<pair<int, LayerHandle> > LayerList;
+
+	mutable mutex lock;
+	LayerList layers;
+	unordered_map<int, LayerList::iterator> byID;
+	int nextID;
+
+	LayerRegistry(const LayerRegistry&);
+	LayerRegistry& operator=(const LayerRegistry&);
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef LAYERSTYLE_H_DEF
+#define LAYERSTYLE_H_DEF
+
+#include "Vectors.h"
+
+enum LineJoin { JOIN_MITER, JOIN_ROUND, JOIN_BEVEL };
+enum LineCap { CAP_BUTT, CAP_ROUND, CAP_SQUARE };
+
+/*
+	How a layer is drawn. Colours are RGBA in [0, 1]; alpha 0 means none,
+	as a Thuban "None".
+*/
+struct LayerStyle {
+	vec4 fill;
+	vec4 stroke;
+	float strokeWidth; // pixels
+	// Used by strokes wider than a hairline (see isWide); defaults as SVG.
+	LineJoin join;
+	LineCap cap;
+	float miterLimit;  // longest miter, in half widths; longer ones are bevelled
+
+	LayerStyle() : fill(0, 0, 0, 0), stroke(0, 0, 0, 1), strokeWidth(1), join(JOIN_MITER), cap(CAP_BUTT), miterLimit(4) {}
+
+	bool hasFill() const { return fill.w > 0; }
+	bool hasStroke() const { return stroke.w > 0; }
+	// Wide strokes are drawn as triangle meshes with joins and caps, hairlines as lines.
+	bool isWide() const { return strokeWidth > 1.5f; }
+};
+
+#endif
@@ -0,0 +1,252 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "MapSession.h"
+#include "FileIO.h"
+#include "Parallel.h"
+#include "PointSymbols.h"
+#include <stdlib.h>
+#include <map>
+
+using namespace std;
+
+/*
+	Just enough XML for session files: element names and their attributes.
+	Text, comments, the prolog and the DOCTYPE are skipped.
+*/
+struct XMLTag {
+	string name;      // "/layer" for a closing tag
+	bool selfClosing;
+	map<string, string> attrs;
+
+	string get(const char* key, const char* otherwise = "") const {
+		map<string, string>::const_iterator it = attrs.find(key);
+		return it == attrs.end() ? string(otherwise) : it->second;
+	}
+};
+
+static string unescapeXML(const string& text){
+	string out;
+	for (size_t i = 0; i < text.size(); i++){
+		if (text[i] != '&'){
+			out += text[i];
+			continue;
+		}
+		size_t semi = text.find(';', i);
+		if (semi == string::npos){
+			out += text[i];
+			continue;
+		}
+		string entity = text.substr(i + 1, semi - i - 1);
+		if (entity == "amp") out += '&';
+		else if (entity == "lt") out += '<';
+		else if (entity == "gt") out += '>';
+		else if (entity == "quot") out += '"';
+		else if (entity == "apos") out += '\'';
+		else if (!entity.empty() && entity[0] == '#'){
+			unsigned long c = entity.size() > 1 && entity[1] == 'x' ? strtoul(entity.c_str() + 2, NULL, 16) : strtoul(entity.c_str() + 1, NULL, 10);
+			// to UTF-8, the encoding of the file
+			if (c < 0x80)
+				out += (char)c;
+			else if (c < 0x800){
+				out += (char)(0xC0 | (c >> 6));
+				out += (char)(0x80 | (c & 0x3F));
+			}
+			else{
+				out += (char)(0xE0 | ((c >> 12) & 0x0F));
+				out += (char)(0x80 | ((c >> 6) & 0x3F));
+				out += (char)(0x80 | (c & 0x3F));
+			}
+		}
+		else
+			out += text.substr(i, semi - i + 1);
+		i = semi;
+	}
+	return out;
+}
+
+static bool isSpace(char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// The next tag at or after pos; false at the end of the text.
+static bool nextTag(const string& xml, size_t& pos, XMLTag& tag){
+	for (;;){
+		size_t open = xml.find('<', pos);
+		if (open == string::npos)
+			return false;
+		if (xml.compare(open, 4, "<!--") == 0){
+			size_t end = xml.find("-->", open);
+			pos = end == string::npos ? xml.size() : end + 3;
+			continue;
+		}
+		size_t close = xml.find('>', open);
+		if (close == string::npos)
+			return false;
+		pos = close + 1;
+		if (xml[open + 1] == '?' || xml[open + 1] == '!')
+			continue;
+
+		size_t i = open + 1;
+		size_t nameEnd = i;
+		while (nameEnd < close && !isSpace(xml[nameEnd]) && xml[nameEnd] != '/')
+			nameEnd++;
+		if (xml[i] == '/')
+			while (nameEnd < close && !isSpace(xml[nameEnd]))
+				nameEnd++;
+		tag.name = xml.substr(i, nameEnd - i);
+		tag.selfClosing = xml[close - 1] == '/';
+		tag.attrs.clear();
+		for (i = nameEnd; i < close;){
+			while (i < close && (isSpace(xml[i]) || xml[i] == '/'))
+				i++;
+			size_t eq = xml.find('=', i);
+			if (i >= close || eq == string::npos || eq > close)
+				break;
+			string key = xml.substr(i, eq - i);
+			while (!key.empty() && isSpace(key[key.size() - 1]))
+				key.erase(key.size() - 1);
+			size_t q = eq + 1;
+			while (q < close && isSpace(xml[q]))
+				q++;
+			if (q >= close || (xml[q] != '"' && xml[q] != '\''))
+				break;
+			size_t endQuote = xml.find(xml[q], q + 1);
+			if (endQuote == string::npos || endQuote > close)
+				break;
+			tag.attrs[key] = unescapeXML(xml.substr(q + 1, endQuote - q - 1));
+			i = endQuote + 1;
+		}
+		return true;
+	}
+}
+
+// "#rrggbb" or "None". Leaves out unchanged for anything else.
+static void parseColor(const string& text, vec4& out){
+	if (text == "None"){
+		out = vec4(0, 0, 0, 0);
+		return;
+	}
+	if (text.size() != 7 || text[0] != '#')
+		return;
+	char* end;
+	unsigned long rgb = strtoul(text.c_str() + 1, &end, 16);
+	if (*end != '\0')
+		return;
+	out = vec4(((rgb >> 16) & 0xFF) / 255.0f, ((rgb >> 8) & 0xFF) / 255.0f, (rgb & 0xFF) / 255.0f, 1.0f);
+}
+
+static void parseStyle(const XMLTag& tag, LayerStyle& style){
+	parseColor(tag.get("fill"), style.fill);
+	parseColor(tag.get("stroke"), style.stroke);
+	string width = tag.get("stroke_width");
+	if (!width.empty())
+		style.strokeWidth = (float)atof(width.c_str());
+}
+
+// Relative file names are relative to the session file; the extension goes.
+static string resolveLayerPath(const string& sessionPath, string filename){
+	for (size_t i = 0; i < filename.size(); i++)
+		if (filename[i] == '\\')
+			filename[i] = '/';
+	bool absolute = !filename.empty() && (filename[0] == '/' || (filename.size() > 1 && filename[1] == ':'));
+	if (!absolute){
+		size_t slash = sessionPath.find_last_of("/\\");
+		if (slash != string::npos)
+			filename = sessionPath.substr(0, slash + 1) + filename;
+	}
+	size_t dot = filename.find_last_of('.');
+	if (dot != string::npos && filename.find_first_of("/\\", dot) == string::npos)
+		filename.erase(dot);
+	return filename;
+}
+
+bool MapSession::open(const string& path){
+	title.clear();
+	layers.clear();
+	MappedFile file;
+	if (!file.open(path.c_str()))
+		return false;
+	string xml((const char*)file.data(), (size_t)file.size());
+	file.close();
+
+	map<string, string> sources; // fileshapesource id -> filename
+	bool inLayer = false, inNullGroup = false, sawSession = false;
+	XMLTag tag;
+	for (size_t pos = 0; nextTag(xml, pos, tag);){
+		if (tag.name == "session"){
+			sawSession = true;
+			title = tag.get("title");
+		}
+		else if (tag.name == "map" && tag.attrs.count("title"))
+			title = tag.get("title");
+		else if (tag.name == "fileshapesource")
+			sources[tag.get("id")] = tag.get("filename");
+		else if (tag.name == "layer"){
+			string filename = tag.get("filename");
+			if (filename.empty() && sources.count(tag.get("shapestore")))
+				filename = sources[tag.get("shapestore")];
+			inLayer = !tag.selfClosing;
+			if (filename.empty()){
+				inLayer = false;
+				continue;
+			}
+			SessionLayer layer;
+			layer.title = tag.get("title");
+			layer.visible = tag.get("visible", "true") != "false";
+			layer.basename = resolveLayerPath(path, filename);
+			parseStyle(tag, layer.style);
+			layers.push_back(layer);
+		}
+		else if (tag.name == "/layer")
+			inLayer = false;
+		else if (tag.name == "clnull")
+			inNullGroup = !tag.selfClosing;
+		else if (tag.name == "/clnull")
+			inNullGroup = false;
+		else if (tag.name == "cldata" && inLayer && inNullGroup)
+			parseStyle(tag, layers.back().style);
+	}
+	return sawSession;
+}
+
+vector<LayerHandle> MapSession::load(bool parallel, const atomic<bool>* cancel) const{
+	int n = (int)layers.size();
+	vector<LayerHandle> loaded(n);
+	auto loadLayer = [&](int i){
+		if (cancel && *cancel)
+			return;
+		const SessionLayer& layer = layers[i];
+		loaded[i] = ShapeFile::open(layer.basename.c_str());
+		if (!loaded[i])
+			return;
+		loaded[i]->setStyle(layer.style);
+		loaded[i]->setVisible(layer.visible);
+		int type = loaded[i]->getGeometry()->shpType;
+		if (type == SHPT_POINT || type == SHPT_POINTZ || type == SHPT_MULTIPOINT || type == SHPT_MULTIPOINTZ)
+			loaded[i]->setSymbols(SymbolAtlas::getDefault()); // stays a dot layer without a type column
+	};
+	if (parallel)
+		parallelForEach(n, loadLayer);
+	else
+		for (int i = 0; i < n; i++)
+			loadLayer(i);
+	vector<LayerHandle> result;
+	if (cancel && *cancel)
+		return result;
+	for (int i = 0; i < n; i++){
+		if (loaded[i])
+			result.push_back(loaded[i]);
+		else
+			cout << "Layer " << layers[i].title << ": cannot open " << layers[i].basename << endl;
+	}
+	return result;
+}
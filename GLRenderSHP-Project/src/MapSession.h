@@ -0,0 +1,59 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef MAPSESSION_H_DEF
+#define MAPSESSION_H_DEF
+
+#include "LayerRegistry.h"
+#include "LayerStyle.h"
+#include <vector>
+#include <string>
+#include <atomic>
+
+using namespace std;
+
+struct SessionLayer {
+	string title;
+	string basename; // resolved against the session's directory, no extension
+	LayerStyle style;
+	bool visible;    // visible="false" layers are loaded but start hidden
+};
+
+/*
+	A Thuban session (.thuban): the map title and its layers in drawing
+	order, bottom first, with their fill and stroke. Reads the layer
+	attributes of Thuban 0.2 files (filename, fill, stroke, stroke_width)
+	as well as later ones, whose layers name a <fileshapesource> and keep
+	the style in the <clnull> group of their classification.
+*/
+class MapSession {
+public:
+	bool open(const string& path);
+
+	const string& getTitle() const { return title; }
+	const vector<SessionLayer>& getLayers() const { return layers; }
+
+	/*
+		Loads every layer, threads taking the next unloaded layer when
+		parallel, and styles it; point layers with a type column get the
+		default POI symbols.
+		Returns them in session order; layers whose .shp, .shx or .dbf cannot
+		be read are reported and left out. Once cancel is set, no further layer is
+		started and an empty list is returned.
+	*/
+	vector<LayerHandle> load(bool parallel = true, const atomic<bool>* cancel = NULL) const;
+
+private:
+	string title;
+	vector<SessionLayer> layers;
+};
+
+#endif
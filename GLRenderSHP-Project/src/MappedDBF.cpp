@@ -0,0 +1,105 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "MappedDBF.h"
+#include "Metrics.h"
+#include <stdio.h>
+
+using namespace std;
+
+MappedDBF::MappedDBF() : nRecords(0), nDeleted(0){
+	schema.nRecords = schema.headerLength = schema.recordLength = schema.languageDriver = 0;
+}
+
+// First line of <basename>.cpg, as DBFOpenLL reads it.
+static string readCPG(const string& basename){
+	PosFile cpg;
+	if (!cpg.open((basename + ".cpg").c_str()) && !cpg.open((basename + ".CPG").c_str()))
+		return string();
+	char buf[64];
+	size_t n = cpg.readAt(0, buf, sizeof(buf));
+	size_t len = 0;
+	while (len < n && buf[len] != '\n' && buf[len] != '\r')
+		len++;
+	return string(buf, len);
+}
+
+bool MappedDBF::open(const string& basename){
+	close();
+	if (!file.open((basename + ".dbf").c_str()) && !file.open((basename + ".DBF").c_str()))
+		return false;
+	ScopedTimer timer(PHASE_DBF_READ);
+	if (!DBFSchema::parse(file.data(), (size_t)file.size(), schema)){
+		close();
+		return false;
+	}
+	codePage = readCPG(basename);
+	if (codePage.empty() && schema.languageDriver != 0){
+		char ldid[16];
+		sprintf(ldid, "LDID/%d", schema.languageDriver);
+		codePage = ldid;
+	}
+	FileOffset available = (file.size() - schema.headerLength) / schema.recordLength;
+	nRecords = (available < (FileOffset)schema.nRecords) ? (int)available : schema.nRecords;
+
+	deleted.assign((nRecords + 63) / 64, 0);
+	for (int i = 0; i < nRecords; i++){
+		if (getRecord(i)[0] == '*'){
+			deleted[i >> 6] |= 1ull << (i & 63);
+			nDeleted++;
+		}
+	}
+	return true;
+}
+
+void MappedDBF::close(){
+	file.close();
+	schema.fields.clear();
+	codePage.clear();
+	nRecords = 0;
+	nDeleted = 0;
+	deleted.clear();
+}
+
+StrView MappedDBF::getString(int record, int field) const{
+	const DBFField& f = schema.fields[field];
+	const char* p = getRecord(record) + f.offset;
+	const char* end = (const char*)memchr(p, '\0', f.width); // strncpy stops there too
+	if (end == NULL)
+		end = p + f.width;
+	while (p < end && *p == ' ')
+		p++;
+	while (end > p && end[-1] == ' ')
+		end--;
+	return StrView(p, (size_t)(end - p));
+}
+
+double MappedDBF::getDouble(int record, int field) const{
+	const DBFField& f = schema.fields[field];
+	double v;
+	parseDBFNumber(getRecord(record) + f.offset, f.width, v);
+	return v;
+}
+
+bool MappedDBF::isNull(int record, int field) const{
+	StrView v = getString(record, field);
+	switch (schema.fields[field].type){
+	case 'N':
+	case 'F':
+		return v.empty() || v[0] == '*';
+	case 'D':
+		return v.size() >= 8 && memcmp(v.data, "00000000", 8) == 0;
+	case 'L':
+		return !v.empty() && v[0] == '?';
+	default:
+		return v.empty();
+	}
+}
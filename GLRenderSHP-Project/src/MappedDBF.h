@@ -0,0 +1,71 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef MAPPEDDBF_H_DEF
+#define MAPPEDDBF_H_DEF
+
+#include "DBFReader.h"
+#include "StrView.h"
+
+using namespace std;
+
+/*
+	Read-only .dbf mapped into memory. Field values are returned as views
+	into the mapping (header + i * recordLength + field offset), so nothing is
+	copied and a value stays valid as long as the MappedDBF is open, unlike
+	DBFReadStringAttribute's shared work buffer.
+
+	Nothing changes after open(), so any number of threads can read at once.
+*/
+class MappedDBF {
+public:
+	MappedDBF();
+
+	bool open(const string& basename); // tries .dbf, then .DBF
+	void close();
+	bool isOpen() const { return file.isOpen(); }
+	FileOffset getFileSize() const { return file.size(); }
+	unsigned long long getModTime() const { return file.modTime(); }
+	// The raw header, schema.headerLength bytes (at least 32).
+	const unsigned char* getHeader() const { return file.data(); }
+
+	const DBFSchema& getSchema() const { return schema; }
+	// As DBFGetCodePage: the .cpg contents, else "LDID/<n>", else empty.
+	const string& getCodePage() const { return codePage; }
+	// Records present in the file; fewer than the header says if it is truncated.
+	int getRecordCount() const { return nRecords; }
+
+	// As DBFIsRecordDeleted, from a bitmap built at open().
+	bool isDeleted(int record) const { return (deleted[record >> 6] >> (record & 63)) & 1; }
+	int getDeletedCount() const { return nDeleted; }
+
+	// Raw record bytes, deletion flag first. No bounds check.
+	const char* getRecord(int record) const {
+		return (const char*)file.data() + schema.headerLength + (size_t)record * schema.recordLength;
+	}
+	// Field text with blanks trimmed both sides, as DBFReadStringAttribute.
+	StrView getString(int record, int field) const;
+	// As DBFReadDoubleAttribute: 0 for blank fields.
+	double getDouble(int record, int field) const;
+	int getInt(int record, int field) const { return (int)getDouble(record, field); }
+	// As DBFIsAttributeNULL.
+	bool isNull(int record, int field) const;
+
+private:
+	MappedFile file;
+	DBFSchema schema;
+	string codePage;
+	int nRecords;
+	vector<unsigned long long> deleted;
+	int nDeleted;
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Metrics.h"
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <fstream>
+#include <stdlib.h>
+
+using namespace std;
+
+atomic<bool> Metrics::enabled(false);
+atomic<long long> Metrics::counters[COUNTER_COUNT];
+atomic<long long> Metrics::phaseCalls[PHASE_COUNT];
+atomic<long long> Metrics::phaseNs[PHASE_COUNT];
+atomic<long long> Metrics::phaseMaxNs[PHASE_COUNT];
+
+void Metrics::setEnabled(bool on){
+	enabled.store(on);
+}
+
+long long Metrics::nowNs(){
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Metrics::addTime(MetricPhase p, long long ns){
+	phaseCalls[p].fetch_add(1, memory_order_relaxed);
+	phaseNs[p].fetch_add(ns, memory_order_relaxed);
+	long long prev = phaseMaxNs[p].load(memory_order_relaxed);
+	while (ns > prev && !phaseMaxNs[p].compare_exchange_weak(prev, ns, memory_order_relaxed))
+		;
+}
+
+long long Metrics::counter(MetricCounter c){
+	return counters[c].load(memory_order_relaxed);
+}
+
+PhaseStats Metrics::phase(MetricPhase p){
+	PhaseStats s;
+	s.calls = phaseCalls[p].load(memory_order_relaxed);
+	s.totalNs = phaseNs[p].load(memory_order_relaxed);
+	s.maxNs = phaseMaxNs[p].load(memory_order_relaxed);
+	return s;
+}
+
+void Metrics::reset(){
+	for (int i = 0; i < COUNTER_COUNT; i++)
+		counters[i].store(0);
+	for (int i = 0; i < PHASE_COUNT; i++){
+		phaseCalls[i].store(0);
+		phaseNs[i].store(0);
+		phaseMaxNs[i].store(0);
+	}
+}
+
+const char* Metrics::phaseName(MetricPhase p){
+	switch (p){
+	case PHASE_FILE_OPEN:		return "file_open";
+	case PHASE_SHX_PARSE:		return "shx_parse";
+	case PHASE_RECORD_DECODE:	return "record_decode";
+	case PHASE_DBF_READ:		return "dbf_read";
+	case PHASE_INDEX_BUILD:		return "index_build";
+	case PHASE_UPLOAD:			return "upload";
+	case PHASE_FRAME_RENDER:	return "frame_render";
+	default:					return "unknown";
+	}
+}
+
+const char* Metrics::counterName(MetricCounter c){
+	switch (c){
+	case COUNTER_BYTES_READ:	return "bytes_read";
+	case COUNTER_SYSCALLS:		return "syscalls";
+	case COUNTER_ALLOCATIONS:	return "allocations";
+	case COUNTER_DRAW_CALLS:	return "draw_calls";
+	case COUNTER_VERTICES:		return "vertices_submitted";
+	case COUNTER_RECORDS:		return "records_decoded";
+	case COUNTER_FRAMES:		return "frames";
+	case COUNTER_PARTS_CULLED:	return "parts_culled";
+	case COUNTER_LAYER_REDRAWS:	return "layer_redraws";
+	case COUNTER_STRIP_REDRAWS:	return "strip_redraws";
+	case COUNTER_STATE_CHANGES:	return "state_changes";
+	case COUNTER_VERTICES_DECIMATED:	return "vertices_decimated";
+	case COUNTER_SEGMENTS_CLIPPED:	return "segments_clipped";
+	case COUNTER_CACHE_HITS:	return "cache_hits";
+	case COUNTER_CACHE_MISSES:	return "cache_misses";
+	default:					return "unknown";
+	}
+}
+
+string Metrics::toJSON(){
+	ostringstream os;
+	os << "{\n\t\"phases\": {\n";
+	for (int i = 0; i < PHASE_COUNT; i++){
+		PhaseStats s = phase((MetricPhase)i);
+		os << "\t\t\"" << phaseName((MetricPhase)i) << "\": { \"calls\": " << s.calls
+			<< ", \"total_ms\": " << s.totalNs / 1e6
+			<< ", \"max_ms\": " << s.maxNs / 1e6 << " }"
+			<< (i + 1 < PHASE_COUNT ? ",\n" : "\n");
+	}
+	os << "\t},\n\t\"counters\": {\n";
+	for (int i = 0; i < COUNTER_COUNT; i++){
+		os << "\t\t\"" << counterName((MetricCounter)i) << "\": " << counter((MetricCounter)i)
+			<< (i + 1 < COUNTER_COUNT ? ",\n" : "\n");
+	}
+	os << "\t}\n}\n";
+	return os.str();
+}
+
+bool Metrics::dumpJSON(const char* path){
+	ofstream out(path);
+	if (!out)
+		return false;
+	out << toJSON();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Counting shapelib hooks
+////////////////////////////////////////////////////////////////////////////////
+
+static SAHooks sBaseHooks, sCountingHooks;
+static once_flag sHooksOnce;
+
+static SAFile countingFOpen(const char* filename, const char* access){
+	ScopedTimer t(PHASE_FILE_OPEN);
+	Metrics::add(COUNTER_SYSCALLS);
+	return sBaseHooks.FOpen(filename, access);
+}
+
+static SAOffset countingFRead(void* p, SAOffset size, SAOffset nmemb, SAFile file){
+	Metrics::add(COUNTER_SYSCALLS);
+	SAOffset n = sBaseHooks.FRead(p, size, nmemb, file);
+	Metrics::add(COUNTER_BYTES_READ, (long long)(n * size));
+	return n;
+}
+
+static SAOffset countingFSeek(SAFile file, SAOffset offset, int whence){
+	Metrics::add(COUNTER_SYSCALLS);
+	return sBaseHooks.FSeek(file, offset, whence);
+}
+
+static void setupCountingHooks(){
+	SASetupDefaultHooks(&sBaseHooks);
+	sCountingHooks = sBaseHooks;
+	sCountingHooks.FOpen = countingFOpen;
+	sCountingHooks.FRead = countingFRead;
+	sCountingHooks.FSeek = countingFSeek;
+}
+
+SAHooks* Metrics::countingHooks(){
+	call_once(sHooksOnce, setupCountingHooks);
+	return &sCountingHooks;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation counting. Define METRICS_NO_ALLOC_HOOK to keep the stock operator new.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef METRICS_NO_ALLOC_HOOK
+
+void* operator new(size_t n){
+	Metrics::add(COUNTER_ALLOCATIONS);
+	void* p = malloc(n ? n : 1);
+	if (p == NULL)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) throw(){
+	free(p);
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef METRICS_H_DEF
+#define METRICS_H_DEF
+
+#include "shapefil.h"
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+enum MetricPhase {
+	PHASE_FILE_OPEN,
+	PHASE_SHX_PARSE,
+	PHASE_RECORD_DECODE,
+	PHASE_DBF_READ,
+	PHASE_INDEX_BUILD,
+	PHASE_UPLOAD,        // frames and textures handed to GL (glDrawPixels, glTexImage2D)
+	PHASE_FRAME_RENDER,
+	PHASE_COUNT
+};
+
+enum MetricCounter {
+	COUNTER_BYTES_READ,
+	COUNTER_SYSCALLS,    // read/seek/open calls issued through the file hooks and PosFile
+	COUNTER_ALLOCATIONS, // C++ heap allocations (operator new)
+	COUNTER_DRAW_CALLS,  // glBegin/glEnd pairs and glDraw* calls
+	COUNTER_VERTICES,
+	COUNTER_RECORDS,
+	COUNTER_FRAMES,
+	COUNTER_PARTS_CULLED, // parts outside the view, not submitted
+	COUNTER_LAYER_REDRAWS, // cached layer images drawn from scratch
+	COUNTER_STRIP_REDRAWS, // cached layer images shifted and patched after a pan
+	COUNTER_STATE_CHANGES, // GL state calls left after the redundant-state filter
+	COUNTER_VERTICES_DECIMATED, // hairline vertices dropped as sharing a screen cell with the one before
+	COUNTER_SEGMENTS_CLIPPED, // segments of visible parts left out as wholly off one side of the view
+	COUNTER_CACHE_HITS,   // FeatureCache lookups answered from the cache
+	COUNTER_CACHE_MISSES,
+	COUNTER_COUNT
+};
+
+struct PhaseStats {
+	long long calls;
+	long long totalNs;
+	long long maxNs;
+};
+
+/*
+	Process-wide load/render counters.
+	Everything is a no-op (one relaxed load) until setEnabled(true).
+*/
+class Metrics {
+public:
+	static void setEnabled(bool on);
+	static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+
+	static void add(MetricCounter c, long long n = 1){
+		if (isEnabled())
+			counters[c].fetch_add(n, memory_order_relaxed);
+	}
+	static void addTime(MetricPhase p, long long ns);
+
+	static long long counter(MetricCounter c);
+	static PhaseStats phase(MetricPhase p);
+	static void reset();
+
+	static const char* phaseName(MetricPhase p);
+	static const char* counterName(MetricCounter c);
+
+	static string toJSON();
+	static bool dumpJSON(const char* path);
+
+	// Default shapelib hooks wrapped to count bytes, calls and open time.
+	static SAHooks* countingHooks();
+
+	static long long nowNs();
+
+private:
+	static atomic<bool> enabled;
+	static atomic<long long> counters[COUNTER_COUNT];
+	static atomic<long long> phaseCalls[PHASE_COUNT];
+	static atomic<long long> phaseNs[PHASE_COUNT];
+	static atomic<long long> phaseMaxNs[PHASE_COUNT];
+};
+
+/*
+	Adds the lifetime of the object to a phase.
+*/
+class ScopedTimer {
+public:
+	ScopedTimer(MetricPhase p) : phase(p), start(Metrics::isEnabled() ? Metrics::nowNs() : -1) {}
+	~ScopedTimer(){
+		if (start >= 0)
+			Metrics::addTime(phase, Metrics::nowNs() - start);
+	}
+private:
+	MetricPhase phase;
+	long long start;
+
+	ScopedTimer(const ScopedTimer&);
+	ScopedTimer& operator=(const ScopedTimer&);
+};
+
+#endif
@@ -0,0 +1,398 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "NameIndex.h"
+#include "LayerAttributes.h"
+#include "Metrics.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <float.h>
+
+using namespace std;
+
+enum CodePageKind { CP_ANSI, CP_UTF8, CP_OEM437, CP_OEM850 };
+
+static CodePageKind codePageKind(const string& codePage){
+	string cp; // "UTF-8" -> "utf8", "LDID/2" -> "ldid2"
+	for (size_t i = 0; i < codePage.size(); i++){
+		char c = codePage[i];
+		if (c >= 'A' && c <= 'Z')
+			cp += (char)(c - 'A' + 'a');
+		else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+			cp += c;
+	}
+	if (cp == "utf8" || cp == "65001")
+		return CP_UTF8;
+	if (cp == "ldid1" || cp == "437" || cp == "cp437" || cp == "ibm437")
+		return CP_OEM437;
+	if (cp == "ldid2" || cp == "850" || cp == "cp850" || cp == "ibm850")
+		return CP_OEM850;
+	return CP_ANSI;
+}
+
+// Windows-1252; 0x80-0x9F are letters or punctuation, the rest is Latin-1.
+static unsigned int decodeAnsi(unsigned char c){
+	switch (c){
+	case 0x8A: return 0x160;
+	case 0x8C: return 0x152;
+	case 0x8E: return 0x17D;
+	case 0x9A: return 0x161;
+	case 0x9C: return 0x153;
+	case 0x9E: return 0x17E;
+	case 0x9F: return 0x178;
+	}
+	return (c >= 0x80 && c < 0xA0) ? ' ' : c;
+}
+
+// The letters of code pages 437 and 850; box drawing and the like give 0.
+static unsigned int decodeOem(unsigned char c, bool cp850){
+	static const unsigned short common[0x26] = {
+		0xC7, 0xFC, 0xE9, 0xE2, 0xE4, 0xE0, 0xE5, 0xE7, 0xEA, 0xEB, 0xE8, 0xEF, 0xEE, 0xEC, 0xC4, 0xC5,
+		0xC9, 0xE6, 0xC6, 0xF4, 0xF6, 0xF2, 0xFB, 0xF9, 0xFF, 0xD6, 0xDC, 0xA2, 0xA3, 0xA5, 0x20A7, 0x192,
+		0xE1, 0xED, 0xF3, 0xFA, 0xF1, 0xD1 };
+	static const unsigned char extra850[][2] = {
+		{ 0x9B, 0xF8 }, { 0x9D, 0xD8 }, { 0x9E, 0xD7 }, { 0xB5, 0xC1 }, { 0xB6, 0xC2 }, { 0xB7, 0xC0 },
+		{ 0xC6, 0xE3 }, { 0xC7, 0xC3 }, { 0xD2, 0xCA }, { 0xD3, 0xCB }, { 0xD4, 0xC8 }, { 0xD6, 0xCD },
+		{ 0xD7, 0xCE }, { 0xD8, 0xCF }, { 0xDE, 0xCC }, { 0xE0, 0xD3 }, { 0xE2, 0xD4 }, { 0xE3, 0xD2 },
+		{ 0xE4, 0xF5 }, { 0xE5, 0xD5 }, { 0xE9, 0xDA }, { 0xEA, 0xDB }, { 0xEB, 0xD9 }, { 0xEC, 0xFD },
+		{ 0xED, 0xDD } };
+	if (c < 0x80)
+		return c;
+	if (cp850)
+		for (size_t i = 0; i < sizeof(extra850) / sizeof(extra850[0]); i++)
+			if (extra850[i][0] == c)
+				return extra850[i][1];
+	if (c < 0x80 + 0x26)
+		return common[c - 0x80];
+	if (c == 0xE1)
+		return 0xDF;
+	return 0;
+}
+
+// One UTF-8 sequence at p; an invalid one decodes its first byte as Windows-1252.
+static unsigned int decodeUtf8(const unsigned char* p, size_t n, size_t& len){
+	unsigned int c = p[0];
+	len = 1;
+	if (c < 0x80)
+		return c;
+	int more = (c >= 0xC2 && c <= 0xDF) ? 1 : (c >= 0xE0 && c <= 0xEF) ? 2 : (c >= 0xF0 && c <= 0xF4) ? 3 : -1;
+	if (more > 0 && (size_t)more < n){
+		unsigned int u = c & (0x3F >> more);
+		int i = 1;
+		for (; i <= more && (p[i] & 0xC0) == 0x80; i++)
+			u = (u << 6) | (p[i] & 0x3F);
+		static const unsigned int minimum[4] = { 0, 0x80, 0x800, 0x10000 };
+		if (i > more && u >= minimum[more] && u <= 0x10FFFF && (u < 0xD800 || u > 0xDFFF)){
+			len = more + 1;
+			return u;
+		}
+	}
+	return decodeAnsi((unsigned char)c);
+}
+
+/*
+	ASCII spelling of a character: the German convention for umlauts and ß,
+	the base letter for other accented ones. Returns "" for characters that
+	are left out and NULL for separators.
+*/
+static const char* foldChar(unsigned int u){
+	static const char* const latin[64] = {
+		"a", "a", "a", "a", "ae", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+		"d", "n", "o", "o", "o", "o", "oe", NULL, "o", "u", "u", "u", "ue", "y", "th", "ss",
+		"a", "a", "a", "a", "ae", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+		"d", "n", "o", "o", "o", "o", "oe", NULL, "o", "u", "u", "u", "ue", "y", "th", "y" };
+	static const char alnum[] = "0\0" "1\0" "2\0" "3\0" "4\0" "5\0" "6\0" "7\0" "8\0" "9\0"
+		"a\0" "b\0" "c\0" "d\0" "e\0" "f\0" "g\0" "h\0" "i\0" "j\0" "k\0" "l\0" "m\0"
+		"n\0" "o\0" "p\0" "q\0" "r\0" "s\0" "t\0" "u\0" "v\0" "w\0" "x\0" "y\0" "z";
+	if (u >= '0' && u <= '9')
+		return alnum + 2 * (u - '0');
+	if (u >= 'a' && u <= 'z')
+		return alnum + 2 * (u - 'a' + 10);
+	if (u >= 'A' && u <= 'Z')
+		return alnum + 2 * (u - 'A' + 10);
+	if (u < 0xC0)
+		return NULL; // ASCII punctuation, no-break space, symbols
+	if (u < 0x100)
+		return latin[u - 0xC0];
+	switch (u){
+	case 0x152: case 0x153: return "oe";
+	case 0x160: case 0x161: return "s";
+	case 0x17D: case 0x17E: return "z";
+	case 0x178: return "y";
+	case 0x1E9E: return "ss";
+	}
+	return "";
+}
+
+string foldName(const StrView& text, const string& codePage){
+	CodePageKind kind = codePageKind(codePage);
+	const unsigned char* p = (const unsigned char*)text.data;
+	string out;
+	out.reserve(text.size() + 4);
+	bool space = false;
+	for (size_t i = 0; i < text.size();){
+		size_t len = 1;
+		unsigned int u;
+		if (kind == CP_UTF8)
+			u = decodeUtf8(p + i, text.size() - i, len);
+		else if (kind == CP_ANSI)
+			u = decodeAnsi(p[i]);
+		else
+			u = decodeOem(p[i], kind == CP_OEM850);
+		i += len;
+		if (u == 0)
+			continue;
+		const char* f = foldChar(u);
+		if (f == NULL){
+			space = !out.empty();
+			continue;
+		}
+		if (*f == '\0')
+			continue;
+		if (space)
+			out += ' ';
+		space = false;
+		out += f;
+	}
+	return out;
+}
+
+void NameIndex::buildNode(int node, const vector<string>& keys, int begin, int end, int depth){
+	int stop = depth;
+	if (begin < end){
+		// keys are sorted, so the first and the last share what all of them share
+		const string& first = keys[begin];
+		const string& last = keys[end - 1];
+		while (stop < (int)first.size() && stop < (int)last.size() && first[stop] == last[stop])
+			stop++;
+		labels.append(first, depth, stop - depth);
+	}
+	nodes[node].labelStart = (unsigned int)(labels.size() - (stop - depth));
+	nodes[node].labelLen = stop - depth;
+	nodes[node].entry = -1;
+	nodes[node].entryBegin = begin;
+	nodes[node].entryEnd = end;
+	if (stop > maxDepth)
+		maxDepth = stop;
+
+	int i = begin;
+	if (i < end && (int)keys[i].size() == stop){
+		nodes[node].entry = i;
+		entryNode[i] = node;
+		i++;
+	}
+	// one child per next character, given consecutive slots before descending
+	int nChildren = 0;
+	for (int j = i; j < end; nChildren++){
+		char c = keys[j][stop];
+		while (j < end && keys[j][stop] == c)
+			j++;
+	}
+	int firstChild = (int)nodes.size();
+	nodes[node].firstChild = firstChild;
+	nodes[node].nChildren = nChildren;
+	nodes.resize(nodes.size() + nChildren);
+	for (int child = firstChild; i < end; child++){
+		int j = i;
+		char c = keys[j][stop];
+		while (j < end && keys[j][stop] == c)
+			j++;
+		nodes[child].parent = node;
+		buildNode(child, keys, i, j, stop);
+		i = j;
+	}
+}
+
+shared_ptr<const NameIndex> NameIndex::build(const LayerAttributes& attrs, int column, const LayerGeometry* geometry){
+	ScopedTimer timer(PHASE_INDEX_BUILD);
+	shared_ptr<NameIndex> idx(new NameIndex());
+	idx->attrs = &attrs;
+	idx->column = column;
+	const AttributeColumn& col = attrs.getColumn(column);
+	int n = attrs.getRowCount();
+
+	vector<string> folded(n);
+	if (!col.isNumeric())
+		parallelFor(n, 4096, [&](int begin, int end){
+			for (int i = begin; i < end; i++)
+				folded[i] = foldName(col.strings[i], col.codePage);
+		});
+	vector<int> order;
+	order.reserve(n);
+	for (int i = 0; i < n; i++)
+		if (!folded[i].empty())
+			order.push_back(i);
+	sort(order.begin(), order.end(), [&](int a, int b){
+		int c = folded[a].compare(folded[b]);
+		return c < 0 || (c == 0 && a < b);
+	});
+
+	vector<string> keys;
+	idx->entryRows.push_back(0);
+	idx->rows.reserve(order.size());
+	for (size_t i = 0; i < order.size(); i++){
+		if (keys.empty() || folded[order[i]] != keys.back()){
+			if (!keys.empty())
+				idx->entryRows.push_back((int)idx->rows.size());
+			keys.push_back(folded[order[i]]);
+		}
+		idx->rows.push_back(order[i]);
+	}
+	if (!keys.empty())
+		idx->entryRows.push_back((int)idx->rows.size());
+
+	// bounds of every shape, then of every key
+	vector<vec4> shapeBounds(n, vec4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX));
+	if (geometry){
+		for (int p = 0; p < geometry->getPartCount(); p++){
+			int shape = geometry->partShape[p];
+			if (shape < 0 || shape >= n)
+				continue;
+			vec4& b = shapeBounds[shape];
+			const vec3* v = geometry->getPart(p);
+			for (int k = 0; k < geometry->getPartSize(p); k++){
+				b.x = min(b.x, v[k].x);
+				b.y = min(b.y, v[k].y);
+				b.z = max(b.z, v[k].x);
+				b.w = max(b.w, v[k].y);
+			}
+		}
+	}
+	idx->entryBounds.resize(keys.size());
+	for (size_t k = 0; k < keys.size(); k++){
+		vec4 b(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int r = idx->entryRows[k]; r < idx->entryRows[k + 1]; r++){
+			const vec4& s = shapeBounds[idx->rows[r]];
+			b.x = min(b.x, s.x);
+			b.y = min(b.y, s.y);
+			b.z = max(b.z, s.z);
+			b.w = max(b.w, s.w);
+		}
+		idx->entryBounds[k] = b.x <= b.z ? b : vec4(0, 0, 0, 0);
+	}
+
+	idx->entryNode.resize(keys.size());
+	idx->nodes.resize(1);
+	idx->nodes[0].parent = -1;
+	idx->buildNode(0, keys, 0, (int)keys.size(), 0);
+	return idx;
+}
+
+size_t NameIndex::getMemoryBytes() const{
+	return labels.size() + nodes.size() * sizeof(Node) + (entryNode.size() + entryRows.size() + rows.size()) * sizeof(int)
+		+ entryBounds.size() * sizeof(vec4);
+}
+
+string NameIndex::keyOf(int entry) const{
+	string key;
+	for (int node = entryNode[entry]; node >= 0; node = nodes[node].parent)
+		key.insert(0, labels, nodes[node].labelStart, nodes[node].labelLen);
+	return key;
+}
+
+NameMatch NameIndex::makeMatch(int entry, int distance) const{
+	NameMatch m;
+	m.name = attrs->getString(column, rows[entryRows[entry]]);
+	m.key = keyOf(entry);
+	m.distance = distance;
+	m.shapes.assign(rows.begin() + entryRows[entry], rows.begin() + entryRows[entry + 1]);
+	m.bounds = entryBounds[entry];
+	return m;
+}
+
+vector<NameMatch> NameIndex::prefix(const string& query, int maxResults) const{
+	vector<NameMatch> result;
+	string q = foldName(StrView(query), "UTF-8");
+	size_t pos = 0;
+	int node = 0;
+	for (;;){
+		const Node& n = nodes[node];
+		for (int i = 0; i < n.labelLen && pos < q.size(); i++, pos++)
+			if (labels[n.labelStart + i] != q[pos])
+				return result;
+		if (pos == q.size())
+			break;
+		// children are ordered by their first character
+		int lo = n.firstChild, hi = n.firstChild + n.nChildren;
+		while (lo < hi){
+			int mid = (lo + hi) / 2;
+			if ((unsigned char)labels[nodes[mid].labelStart] < (unsigned char)q[pos])
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo == n.firstChild + n.nChildren || labels[nodes[lo].labelStart] != q[pos])
+			return result;
+		node = lo;
+	}
+	for (int e = nodes[node].entryBegin; e < nodes[node].entryEnd && (int)result.size() < maxResults; e++)
+		result.push_back(makeMatch(e, 0));
+	return result;
+}
+
+/*
+	dp holds one row of q.size() + 1 distances per trie depth; row `depth`
+	is the distance between q's prefixes and the path down to here.
+	bestPrefix is the least last-column value on that path, which is the
+	distance of q to any prefix of the keys below.
+*/
+void NameIndex::fuzzyNode(int node, const string& q, int maxEdits, bool prefixMode, vector<int>& dp,
+	int depth, int bestPrefix, vector<pair<int, int> >& found) const{
+	const Node& n = nodes[node];
+	int m = (int)q.size();
+	for (int i = 0; i < n.labelLen; i++, depth++){
+		char c = labels[n.labelStart + i];
+		const int* prev = &dp[depth * (m + 1)];
+		int* row = &dp[(depth + 1) * (m + 1)];
+		row[0] = prev[0] + 1;
+		int rowMin = row[0];
+		for (int j = 1; j <= m; j++){
+			int d = min(prev[j] + 1, row[j - 1] + 1);
+			d = min(d, prev[j - 1] + (q[j - 1] != c));
+			row[j] = d;
+			rowMin = min(rowMin, d);
+		}
+		bestPrefix = min(bestPrefix, row[m]);
+		if (rowMin > maxEdits){
+			// no extension gets closer; in prefix mode the whole subtree may already match
+			if (prefixMode && bestPrefix <= maxEdits)
+				for (int e = n.entryBegin; e < n.entryEnd; e++)
+					found.push_back(make_pair(bestPrefix, e));
+			return;
+		}
+	}
+	if (n.entry >= 0){
+		int d = prefixMode ? bestPrefix : dp[depth * (m + 1) + m];
+		if (d <= maxEdits)
+			found.push_back(make_pair(d, n.entry));
+	}
+	for (int child = n.firstChild; child < n.firstChild + n.nChildren; child++)
+		fuzzyNode(child, q, maxEdits, prefixMode, dp, depth, bestPrefix, found);
+}
+
+vector<NameMatch> NameIndex::fuzzy(const string& query, int maxEdits, bool prefixMode, int maxResults) const{
+	string q = foldName(StrView(query), "UTF-8");
+	int m = (int)q.size();
+	vector<int> dp((maxDepth + 1) * (m + 1));
+	for (int j = 0; j <= m; j++)
+		dp[j] = j;
+	vector<pair<int, int> > found; // (distance, key)
+	if (getKeyCount() > 0)
+		fuzzyNode(0, q, maxEdits, prefixMode, dp, 0, m, found);
+	// keys come out in order, so a stable sort by distance keeps ties in key order
+	stable_sort(found.begin(), found.end(), [](const pair<int, int>& a, const pair<int, int>& b){
+		return a.first < b.first;
+	});
+	vector<NameMatch> result;
+	for (size_t i = 0; i < found.size() && (int)result.size() < maxResults; i++)
+		result.push_back(makeMatch(found[i].second, found[i].first));
+	return result;
+}
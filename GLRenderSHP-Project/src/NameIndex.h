@@ -0,0 +1,104 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef NAMEINDEX_H_DEF
+#define NAMEINDEX_H_DEF
+
+#include "StrView.h"
+#include "Vectors.h"
+#include "LayerGeometry.h"
+#include <vector>
+#include <string>
+#include <memory>
+
+using namespace std;
+
+class LayerAttributes;
+
+/*
+	Search key of a name: text decoded from codePage (as MappedDBF::getCodePage;
+	UTF-8, OEM 437/850 via LDID 1/2, anything else read as Windows-1252),
+	lowercased, umlauts spelled out (ä -> ae, ß -> ss), other accents dropped,
+	runs of spaces and punctuation turned into one space. The result is plain
+	ASCII: "Große Str." and "GROSSE STR" both give "grosse str".
+*/
+string foldName(const StrView& text, const string& codePage);
+
+struct NameMatch {
+	StrView name;        // first spelling in the column, bytes in its code page
+	string key;          // folded
+	int distance;        // edits between query and key, 0 for prefix()
+	vector<int> shapes;  // ascending
+	vec4 bounds;         // (minX, minY, maxX, maxY) over the shapes
+};
+
+/*
+	Name search over one text column of a LayerAttributes. The distinct
+	folded keys are kept in a radix trie laid out in flat arrays: edge labels
+	in one string pool, the children of a node next to each other and
+	ordered by first character, and every node knowing the range of keys
+	below it. Prefix queries are a walk down the trie; edit-distance queries
+	run one Levenshtein row per trie character and drop subtrees whose row
+	is already over the limit.
+
+	Queries are UTF-8 (bytes that are not valid UTF-8 are read as
+	Windows-1252) and are folded as the keys. The index refers to the
+	store's values and must not outlive it.
+*/
+class NameIndex {
+public:
+	// geometry gives the bounds of the matches; may be NULL.
+	static shared_ptr<const NameIndex> build(const LayerAttributes& attrs, int column, const LayerGeometry* geometry);
+
+	// Keys starting with the query, in key order.
+	vector<NameMatch> prefix(const string& query, int maxResults) const;
+	/*
+		Keys within maxEdits insertions, deletions or substitutions of the
+		query, nearest first, ties in key order. With prefixMode, keys that
+		start with such a string: "hauptsr" finds "hauptstrasse".
+	*/
+	vector<NameMatch> fuzzy(const string& query, int maxEdits, bool prefixMode, int maxResults) const;
+
+	int getColumn() const { return column; }
+	int getKeyCount() const { return (int)entryRows.size() - 1; }
+	size_t getMemoryBytes() const;
+
+private:
+	struct Node {
+		unsigned int labelStart; // in labels
+		int labelLen;
+		int parent;
+		int firstChild;
+		int nChildren;
+		int entry;               // key ending here, -1 if none
+		int entryBegin;          // keys in the subtree
+		int entryEnd;
+	};
+
+	const LayerAttributes* attrs;
+	int column;
+	string labels;
+	vector<Node> nodes;          // root first
+	int maxDepth;                // longest key
+	vector<int> entryNode;       // where key k ends
+	vector<int> entryRows;       // key k has rows[entryRows[k], entryRows[k + 1])
+	vector<int> rows;
+	vector<vec4> entryBounds;
+
+	NameIndex() : attrs(NULL), column(-1), maxDepth(0) {}
+	void buildNode(int node, const vector<string>& keys, int begin, int end, int depth);
+	void fuzzyNode(int node, const string& q, int maxEdits, bool prefixMode, vector<int>& dp,
+		int depth, int bestPrefix, vector<pair<int, int> >& found) const;
+	string keyOf(int entry) const;
+	NameMatch makeMatch(int entry, int distance) const;
+};
+
+#endif
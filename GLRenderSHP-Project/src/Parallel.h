@@ -0,0 +1,72 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef PARALLEL_H_DEF
+#define PARALLEL_H_DEF
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+using namespace std;
+
+/*
+	Runs body(begin, end) over [0, n) split in contiguous ranges, one per
+	hardware thread but none smaller than minChunk. The calling thread takes
+	the first range; returns when all ranges are done.
+*/
+template <class Body>
+void parallelFor(int n, int minChunk, Body body){
+	int hw = (int)thread::hardware_concurrency();
+	if (hw < 1)
+		hw = 1;
+	int nChunks = n / (minChunk > 0 ? minChunk : 1);
+	if (nChunks > hw)
+		nChunks = hw;
+	if (nChunks <= 1){
+		if (n > 0)
+			body(0, n);
+		return;
+	}
+	int perChunk = (n + nChunks - 1) / nChunks;
+	vector<thread> workers;
+	for (int begin = perChunk; begin < n; begin += perChunk)
+		workers.push_back(thread(body, begin, begin + perChunk < n ? begin + perChunk : n));
+	body(0, perChunk);
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+/*
+	Runs body(i) for every i in [0, n), handing out one index at a time from
+	a shared counter, so uneven items (layers of very different sizes) keep
+	every thread busy. The calling thread works too; returns when all are done.
+*/
+template <class Body>
+void parallelForEach(int n, Body body){
+	int hw = (int)thread::hardware_concurrency();
+	if (hw < 1)
+		hw = 1;
+	int nThreads = n < hw ? n : hw;
+	atomic<int> next(0);
+	auto work = [&]{
+		for (int i = next++; i < n; i = next++)
+			body(i);
+	};
+	vector<thread> workers;
+	for (int t = 1; t < nThreads; t++)
+		workers.push_back(thread(work));
+	work();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+#endif
@@ -0,0 +1,196 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "PointSymbols.h"
+#include "LayerAttributes.h"
+#include "Metrics.h"
+#include <math.h>
+#include <GL/glut.h>
+
+using namespace std;
+
+enum SymbolShape { SHAPE_CIRCLE, SHAPE_SQUARE, SHAPE_DIAMOND, SHAPE_TRIANGLE, SHAPE_PLUS, SHAPE_CROSS };
+
+struct SymbolDef {
+	SymbolShape shape;
+	float r, g, b;
+};
+
+// By poiTypID: not attributed, cemetery, hospital, parking, school, public building,
+// church, viewpoint, other, university, multi-storey car park.
+static const SymbolDef defaultSymbols[] = {
+	{ SHAPE_CIRCLE, 0.6f, 0.6f, 0.6f },
+	{ SHAPE_CROSS, 0.2f, 0.45f, 0.2f },
+	{ SHAPE_PLUS, 0.85f, 0.1f, 0.1f },
+	{ SHAPE_SQUARE, 0.15f, 0.35f, 0.85f },
+	{ SHAPE_TRIANGLE, 0.95f, 0.6f, 0.1f },
+	{ SHAPE_DIAMOND, 0.6f, 0.4f, 0.25f },
+	{ SHAPE_CROSS, 0.5f, 0.2f, 0.6f },
+	{ SHAPE_TRIANGLE, 0.2f, 0.7f, 0.3f },
+	{ SHAPE_CIRCLE, 0.35f, 0.35f, 0.35f },
+	{ SHAPE_DIAMOND, 0.95f, 0.75f, 0.1f },
+	{ SHAPE_SQUARE, 0.1f, 0.15f, 0.5f },
+};
+
+// (u, v) in [-1, 1], v up; grow > 1 gives the outline's outer edge.
+static bool insideShape(SymbolShape shape, float u, float v, float grow){
+	u /= grow;
+	v /= grow;
+	switch (shape){
+	case SHAPE_CIRCLE:
+		return u * u + v * v <= 0.55f * 0.55f;
+	case SHAPE_SQUARE:
+		return fabs(u) <= 0.5f && fabs(v) <= 0.5f;
+	case SHAPE_DIAMOND:
+		return fabs(u) + fabs(v) <= 0.68f;
+	case SHAPE_TRIANGLE:
+		return v >= -0.45f && fabs(u) <= (0.6f - v) * 0.6f;
+	case SHAPE_PLUS:
+		return (fabs(u) <= 0.2f && fabs(v) <= 0.62f) || (fabs(v) <= 0.2f && fabs(u) <= 0.62f);
+	case SHAPE_CROSS:
+		return (fabs(u) <= 0.15f && fabs(v) <= 0.68f) || (fabs(v - 0.2f) <= 0.15f && fabs(u) <= 0.45f);
+	}
+	return false;
+}
+
+SymbolAtlas::SymbolAtlas(int cellSize, int nSymbols) : cellSize(cellSize), nSymbols(nSymbols), texture(0){
+	columns = 4;
+	while (columns * columns < nSymbols)
+		columns *= 2;
+	image.resize(columns * cellSize, columns * cellSize);
+	for (int i = 0; i < nSymbols; i++)
+		drawSymbol(i);
+}
+
+shared_ptr<const SymbolAtlas> SymbolAtlas::getDefault(){
+	static shared_ptr<const SymbolAtlas> atlas(new SymbolAtlas(16, sizeof(defaultSymbols) / sizeof(defaultSymbols[0])));
+	return atlas;
+}
+
+PixelRect SymbolAtlas::getCell(int symbol) const{
+	int x = (symbol % columns) * cellSize, y = (symbol / columns) * cellSize;
+	return PixelRect(x, y, x + cellSize, y + cellSize);
+}
+
+vec4 SymbolAtlas::getTexCoords(int symbol) const{
+	PixelRect c = getCell(symbol);
+	float w = (float)image.width, h = (float)image.height;
+	return vec4(c.x0 / w, c.y0 / h, c.x1 / w, c.y1 / h);
+}
+
+/*
+	4 x 4 samples per pixel: the share inside the shape takes its colour,
+	the share inside the grown shape but not the shape is the outline.
+*/
+void SymbolAtlas::drawSymbol(int symbol){
+	const SymbolDef& def = defaultSymbols[symbol];
+	PixelRect cell = getCell(symbol);
+	for (int j = 0; j < cellSize; j++){
+		for (int i = 0; i < cellSize; i++){
+			int fill = 0, edge = 0;
+			for (int sj = 0; sj < 4; sj++)
+				for (int si = 0; si < 4; si++){
+					float u = ((i + (si + 0.5f) / 4) / cellSize) * 2 - 1;
+					float v = ((j + (sj + 0.5f) / 4) / cellSize) * 2 - 1;
+					if (insideShape(def.shape, u, v, 1))
+						fill++;
+					else if (insideShape(def.shape, u, v, 1.3f))
+						edge++;
+				}
+			float a = (fill + edge) / 16.0f;
+			if (a == 0)
+				continue;
+			float f = fill / 16.0f;
+			// the outline share is black
+			vec4 c(def.r * f / a, def.g * f / a, def.b * f / a, a);
+			image.row(cell.y0 + j)[cell.x0 + i] = packColor(c);
+		}
+	}
+}
+
+void SymbolAtlas::bind() const{
+	if (texture == 0){
+		// straight alpha for GL's SRC_ALPHA, ONE_MINUS_SRC_ALPHA blending
+		vector<unsigned int> straight(image.pixels.size());
+		for (size_t i = 0; i < straight.size(); i++){
+			unsigned int p = image.pixels[i], a = p >> 24;
+			if (a == 0 || a == 255){
+				straight[i] = p;
+				continue;
+			}
+			unsigned int r = (p & 255) * 255 / a, g = ((p >> 8) & 255) * 255 / a, b = ((p >> 16) & 255) * 255 / a;
+			straight[i] = r | (g << 8) | (b << 16) | (a << 24);
+		}
+		GLuint id;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		ScopedTimer upload(PHASE_UPLOAD);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, straight.data());
+		texture = id;
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+PointSymbols::PointSymbols(const shared_ptr<const LayerGeometry>& geometry, const LayerAttributes* attrs, int typeColumn,
+	const shared_ptr<const SymbolAtlas>& atlas) : geometry(geometry), atlas(atlas), quadScale(0){
+	const LayerGeometry& geom = *geometry;
+	int nSymbols = atlas->getSymbolCount();
+	symbols.assign(geom.points.size(), 0);
+	if (attrs != NULL && typeColumn >= 0){
+		for (int p = 0; p < geom.getPartCount(); p++){
+			int row = geom.partShape[p];
+			if (row < 0 || row >= attrs->getRowCount())
+				continue;
+			double t = attrs->getNumber(typeColumn, row);
+			int symbol = (t >= 0 && t < nSymbols) ? (int)t : 0;
+			for (unsigned int k = geom.partStart[p]; k < geom.partStart[p + 1]; k++)
+				symbols[k] = (unsigned char)symbol;
+		}
+	}
+	for (int s = 0; s < nSymbols; s++)
+		cells.push_back(atlas->getCell(s));
+	texCoords.resize(symbols.size() * 4);
+	for (size_t i = 0; i < symbols.size(); i++){
+		vec4 tc = atlas->getTexCoords(symbols[i]);
+		texCoords[i * 4] = vec2(tc.x, tc.y);
+		texCoords[i * 4 + 1] = vec2(tc.z, tc.y);
+		texCoords[i * 4 + 2] = vec2(tc.z, tc.w);
+		texCoords[i * 4 + 3] = vec2(tc.x, tc.w);
+	}
+}
+
+const vec3* PointSymbols::getQuads(float worldPerPixel){
+	if (worldPerPixel == quadScale && !quads.empty())
+		return quads.data();
+	const vector<vec3>& points = geometry->points;
+	float r = getRadius() * worldPerPixel;
+	quads.resize(points.size() * 4);
+	for (size_t i = 0; i < points.size(); i++){
+		const vec3& p = points[i];
+		quads[i * 4] = vec3(p.x - r, p.y - r, p.z);
+		quads[i * 4 + 1] = vec3(p.x + r, p.y - r, p.z);
+		quads[i * 4 + 2] = vec3(p.x + r, p.y + r, p.z);
+		quads[i * 4 + 3] = vec3(p.x - r, p.y + r, p.z);
+	}
+	quadScale = worldPerPixel;
+	return quads.data();
+}
+
+void PointSymbols::rasterize(SoftRenderer& target, unsigned int first, int n) const{
+	const RasterImage& sheet = atlas->getImage();
+	const vec3* points = geometry->points.data();
+	for (unsigned int k = first; k < first + n; k++)
+		target.drawSprite(points[k], sheet, cells[symbols[k]]);
+}
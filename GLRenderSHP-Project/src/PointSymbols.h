@@ -0,0 +1,94 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef POINTSYMBOLS_H_DEF
+#define POINTSYMBOLS_H_DEF
+
+#include "LayerGeometry.h"
+#include "SoftRaster.h"
+#include <memory>
+
+using namespace std;
+
+class LayerAttributes;
+
+/*
+	Sheet of point symbols, one square cell per symbol, drawn in code: a
+	coloured shape (circle, square, cross, ...) with a dark outline. The
+	image is premultiplied as the software renderer wants it; the GL
+	texture made from it on first bind() is not.
+*/
+class SymbolAtlas {
+public:
+	// Symbols for the type ids of the sample POIs (poi_typen.dbf), shared by every layer.
+	static shared_ptr<const SymbolAtlas> getDefault();
+
+	int getSymbolCount() const { return nSymbols; }
+	int getCellSize() const { return cellSize; }
+	const RasterImage& getImage() const { return image; }
+	PixelRect getCell(int symbol) const;
+	vec4 getTexCoords(int symbol) const; // (s0, t0, s1, t1)
+
+	// GL thread only.
+	void bind() const;
+
+private:
+	RasterImage image;
+	int cellSize, nSymbols, columns;
+	mutable unsigned int texture;
+
+	SymbolAtlas(int cellSize, int nSymbols);
+	void drawSymbol(int symbol);
+};
+
+/*
+	POI symbols of a point layer: per point of the geometry its position
+	and atlas symbol, taken once from the shape's value in the type column
+	(out-of-range and missing types get symbol 0).
+
+	For GL every point becomes a textured quad, a fixed number of pixels
+	wide. GL 1.1 has neither instancing nor point sprites, so the quads'
+	corners are expanded on the CPU; they depend only on the zoom, so they
+	are rebuilt when the scale changes, not when the view pans, and a
+	layer's symbols are one draw call. The software path stamps the same
+	cells into the image.
+*/
+class PointSymbols {
+public:
+	PointSymbols(const shared_ptr<const LayerGeometry>& geometry, const LayerAttributes* attrs, int typeColumn,
+		const shared_ptr<const SymbolAtlas>& atlas);
+
+	const SymbolAtlas& getAtlas() const { return *atlas; }
+	// Half the symbol size in pixels.
+	float getRadius() const { return atlas->getCellSize() * 0.5f; }
+	int getSymbol(int point) const { return symbols[point]; }
+
+	// Four corners per point, counter-clockwise, for the given zoom; quad i is vertices 4i .. 4i + 3.
+	const vec3* getQuads(float worldPerPixel);
+	const vec2* getTexCoords() const { return texCoords.data(); }
+
+	// The symbols of points [first, first + n).
+	void rasterize(SoftRenderer& target, unsigned int first, int n) const;
+
+private:
+	shared_ptr<const LayerGeometry> geometry;
+	shared_ptr<const SymbolAtlas> atlas;
+	vector<unsigned char> symbols;   // per point
+	vector<PixelRect> cells;         // per symbol
+	vector<vec2> texCoords;          // 4 per point
+	vector<vec3> quads;              // 4 per point, for quadScale
+	float quadScale;
+
+	PointSymbols(const PointSymbols&);
+	PointSymbols& operator=(const PointSymbols&);
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "PolygonFill.h"
+#include <GL/glut.h>
+#include <deque>
+
+using namespace std;
+
+#ifndef CALLBACK
+#define CALLBACK
+#endif
+
+typedef void (CALLBACK* TessCallback)();
+
+struct TessContext {
+	vector<vec3>* triangles;
+	deque<vec3> created; // vertices made at ring intersections
+};
+
+static void CALLBACK tessVertex(void* vertex, void* ctx){
+	((TessContext*)ctx)->triangles->push_back(*(const vec3*)vertex);
+}
+
+static void CALLBACK tessCombine(GLdouble coords[3], void* /*vertex*/[4], GLfloat /*weight*/[4], void** out, void* ctx){
+	TessContext* c = (TessContext*)ctx;
+	c->created.push_back(vec3((float)coords[0], (float)coords[1], (float)coords[2]));
+	*out = &c->created.back();
+}
+
+// With an edge flag callback the tessellator emits separate triangles only.
+static void CALLBACK tessEdgeFlag(GLboolean, void*){
+}
+
+static void CALLBACK tessBegin(GLenum, void*){
+}
+
+void tessellatePolygons(const LayerGeometry& geom, vector<vec3>& triangles){
+	GLUtesselator* tess = gluNewTess();
+	if (tess == NULL)
+		return;
+	TessContext ctx;
+	ctx.triangles = &triangles;
+	gluTessCallback(tess, GLU_TESS_BEGIN_DATA, (TessCallback)tessBegin);
+	gluTessCallback(tess, GLU_TESS_VERTEX_DATA, (TessCallback)tessVertex);
+	gluTessCallback(tess, GLU_TESS_COMBINE_DATA, (TessCallback)tessCombine);
+	gluTessCallback(tess, GLU_TESS_EDGE_FLAG_DATA, (TessCallback)tessEdgeFlag);
+	gluTessProperty(tess, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_ODD);
+	gluTessNormal(tess, 0, 0, 1);
+
+	vector<GLdouble> coords; // must live until the polygon ends
+	int nParts = geom.getPartCount();
+	for (int first = 0; first < nParts;){
+		int last = first;
+		while (last < nParts && geom.partShape[last] == geom.partShape[first])
+			last++;
+		size_t nPoints = geom.partStart[last] - geom.partStart[first];
+		coords.resize(nPoints * 3);
+		size_t k = 0;
+		gluTessBeginPolygon(tess, &ctx);
+		for (int p = first; p < last; p++){
+			const vec3* v = geom.getPart(p);
+			int n = geom.getPartSize(p);
+			if (n > 1 && v[0] == v[n - 1])
+				n--; // rings repeat their first vertex
+			if (n < 3)
+				continue;
+			gluTessBeginContour(tess);
+			for (int i = 0; i < n; i++, k += 3){
+				coords[k] = v[i].x;
+				coords[k + 1] = v[i].y;
+				coords[k + 2] = v[i].z;
+				gluTessVertex(tess, &coords[k], (void*)&v[i]);
+			}
+			gluTessEndContour(tess);
+		}
+		gluTessEndPolygon(tess);
+		first = last;
+	}
+	gluDeleteTess(tess);
+}
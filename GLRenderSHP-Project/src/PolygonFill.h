@@ -0,0 +1,25 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef POLYGONFILL_H_DEF
+#define POLYGONFILL_H_DEF
+
+#include "LayerGeometry.h"
+
+/*
+	Triangles covering the polygon shapes of geom, three vertices each.
+	The rings of a shape are tessellated together with the odd winding
+	rule, so holes stay open whichever way they are wound. Uses the GLU
+	tessellator, which needs no GL context: safe on loader threads.
+*/
+void tessellatePolygons(const LayerGeometry& geom, vector<vec3>& triangles);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "RenderThread.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+using namespace std;
+
+void applyViewCommand(Camera& camera, const vector<LayerHandle>& layers, const ViewCommand& c){
+	switch (c.type){
+	case VIEW_PAN:
+		camera.pan(c.x, c.y);
+		break;
+	case VIEW_ZOOM:
+		camera.zoomAt((int)c.x, (int)c.y, c.factor);
+		break;
+	case VIEW_RESIZE:
+		camera.setViewport((int)c.x, (int)c.y);
+		break;
+	case VIEW_RESET:
+		camera.reset();
+		break;
+	case VIEW_WORLD:
+		camera.setWorld(c.world);
+		break;
+	case VIEW_TOGGLE_LAYER:
+		if (c.layer >= 0 && c.layer < (int)layers.size())
+			layers[c.layer]->setVisible(!layers[c.layer]->isVisible());
+		break;
+	case VIEW_LAYERS_CHANGED:
+		break;
+	}
+}
+
+RenderThread::RenderThread(const LayerRegistry& layers)
+	: layers(layers), budgetMs(0), stopping(false), back(2), front(0), middle(1), applied(0), published(0){
+}
+
+RenderThread::~RenderThread(){
+	stop();
+}
+
+void RenderThread::start(const vec4& background, double budget){
+	if (worker.joinable())
+		return;
+	compositor.setBackground(background);
+	budgetMs = budget;
+	stopping = false;
+	worker = thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop(){
+	if (!worker.joinable())
+		return;
+	{
+		lock_guard<mutex> guard(wakeLock);
+		stopping = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+/*
+	The lock is taken only to order the push against the render thread
+	going to sleep (so the wake-up is not lost); that thread holds it just
+	while it checks the queue, never while it draws.
+*/
+bool RenderThread::post(const ViewCommand& c){
+	if (!commands.push(c))
+		return false;
+	{
+		lock_guard<mutex> guard(wakeLock);
+	}
+	wake.notify_one();
+	return true;
+}
+
+const RasterImage& RenderThread::acquireFrame(){
+	if (hasNewFrame())
+		front = middle.exchange(front, memory_order_acq_rel) & ~newFrame;
+	return frames[front];
+}
+
+/*
+	Takes every queued command before drawing, so a burst of pans costs
+	one frame. Draws again while the compositor is refining, sleeps when
+	the frame is final and nothing is queued.
+*/
+void RenderThread::run(){
+	Trace::setThreadName("render");
+	bool dirty = true;
+	for (;;){
+		{
+			unique_lock<mutex> guard(wakeLock);
+			if (!dirty && !compositor.isRefining())
+				wake.wait(guard, [this]{ return stopping.load() || !commands.empty(); });
+			if (stopping)
+				break;
+		}
+		vector<LayerHandle> snapshot = layers.snapshot();
+		ViewCommand c;
+		while (commands.pop(c)){
+			applyViewCommand(camera, snapshot, c);
+			applied++;
+			dirty = true;
+		}
+
+		ScopedTimer frameTimer(PHASE_FRAME_RENDER);
+		TraceScope trace("frame", "render");
+		Metrics::add(COUNTER_FRAMES);
+		const RasterImage& frame = compositor.compose(snapshot, camera, budgetMs);
+		frames[back] = frame;
+		back = middle.exchange(back | newFrame, memory_order_acq_rel) & ~newFrame;
+		published.store(applied, memory_order_release);
+		dirty = false;
+	}
+	compositor.clear();
+}
@@ -0,0 +1,116 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef RENDERTHREAD_H_DEF
+#define RENDERTHREAD_H_DEF
+
+#include "LayerRegistry.h"
+#include "LayerCompositor.h"
+#include "CommandQueue.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+enum ViewCommandType {
+	VIEW_PAN,          // x, y: pixels, y down
+	VIEW_ZOOM,         // at pixel (x, y) by factor
+	VIEW_RESIZE,       // x, y: viewport size
+	VIEW_RESET,
+	VIEW_WORLD,        // new extent (and reset)
+	VIEW_TOGGLE_LAYER, // show/hide layers[layer] of the current snapshot
+	VIEW_LAYERS_CHANGED
+};
+
+struct ViewCommand {
+	ViewCommandType type;
+	double x, y, factor;
+	vec4 world;
+	int layer;
+
+	static ViewCommand make(ViewCommandType type, double x = 0, double y = 0, double factor = 1){
+		ViewCommand c;
+		c.type = type;
+		c.x = x;
+		c.y = y;
+		c.factor = factor;
+		c.layer = -1;
+		return c;
+	}
+};
+
+// What the command does to a camera and layer list; the same for every renderer.
+void applyViewCommand(Camera& camera, const vector<LayerHandle>& layers, const ViewCommand& c);
+
+/*
+	Draws the map away from the window's thread. The thread owns the camera
+	and a LayerCompositor; other threads only post commands to it through
+	a lock-free queue, so posting never waits for a frame being drawn.
+	Layers come from the registry as snapshots taken per frame: a layer is
+	complete when it is added, so loaders can add layers at any time and
+	post VIEW_LAYERS_CHANGED.
+
+	Finished frames go through a triple buffer: the thread draws into its
+	back image and swaps it with the middle one, the window takes the
+	middle one when it is newer. Neither side waits; the window always has
+	a whole frame to show.
+
+	GL stays with GLUT's thread: the window only copies frames to the
+	screen (see GLRenderSHP.cpp).
+*/
+class RenderThread {
+public:
+	RenderThread(const LayerRegistry& layers);
+	~RenderThread();
+
+	// budgetMs as LayerCompositor::compose.
+	void start(const vec4& background, double budgetMs);
+	void stop();
+
+	// Any thread. False if the queue is full and the command was dropped.
+	bool post(const ViewCommand& c);
+
+	// Window thread: a newer frame than the one acquireFrame() returned last is waiting.
+	bool hasNewFrame() const { return (middle.load(memory_order_acquire) & newFrame) != 0; }
+	// Window thread: the newest finished frame; stays valid until the next call.
+	const RasterImage& acquireFrame();
+	// Commands posted so far whose effect is in a published frame.
+	unsigned int getPublishedCommands() const { return published.load(memory_order_acquire); }
+
+private:
+	static const int newFrame = 4; // flag next to the buffer index in middle
+
+	const LayerRegistry& layers;
+	Camera camera;
+	LayerCompositor compositor;
+	double budgetMs;
+	CommandQueue<ViewCommand, 1024> commands;
+
+	thread worker;
+	atomic<bool> stopping;
+	mutex wakeLock;               // only for sleeping on wake; never held while drawing
+	condition_variable wake;
+
+	RasterImage frames[3];
+	int back;                     // render thread's
+	int front;                    // window's
+	atomic<int> middle;
+	unsigned int applied;         // commands taken from the queue
+	atomic<unsigned int> published;
+
+	void run();
+
+	RenderThread(const RenderThread&);
+	RenderThread& operator=(const RenderThread&);
+};
+
+#endif
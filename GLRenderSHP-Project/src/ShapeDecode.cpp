@@ -0,0 +1,225 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "ShapeDecode.h"
+#include "DecodeKernels.h"
+#include "shapefil.h"
+
+using namespace std;
+
+bool parseShapeRecord(const unsigned char* rec, size_t len, ShapeRecordLayout& out){
+	out.nParts = 0;
+	out.nPoints = 0;
+	out.bbox = out.parts = out.xy = out.z = NULL;
+	if (len < 4)
+		return false;
+
+	out.shpType = readLEInt(rec);
+	switch (out.shpType){
+	case SHPT_NULL:
+		return true;
+
+	case SHPT_POINT:
+	case SHPT_POINTZ:
+	case SHPT_POINTM:
+		if (len < (out.shpType == SHPT_POINTZ ? 28u : 20u))
+			return false;
+		out.nPoints = 1;
+		out.xy = rec + 4;
+		if (out.shpType == SHPT_POINTZ)
+			out.z = rec + 20;
+		return true;
+
+	case SHPT_MULTIPOINT:
+	case SHPT_MULTIPOINTZ:
+	case SHPT_MULTIPOINTM:
+	case SHPT_ARC:
+	case SHPT_ARCZ:
+	case SHPT_ARCM:
+	case SHPT_POLYGON:
+	case SHPT_POLYGONZ:
+	case SHPT_POLYGONM:
+	case SHPT_MULTIPATCH:
+	{
+		if (len < 40)
+			return false;
+		out.bbox = rec + 4;
+
+		bool multiPoint = (out.shpType == SHPT_MULTIPOINT || out.shpType == SHPT_MULTIPOINTZ
+			|| out.shpType == SHPT_MULTIPOINTM);
+		bool hasZ = (out.shpType == SHPT_MULTIPOINTZ || out.shpType == SHPT_ARCZ
+			|| out.shpType == SHPT_POLYGONZ || out.shpType == SHPT_MULTIPATCH);
+
+		size_t nParts, nPoints, offset;
+		if (multiPoint){
+			nParts = 0;
+			nPoints = (size_t)(unsigned int)readLEInt(rec + 36);
+			offset = 40;
+			if (nPoints > (len - offset) / 16)
+				return false;
+		}
+		else{
+			if (len < 44)
+				return false;
+			nParts = (size_t)(unsigned int)readLEInt(rec + 36);
+			nPoints = (size_t)(unsigned int)readLEInt(rec + 40);
+			offset = 44;
+			size_t partBytes = nParts * (out.shpType == SHPT_MULTIPATCH ? 8 : 4);
+			if (nParts > len || nPoints > len || offset + partBytes + nPoints * 16 > len)
+				return false;
+			out.parts = rec + offset;
+			int prev = 0;
+			for (size_t i = 0; i < nParts; i++){
+				int start = readLEInt(out.parts + i * 4);
+				if (start < prev || (size_t)start >= nPoints)
+					return false;
+				prev = start;
+			}
+			offset += partBytes;
+		}
+		out.nParts = (int)nParts;
+		out.nPoints = (int)nPoints;
+		out.xy = rec + offset;
+		offset += nPoints * 16;
+
+		// Z range + values; optional in practice, as in shapelib
+		if (hasZ && offset + 16 + nPoints * 8 <= len)
+			out.z = rec + offset + 16;
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+/*
+	Bounds of the record: from the bbox block, or the point itself.
+*/
+static void layoutBounds(const ShapeRecordLayout& l, double bmin[2], double bmax[2]){
+	if (l.bbox){
+		bmin[0] = readLEDouble(l.bbox);
+		bmin[1] = readLEDouble(l.bbox + 8);
+		bmax[0] = readLEDouble(l.bbox + 16);
+		bmax[1] = readLEDouble(l.bbox + 24);
+	}
+	else if (l.nPoints > 0){
+		bmin[0] = bmax[0] = readLEDouble(l.xy);
+		bmin[1] = bmax[1] = readLEDouble(l.xy + 8);
+	}
+	else
+		bmin[0] = bmin[1] = bmax[0] = bmax[1] = 0.0;
+}
+
+bool decodeShapeRecord(const unsigned char* rec, size_t len, Feature& out){
+	out.partStart.clear();
+	out.x.clear();
+	out.y.clear();
+	out.z.clear();
+
+	ShapeRecordLayout l;
+	bool ok = parseShapeRecord(rec, len, l);
+	out.shpType = (len >= 4) ? l.shpType : SHPT_NULL;
+	layoutBounds(l, out.boundsMin, out.boundsMax);
+	if (!ok)
+		return false;
+
+	if (l.nParts == 0 && l.nPoints > 0)
+		out.partStart.push_back(0);
+	for (int i = 0; i < l.nParts; i++)
+		out.partStart.push_back(readLEInt(l.parts + i * 4));
+
+	out.x.resize(l.nPoints);
+	out.y.resize(l.nPoints);
+	if (l.nPoints > 0)
+		decodeKernels().toDouble(l.xy, l.nPoints, &out.x[0], &out.y[0], NULL);
+	if (l.z){
+		out.z.resize(l.nPoints);
+		for (int i = 0; i < l.nPoints; i++)
+			out.z[i] = readLEDouble(l.z + i * 8);
+	}
+	return true;
+}
+
+bool decodeShapeRecord(const unsigned char* rec, size_t len, Arena& arena, ShapeView& out){
+	ShapeRecordLayout l;
+	out.nParts = out.nVertices = 0;
+	out.partStart = NULL;
+	out.x = out.y = out.z = NULL;
+	if (!parseShapeRecord(rec, len, l))
+		return false;
+	out.shpType = l.shpType;
+	layoutBounds(l, out.boundsMin, out.boundsMax);
+
+	out.nParts = (l.nParts == 0 && l.nPoints > 0) ? 1 : l.nParts;
+	out.nVertices = l.nPoints;
+	out.partStart = arena.allocArray<int>(out.nParts);
+	if (l.nParts == 0 && l.nPoints > 0)
+		out.partStart[0] = 0;
+	for (int i = 0; i < l.nParts; i++)
+		out.partStart[i] = readLEInt(l.parts + i * 4);
+
+	out.x = arena.allocArray<double>(l.nPoints);
+	out.y = arena.allocArray<double>(l.nPoints);
+	decodeKernels().toDouble(l.xy, l.nPoints, out.x, out.y, NULL);
+	if (l.z){
+		out.z = arena.allocArray<double>(l.nPoints);
+		for (int i = 0; i < l.nPoints; i++)
+			out.z[i] = readLEDouble(l.z + i * 8);
+	}
+	return true;
+}
+
+static vec4 pointBounds(const vec3* v, int n){
+	if (n <= 0)
+		return vec4(0, 0, 0, 0);
+	vec4 b(v[0].x, v[0].y, v[0].x, v[0].y);
+	for (int i = 1; i < n; i++){
+		b.x = v[i].x < b.x ? v[i].x : b.x;
+		b.y = v[i].y < b.y ? v[i].y : b.y;
+		b.z = v[i].x > b.z ? v[i].x : b.z;
+		b.w = v[i].y > b.w ? v[i].y : b.w;
+	}
+	return b;
+}
+
+bool appendShapeRecord(const unsigned char* rec, size_t len, int shapeID, LayerGeometry& dest){
+	ShapeRecordLayout l;
+	if (!parseShapeRecord(rec, len, l))
+		return false;
+	if (l.nPoints == 0)
+		return true;
+
+	size_t base = dest.points.size();
+	dest.points.resize(base + l.nPoints);
+	vec3* out = &dest.points[base];
+	decodeKernels().toVec3(l.xy, l.nPoints, out, NULL);
+	if (l.z){
+		for (int i = 0; i < l.nPoints; i++)
+			out[i].z = (float)readLEDouble(l.z + i * 8);
+	}
+
+	if (l.nParts == 0){
+		// a point, or all the points of a multipoint as one part
+		dest.partStart.push_back((unsigned int)(base + l.nPoints));
+		dest.partShape.push_back(shapeID);
+		dest.partBounds.push_back(pointBounds(out, l.nPoints));
+		return true;
+	}
+	for (int i = 0; i < l.nParts; i++){
+		int begin = i ? readLEInt(l.parts + i * 4) : 0; // as partStart: from the previous end
+		int end = (i + 1 < l.nParts) ? readLEInt(l.parts + (i + 1) * 4) : l.nPoints;
+		dest.partStart.push_back((unsigned int)(base + end));
+		dest.partShape.push_back(shapeID);
+		dest.partBounds.push_back(pointBounds(out + begin, end - begin));
+	}
+	return true;
+}
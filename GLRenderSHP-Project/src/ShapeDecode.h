@@ -0,0 +1,111 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef SHAPEDECODE_H_DEF
+#define SHAPEDECODE_H_DEF
+
+#include "Arena.h"
+#include "LayerGeometry.h"
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+
+inline bool hostIsBigEndian(){
+	unsigned int one = 1;
+	return *(const unsigned char*)&one == 0;
+}
+
+inline int readLEInt(const unsigned char* p){
+	return (int)((unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24));
+}
+
+inline unsigned int readBEUInt(const unsigned char* p){
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+inline double readLEDouble(const unsigned char* p){
+	double d;
+	if (!hostIsBigEndian()){
+		memcpy(&d, p, 8);
+		return d;
+	}
+	unsigned char b[8];
+	for (int i = 0; i < 8; i++)
+		b[i] = p[7 - i];
+	memcpy(&d, b, 8);
+	return d;
+}
+
+/*
+	Where things are inside one .shp record (content after the 8 byte record header).
+	The pointers point into the record bytes; nothing is copied or swapped yet.
+*/
+struct ShapeRecordLayout {
+	int shpType;
+	int nParts;                 // 0 for point types
+	int nPoints;
+	const unsigned char* bbox;  // xmin, ymin, xmax, ymax as LE doubles; NULL for points
+	const unsigned char* parts; // nParts LE ints
+	const unsigned char* xy;    // nPoints interleaved LE x,y doubles
+	const unsigned char* z;     // nPoints LE doubles, NULL when absent
+};
+
+/*
+	Validate a record and locate its parts and coordinates, following the
+	same layout rules as SHPReadObject(). Returns false if it is truncated or
+	of an unsupported type.
+*/
+bool parseShapeRecord(const unsigned char* rec, size_t len, ShapeRecordLayout& out);
+
+/*
+	One decoded record with its own storage. Coordinates are kept in double
+	precision; z is only filled for the Z shape types.
+*/
+struct Feature {
+	int id;
+	int shpType;
+	double boundsMin[2], boundsMax[2];
+	vector<int> partStart;
+	vector<double> x, y, z;
+
+	Feature() : id(-1), shpType(0) {}
+	int getVertexCount() const { return (int)x.size(); }
+};
+
+bool decodeShapeRecord(const unsigned char* rec, size_t len, Feature& out);
+
+/*
+	One decoded record whose arrays live in a caller-owned Arena
+	(the allocation-free counterpart of SHPObject). Valid until the arena is reset.
+*/
+struct ShapeView {
+	int shpType;
+	int nParts;
+	int nVertices;
+	double boundsMin[2], boundsMax[2];
+	int* partStart; // nParts entries (1 for points)
+	double* x;
+	double* y;
+	double* z;      // NULL when the record has no Z
+};
+
+bool decodeShapeRecord(const unsigned char* rec, size_t len, Arena& arena, ShapeView& out);
+
+/*
+	Decode a record straight into a layer's flat geometry store, one part per
+	shape part (or per point). Nothing is allocated besides the growth of the
+	destination arrays. Returns false and leaves dest untouched on a bad record.
+*/
+bool appendShapeRecord(const unsigned char* rec, size_t len, int shapeID, LayerGeometry& dest);
+
+#endif
@@ -10,164 +10,455 @@ Using ShapeLib version 1.3
 */
 
 #include "ShapeFile.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "ShapeScanner.h"
+#include "LayerAttributes.h"
+#include "PolygonFill.h"
+#include "PointSymbols.h"
+#include "Decimate.h"
+#include "Clip.h"
+#include "SpatialOrder.h"
+#include <algorithm>
 #include <GL/glut.h>
 #include <stdlib.h>
 
 using namespace std;
 
-int ShapeFile::shpCount = 0;
+float ShapeFile::decimation = 0.5f;
+bool ShapeFile::spatialOrder = false;
 
-ShapeFile::ShapeFile(const char* fileName){
-	this->filename = string(fileName);
-	init();
+static bool boundsInside(const vec4& inner, const vec4& outer){
+	return inner.x >= outer.x && inner.y >= outer.y && inner.z <= outer.z && inner.w <= outer.w;
+}
+
+/*
+	The segments of a path through geom's vertices (indices into points)
+	that are not wholly beyond one side of view; GL clips the rest.
+	Returns how many were left out.
+*/
+static int addVisibleSegments(DrawList& list, const LayerGeometry& geom, const unsigned int* path, int n,
+	bool closed, const vec4& view, vector<unsigned char>& codes){
+	// outcodes of the part's vertices in one pass, then looked up through the path
+	unsigned int first = path[0];
+	int span = (int)(path[n - 1] - first) + 1;
+	codes.resize(span);
+	outcodeKernel()(&geom.points[first], span, view, codes.data());
+	int skipped = 0;
+	for (int i = 1; i < n; i++){
+		if (codes[path[i - 1] - first] & codes[path[i] - first]){
+			skipped++;
+			continue;
+		}
+		list.addIndex(path[i - 1]);
+		list.addIndex(path[i]);
+	}
+	if (closed && n > 2){
+		if (codes[path[n - 1] - first] & codes[0])
+			skipped++;
+		else {
+			list.addIndex(path[n - 1]);
+			list.addIndex(path[0]);
+		}
+	}
+	return skipped;
+}
+
+/*
+	Decimation pays for itself on parts with more vertices than cells across
+	their bounds; a short street of a few vertices keeps them all anyway.
+*/
+static bool isDenserThanGrid(const LayerGeometry& geom, int p, const DecimateGrid& grid){
+	if (geom.partBounds.empty())
+		return true;
+	const vec4& b = geom.partBounds[p];
+	return geom.getPartSize(p) > ((b.z - b.x) + (b.w - b.y)) * grid.invCell + 2;
+}
+
+/*
+	Loads <fileName>.shp/.shx and its attributes. NULL, after saying why,
+	when any of the files is missing or unreadable.
+*/
+shared_ptr<ShapeFile> ShapeFile::open(const char* fileName){
+	shared_ptr<const LayerGeometry> geometry = load(fileName);
+	if (!geometry)
+		return shared_ptr<ShapeFile>();
+	shared_ptr<const LayerAttributes> attributes = loadAttributes(fileName);
+	if (!attributes)
+		return shared_ptr<ShapeFile>();
+	return shared_ptr<ShapeFile>(new ShapeFile(geometry, attributes));
+}
 
-	shpID = ShapeFile::shpCount;
+/*
+	A layer over already loaded geometry and attributes. Nothing is copied.
+*/
+ShapeFile::ShapeFile(const shared_ptr<const LayerGeometry>& geometry, const shared_ptr<const LayerAttributes>& attributes){
+	this->geometry = geometry;
+	this->attributes = attributes;
+	style = defaultStyle(geometry->shpType);
+	styleRevision = 0;
+	visibleFlag = true;
+	shpID = 0;
+	traceName = NULL;
 }
 
 ShapeFile::~ShapeFile(){
-	cout << "Closing SHP: " << filename << endl << endl;
-	entities.clear();
+	if (geometry.use_count() == 1)
+		cout << "Closing SHP: " << geometry->filename << endl << endl;
 }
 
 /*
-	Open, read the shapefile data to an array of Entities, then close the files.
+	Open, read the shapefile data into the flat geometry store, then close the files.
+	Records are decoded straight from the scanner's read blocks into the store,
+	so no per-record SHPObject is allocated.
 */
-void ShapeFile::init(){
-	ShapeFile::shpCount++;
-	cout << ShapeFile::shpCount << endl;
+shared_ptr<const LayerGeometry> ShapeFile::load(const char* fileName){
+	TraceScope trace(Trace::isEnabled() ? Trace::intern(fileName) : fileName, "load");
+	shared_ptr<LayerGeometry> geom(new LayerGeometry());
+	geom->filename = string(fileName);
+	const string& filename = geom->filename;
 
 	//////////// OPEN SHP
-	hSHP = SHPOpen((filename + ".shp").c_str(), "rb");
-	if (hSHP == NULL)
+	ShapeReader reader;
+	if (!reader.open(filename))
 	{
-		printf("error reading hSHP file");
-		system("pause");
-		exit(1);
+		printf("error reading hSHP file %s\n", fileName);
+		return shared_ptr<const LayerGeometry>();
 	}
-	/////////////// OPEN DBF
-	hDBF = DBFOpen((filename + ".dbf").c_str(), "rb");
-	if (hDBF == NULL)
-	{
-		printf("error reading hDBF file");
-		system("pause");
-		exit(1);
-	}
-
 	//////////// Get SHP info
-	double padMinBound[4], padMaxBound[4]; // XYZM max and min values
-	SHPGetInfo(hSHP, &nEntities, &shpType, padMinBound, padMaxBound);
+	const ShapeIndex& index = *reader.getIndex();
+	int nEntities = index.getRecordCount();
+	int shpType = index.shpType;
+	geom->shpType = shpType;
 	//Read Bounding Box of Shapefile
-	boundBoxMax = vec2(padMaxBound[0], padMaxBound[1]);
-	boundBoxMin = vec2(padMinBound[0], padMinBound[1]);
+	geom->boundBoxMax = vec2(index.boundsMax[0], index.boundsMax[1]);
+	geom->boundBoxMin = vec2(index.boundsMin[0], index.boundsMin[1]);
 
 	cout << endl << "Reading " << filename << endl;
 	cout << "#entities= " << nEntities << endl;
 	cout << "ShapeType= " << typeStr(shpType) << endl;
-	cout << "boundaries= " << boundBoxMin << ", " << boundBoxMax << endl;
+	cout << "boundaries= " << geom->boundBoxMin << ", " << geom->boundBoxMax << endl;
 
-	//printDBFHeader(10);
+	//printDBFHeader(hDBF, 10);
 
-	//read entities and store them into a Vector
+	//read entities and store them into the geometry store
 	cout << "Reading entities...." << endl;
-	SHPObject *psShape;
+	size_t contentBytes = 0;
+	for (int i = 0; i < nEntities; i++)
+		contentBytes += index.recSize[i];
+	geom->points.reserve(contentBytes / 16); // upper bound: 16 bytes per XY pair on disk
+	geom->partStart.reserve(nEntities + 1);
+	geom->partShape.reserve(nEntities);
+	ShapeScanner scanner(reader); // records are contiguous: read in large blocks, several read ahead
+	const int traceBatch = 1024;
 	for (int i = 0; i < nEntities; i++)
 	{
-		psShape = SHPReadObject(hSHP, i); // le do arquivo
-		if (psShape == NULL)
-			return;
-
-		//Pozzer
-		//informacoes de cada shape
-		//printf("\nEntities = %d\n", psShape->nVertices);
-		//printf("\nParts = %d\n", psShape->nParts);
-
-		//
-		if (shpType == SHPT_POINT || shpType == SHPT_POINTZ){
-			Entity e;
-			e.points.push_back(vec3(psShape->padfX[0], psShape->padfY[0], psShape->padfZ[0]));
-			entities.push_back(e);
+		if (i % traceBatch == 0 && Trace::isEnabled()){
+			if (i > 0)
+				Trace::end("record batch", "load");
+			Trace::begin("record batch", "load");
 		}
-		else{
-			//Pozzer
-			//indice do vetor de shapes. Faz a leitura de traz para frente
-			int idx = psShape->nVertices - 1;
-			//Pozzer
-			//para cada parte que compoe cada shape, determina o numero de primitivas (nParts)
-			for (int i = psShape->nParts - 1; i >= 0; i--)
-			{
-				Entity e;
-				//printf("\nPart[%d] = %d ",i, psShape->panPartStart[i]);
-				for (; idx >= psShape->panPartStart[i]; idx--)
-				{
-					//printf("\n %f %f %f %f", psShape->padfX[j], psShape->padfY[j], psShape->padfZ[j], psShape->padfM );
-					e.points.push_back(vec3(psShape->padfX[idx], psShape->padfY[idx], psShape->padfZ[idx]));
-				}
-				entities.push_back(e);
-			}
-			SHPDestroyObject(psShape); // deleta o objeto
+		ScopedTimer timer(PHASE_RECORD_DECODE);
+		const unsigned char* record;
+		size_t recordLen;
+		if (!scanner.read(i, record, recordLen)){ // le do arquivo
+			printf("skipping unreadable shape %d\n", i);
+			continue;
 		}
+		if (recordLen > 0 && !appendShapeRecord(record, recordLen, i, *geom)){
+			printf("skipping unreadable shape %d\n", i);
+			continue;
+		}
+		Metrics::add(COUNTER_RECORDS);
 	}
-	cout << "Entities successfully read: " << entities.size() << endl << endl;
+	if (nEntities > 0 && Trace::isEnabled())
+		Trace::end("record batch", "load");
+	cout << "Entities successfully read: " << geom->getPartCount() << endl << endl;
 
-	/// All data is already read, so we can close the files
-	SHPClose(hSHP);
-	DBFClose(hDBF);
-	hSHP = NULL;
-	hDBF = NULL;
+	if (spatialOrder)
+		reorderAlongHilbert(*geom);
+	else
+		buildBlockBounds(*geom);
+	return geom;
 }
 
 /*
-	De acordo com o tipo da primitva da Shape, aciona o glBegin correspondente.
-	*/
-void ShapeFile::beginPrimitive(int shpType){
-	if (shpID == 1)
-		glColor3f(1.0f, 0.0f, 0.0f);
-	else if (shpID == 2)
-		glColor3f(0.0f, 1.0f, 0.0f);
+	Read the .dbf into a column store and join the side tables (names, types)
+	that the sample data keeps next to the layer.
+*/
+shared_ptr<const LayerAttributes> ShapeFile::loadAttributes(const char* fileName){
+	shared_ptr<LayerAttributes> attrs = LayerAttributes::load(fileName);
+	if (!attrs)
+	{
+		printf("error reading hDBF file %s\n", fileName);
+		return shared_ptr<const LayerAttributes>();
+	}
+	int nJoined = attrs->joinSideTables(fileName);
+	cout << "Attributes of " << fileName << ": " << attrs->getColumnCount() << " columns";
+	if (nJoined > 0)
+		cout << " (" << nJoined << " side tables joined)";
+	cout << endl;
+	return attrs;
+}
+
+/*
+	The viewer's colours when no session says otherwise:
+	points blue, lines green, polygon outlines red.
+*/
+LayerStyle ShapeFile::defaultStyle(int shpType){
+	LayerStyle s;
+	if (shpType == SHPT_POINT || shpType == SHPT_POINTZ)
+		s.stroke = vec4(0, 0, 1, 1);
+	else if (shpType == SHPT_ARC || shpType == SHPT_ARCZ)
+		s.stroke = vec4(0, 1, 0, 1);
 	else
-		glColor3f(0.0f, 0.0f, 1.0f);
-	if (shpType == SHPT_POINT || shpType == SHPT_POINTZ){ //Point | PointZ
-		glColor3f(0.0, 0.0, 1.0);
-		glEnable(GL_POINT_SMOOTH);
-		glPointSize(5.0);
-		glBegin(GL_POINTS);
+		s.stroke = vec4(1, 0, 0, 1);
+	return s;
+}
+
+void ShapeFile::setSymbols(const shared_ptr<const SymbolAtlas>& atlas){
+	int typeColumn = attributes ? attributes->getTypeColumn() : -1;
+	if (atlas && typeColumn >= 0)
+		symbols.reset(new PointSymbols(geometry, attributes.get(), typeColumn, atlas));
+	else
+		symbols.reset();
+	styleRevision++;
+}
+
+float ShapeFile::getMarkRadius() const{
+	if (symbols)
+		return symbols->getRadius();
+	if (partKind(geometry->shpType) == PARTS_POINTS)
+		return 2.5f;
+	float r = style.strokeWidth / 2;
+	if (isStroked()){
+		// a bucket's width is up to 9% over; miters and square caps reach further out
+		r *= 1.1f;
+		if (style.join == JOIN_MITER)
+			r *= max(style.miterLimit, 1.0f);
+		else if (style.cap == CAP_SQUARE)
+			r *= 1.42f;
+	}
+	return r;
+}
+
+ShapeFile::PartKind ShapeFile::partKind(int shpType){
+	switch (shpType){
+	case SHPT_POINT: case SHPT_POINTZ: case SHPT_MULTIPOINT: case SHPT_MULTIPOINTZ:
+		return PARTS_POINTS;
+	case SHPT_ARC: case SHPT_ARCZ:
+		return PARTS_LINES;
+	case SHPT_POLYGON: case SHPT_POLYGONZ:
+		return PARTS_RINGS;
+	default:
+		return PARTS_NONE;
+	}
+}
+
+// Lines and outlines wide enough for the stroke meshes.
+bool ShapeFile::isStroked() const{
+	PartKind kind = partKind(geometry->shpType);
+	return style.isWide() && (kind == PARTS_LINES || kind == PARTS_RINGS);
+}
+
+void ShapeFile::setStyle(const LayerStyle& style){
+	this->style = style;
+	styleRevision++;
+	int type = geometry->shpType;
+	if (style.hasFill() && fillTriangles.empty() && (type == SHPT_POLYGON || type == SHPT_POLYGONZ)){
+		TraceScope trace("tessellate", "load");
+		tessellatePolygons(*geometry, fillTriangles);
+	}
+}
+
+/*
+	Parts below a pixel in size become one point each, drawn with the
+	layer's points (point layers) or as single pixels. The per-entity cost
+	noted in the list is what drawing part by part with glBegin/glEnd
+	takes: a colour and width per layer, a draw per part, and for point
+	layers the point size and smoothing again before every part.
+*/
+void ShapeFile::addDrawItems(DrawList& list, int layerOrder, const vec4& view, float worldPerPixel){
+	if (Trace::isEnabled() && traceName == NULL)
+		traceName = Trace::intern(geometry->filename);
+	TraceScope trace(traceName, "render");
+	const LayerGeometry& geom = *geometry;
+	if (!fillTriangles.empty() && style.hasFill()){
+		DrawState s = { DRAW_TRIANGLES, fillTriangles.data(), style.fill, 0, false, NULL, NULL };
+		list.beginItem(drawKey(layerOrder, DRAW_TRIANGLES, 0), s);
+		for (size_t i = 0; i + 2 < fillTriangles.size(); i += 3){
+			const vec3* t = &fillTriangles[i];
+			vec4 b(min(t[0].x, min(t[1].x, t[2].x)), min(t[0].y, min(t[1].y, t[2].y)),
+				max(t[0].x, max(t[1].x, t[2].x)), max(t[0].y, max(t[1].y, t[2].y)));
+			if (!boundsOverlap(b, view))
+				continue;
+			list.addIndex((unsigned int)i);
+			list.addIndex((unsigned int)i + 1);
+			list.addIndex((unsigned int)i + 2);
+		}
+		list.addPerEntityCost(1, 1);
 	}
-	else if (shpType == SHPT_ARC || shpType == SHPT_ARCZ){ //PolyLine | PolyLineZ
-		glColor3f(0.0, 1.0, 0.0);
-		glBegin(GL_LINE_STRIP);
+	if (!style.hasStroke())
+		return;
+	PartKind kind = partKind(geom.shpType);
+	if (kind == PARTS_NONE)
+		return;
+	bool points = kind == PARTS_POINTS;
+	bool closed = kind == PARTS_RINGS;
+	visible.clear();
+	float reach = getMarkRadius() * worldPerPixel;
+	vec4 reachView(view.x - reach, view.y - reach, view.z + reach, view.w + reach);
+	selectVisibleParts(geom, reachView, worldPerPixel, visible);
+	DrawState lines = { DRAW_LINES, geom.points.data(), style.stroke, style.strokeWidth, false, NULL, NULL };
+	DrawState marks = { DRAW_POINTS, geom.points.data(), style.stroke, 5, true, NULL, NULL };
+	// a wide stroke's tiny parts are dots as wide as the stroke
+	DrawState dots = { DRAW_POINTS, geom.points.data(), style.stroke, isStroked() ? style.strokeWidth : 1, isStroked(), NULL, NULL };
+	if (points && symbols){
+		// one quad per point, the layer's symbols as a single item: there can be a great many
+		DrawState quads = { DRAW_QUADS, symbols->getQuads(worldPerPixel), vec4(1, 1, 1, 1), 0, false,
+			symbols->getTexCoords(), &symbols->getAtlas() };
+		list.beginItem(drawKey(layerOrder, DRAW_QUADS, 0), quads);
+		for (int pass = 0; pass < 2; pass++){
+			const vector<int>& parts = pass == 0 ? visible.detailed : visible.dots;
+			for (size_t i = 0; i < parts.size(); i++){
+				int p = parts[i];
+				for (unsigned int k = geom.partStart[p]; k < geom.partStart[p + 1]; k++)
+					for (unsigned int c = 0; c < 4; c++)
+						list.addIndex(k * 4 + c);
+			}
+		}
+		list.addPerEntityCost((int)(visible.detailed.size() + visible.dots.size()),
+			2 + 2 * (int)(visible.detailed.size() + visible.dots.size()));
+		Metrics::add(COUNTER_PARTS_CULLED, visible.culled);
+		return;
 	}
-	else if (shpType == SHPT_POLYGON || shpType == SHPT_POLYGONZ){ //Polygon | PolygonZ
-		glColor3f(1.0, 0.0, 0.0);
-		glBegin(GL_LINE_LOOP);
+	if (isStroked()){
+		// the layer's stroke mesh for this zoom; the parts' triangles merge into one draw
+		const StrokeMesh& mesh = strokes.get(geom, style, styleRevision, worldPerPixel);
+		DrawState wide = { DRAW_TRIANGLES, mesh.vertices.data(), style.stroke, 0, false, NULL, NULL };
+		for (size_t i = 0; i < visible.detailed.size(); i++){
+			int p = visible.detailed[i];
+			list.beginItem(drawKey(layerOrder, DRAW_TRIANGLES, 1), wide);
+			list.addIndices(&mesh.indices[mesh.partIndices[p]], mesh.partIndices[p + 1] - mesh.partIndices[p]);
+		}
+		visible.detailed.clear();
 	}
-	else{ /// panic case
-		cout << "Type not yet supported for rendering!" << endl;
-		system("pause");
-		exit(1);
+	DecimateGrid grid;
+	bool decimate = !points && grid.make(getBoundaries(), worldPerPixel, decimation);
+	DecimateKernel kernel = decimate ? decimateKernel() : NULL;
+	long long dropped = 0, clipped = 0;
+	for (size_t i = 0; i < visible.detailed.size(); i++){
+		int p = visible.detailed[i];
+		if (points){
+			list.beginItem(drawKey(layerOrder, DRAW_POINTS, 0), marks);
+			for (int j = 0; j < geom.getPartSize(p); j++)
+				list.addIndex(geom.partStart[p] + j);
+		}
+		else {
+			int n = geom.getPartSize(p);
+			bool inside = geom.partBounds.empty() || boundsInside(geom.partBounds[p], reachView);
+			int nPath = n;
+			if (decimate && isDenserThanGrid(geom, p, grid)){
+				if (kept.size() < (size_t)n)
+					kept.resize(n);
+				nPath = (int)kernel(geom.getPart(p), n, geom.partStart[p], grid, kept.data());
+				dropped += n - nPath;
+			}
+			else if (!inside){
+				if (kept.size() < (size_t)n)
+					kept.resize(n);
+				for (int j = 0; j < n; j++)
+					kept[j] = geom.partStart[p] + j;
+			}
+			list.beginItem(drawKey(layerOrder, DRAW_LINES, 0), lines);
+			if (!inside)
+				clipped += addVisibleSegments(list, geom, kept.data(), nPath, closed, reachView, codes);
+			else if (nPath < n)
+				list.addPath(kept.data(), nPath, closed);
+			else
+				list.addStrip(geom.partStart[p], n, closed);
+		}
 	}
+	Metrics::add(COUNTER_VERTICES_DECIMATED, dropped);
+	Metrics::add(COUNTER_SEGMENTS_CLIPPED, clipped);
+	// the dots go as one item, as they went as one glBegin
+	if (!visible.dots.empty())
+		list.beginItem(drawKey(layerOrder, DRAW_POINTS, points ? 0 : 1), points ? marks : dots);
+	for (size_t i = 0; i < visible.dots.size(); i++)
+		list.addIndex(geom.partStart[visible.dots[i]]);
+	int perPart = points ? 2 : 0;
+	list.addPerEntityCost((int)visible.detailed.size() + (visible.dots.empty() ? 0 : 1),
+		2 + perPart * (int)visible.detailed.size() + (visible.dots.empty() ? 0 : (points ? 2 : 1)));
+	Metrics::add(COUNTER_PARTS_CULLED, visible.culled);
 }
 
-void ShapeFile::render(){
-	// render each entity
-	for (int i = 0; i < entities.size(); i++)
-	{
-		beginPrimitive(shpType);
-		for (int j = 0; j < entities.at(i).points.size(); j++)
-		{
-			glVertex3fv(&entities.at(i).points.at(j)[0]);
+void ShapeFile::rasterize(SoftRenderer& target, const vec4& view, float worldPerPixel){
+	rasterizeFill(target, 0, getFillTriangleCount());
+	if (!style.hasStroke() || partKind(geometry->shpType) == PARTS_NONE)
+		return;
+	visible.clear();
+	selectVisibleParts(*geometry, view, worldPerPixel, visible);
+	rasterizeParts(target, visible.detailed.data(), visible.detailed.size(), false);
+	rasterizeParts(target, visible.dots.data(), visible.dots.size(), true);
+	Metrics::add(COUNTER_PARTS_CULLED, visible.culled);
+}
+
+void ShapeFile::rasterizeFill(SoftRenderer& target, size_t first, size_t count){
+	if (count > 0 && style.hasFill())
+		target.fillTriangles(&fillTriangles[first * 3], count * 3, packColor(style.fill));
+}
+
+void ShapeFile::rasterizeParts(SoftRenderer& target, const int* parts, size_t n, bool asDots){
+	const LayerGeometry& geom = *geometry;
+	PartKind kind = partKind(geom.shpType);
+	if (n == 0 || !style.hasStroke() || kind == PARTS_NONE)
+		return;
+	unsigned int color = packColor(style.stroke);
+	int width = (int)(style.strokeWidth + 0.5f);
+	const StrokeMesh* mesh = (isStroked() && !asDots) ? &strokes.get(geom, style, styleRevision, target.getScale()) : NULL;
+	bool points = kind == PARTS_POINTS;
+	bool closed = kind == PARTS_RINGS;
+	// the same cells as addDrawItems: they depend on the zoom only, so strips match whole images
+	DecimateGrid grid;
+	bool decimate = !points && !asDots && !mesh && grid.make(getBoundaries(), target.getScale(), decimation);
+	DecimateKernel kernel = decimate ? decimateKernel() : NULL;
+	long long dropped = 0;
+	for (size_t i = 0; i < n; i++){
+		int p = parts[i];
+		if (points && symbols)
+			symbols->rasterize(target, geom.partStart[p], geom.getPartSize(p));
+		else if (asDots)
+			target.drawPoint(*geom.getPart(p), color, points ? 5 : (isStroked() ? width : 1));
+		else if (points)
+			target.drawPoints(geom.getPart(p), geom.getPartSize(p), color, 5);
+		else if (mesh)
+			target.fillTriangles(mesh->vertices.data(), &mesh->indices[mesh->partIndices[p]],
+				mesh->partIndices[p + 1] - mesh->partIndices[p], color);
+		else if (decimate && isDenserThanGrid(geom, p, grid)){
+			int size = geom.getPartSize(p);
+			if (kept.size() < (size_t)size)
+				kept.resize(size);
+			int nKept = (int)kernel(geom.getPart(p), size, geom.partStart[p], grid, kept.data());
+			keptPoints.resize(nKept);
+			for (int k = 0; k < nKept; k++)
+				keptPoints[k] = geom.points[kept[k]];
+			dropped += size - nKept;
+			target.drawPolyline(keptPoints.data(), nKept, closed, color, width);
 		}
-		glEnd();
+		else
+			target.drawPolyline(geom.getPart(p), geom.getPartSize(p), closed, color, width);
 	}
+	Metrics::add(COUNTER_VERTICES_DECIMATED, dropped);
 }
 
 vec4 ShapeFile::getBoundaries(){
-	return vec4(boundBoxMin.x, boundBoxMin.y, boundBoxMax.x, boundBoxMax.y);
+	return vec4(geometry->boundBoxMin.x, geometry->boundBoxMin.y, geometry->boundBoxMax.x, geometry->boundBoxMax.y);
 }
 
 /*
 	Print the DBF header in format TYPE: ATTRIBUTE
 	*/
-void ShapeFile::printDBFHeader(int nFirstItems){
+void ShapeFile::printDBFHeader(DBFHandle hDBF, int nFirstItems){
 	char fieldName[12];
 	int pnWidth, pnDecimals; // width in chars, number of decimal places of precision
 	//// Field names and types
@@ -9,38 +9,110 @@ Authors
 Using ShapeLib version 1.3
 */
 
+#ifndef SHAPEFILE_H_DEF
+#define SHAPEFILE_H_DEF
+
 #include "shapefil.h"
 #include "Vectors.h"
+#include "LayerGeometry.h"
+#include "LayerAttributes.h"
+#include "LayerStyle.h"
+#include "ViewCulling.h"
+#include "SoftRaster.h"
+#include "DrawList.h"
+#include "Stroker.h"
 #include <vector>
 #include <string>
+#include <memory>
 
 using namespace std;
 
-struct Entity{
-	vector<vec3> points;
-};
+class SymbolAtlas;
+class PointSymbols;
 
 class ShapeFile {
 public:
-	ShapeFile(const char* filename);
+	static shared_ptr<ShapeFile> open(const char* filename);
+	ShapeFile(const shared_ptr<const LayerGeometry>& geometry,
+		const shared_ptr<const LayerAttributes>& attributes = shared_ptr<const LayerAttributes>());
 	~ShapeFile();
 
-	void printDBFHeader(int nFirstItems);
-	void render();
+	static void printDBFHeader(DBFHandle hDBF, int nFirstItems);
+	/*
+		Adds what meets view, (minX, minY, maxX, maxY) in map units, to list:
+		the fill as one item, then an item per part. layerOrder is the
+		layer's place in the drawing order.
+	*/
+	void addDrawItems(DrawList& list, int layerOrder, const vec4& view, float worldPerPixel);
+	// The same drawing in software; view is the part of the map the renderer's clip covers.
+	void rasterize(SoftRenderer& target, const vec4& view, float worldPerPixel);
+	// Pieces of it, for drawing a layer over several frames.
+	size_t getFillTriangleCount() const { return style.hasFill() ? fillTriangles.size() / 3 : 0; }
+	void rasterizeFill(SoftRenderer& target, size_t first, size_t count);
+	void rasterizeParts(SoftRenderer& target, const int* parts, size_t n, bool asDots);
 	static const char* typeStr(int type);
 	vec4 getBoundaries();
+	/*
+		Hairlines drop the vertices that stay in the screen cell of thresholdPx
+		pixels the one before them is in (Decimate.h); 0 draws every vertex.
+		Set before drawing starts: cached layer images do not notice a change.
+	*/
+	static void setDecimation(float thresholdPx) { decimation = thresholdPx; }
+	static float getDecimation() { return decimation; }
 
-	static int shpCount;
+	const shared_ptr<const LayerGeometry>& getGeometry() const { return geometry; }
+	const shared_ptr<const LayerAttributes>& getAttributes() const { return attributes; } // may be NULL
+	const string& getFilename() const { return geometry->filename; }
+	const LayerStyle& getStyle() const { return style; }
+	// Polygon layers with a fill are tessellated here, once.
+	void setStyle(const LayerStyle& style);
+	/*
+		Point layers with a type column (LayerAttributes::getTypeColumn) draw
+		the atlas symbol of each point's type instead of a dot. NULL goes
+		back to dots.
+	*/
+	void setSymbols(const shared_ptr<const SymbolAtlas>& atlas);
+	bool hasSymbols() const { return symbols.get() != NULL; }
+	// How far (pixels) a point's mark or a line's stroke reaches from its geometry.
+	float getMarkRadius() const;
+	unsigned int getStyleRevision() const { return styleRevision; }
+	bool isVisible() const { return visibleFlag; }
+	void setVisible(bool on) { visibleFlag = on; }
+	int getID() const { return shpID; }
+	void setID(int id) { shpID = id; }
+
+	// Both NULL when the files cannot be read.
+	static shared_ptr<const LayerGeometry> load(const char* filename);
+	// Layers loaded from now on are laid out along a Hilbert curve (SpatialOrder.h) instead of in record order.
+	static void setSpatialOrder(bool on) { spatialOrder = on; }
+	static shared_ptr<const LayerAttributes> loadAttributes(const char* filename);
 private:
-	vec2 boundBoxMin, boundBoxMax;
-	int nEntities, shpType;
-	string filename;
-	SHPHandle hSHP;
-	DBFHandle hDBF;
-	vector<Entity> entities;
+	shared_ptr<const LayerGeometry> geometry;
+	shared_ptr<const LayerAttributes> attributes;
+	LayerStyle style;
+	vector<vec3> fillTriangles;
+	shared_ptr<PointSymbols> symbols;
+	StrokeCache strokes;  // wide lines, by zoom
+	VisibleParts visible; // per frame, kept to reuse its memory
+	vector<unsigned int> kept;  // a part's vertices after decimation
+	vector<vec3> keptPoints;    // the same, for the software renderer
+	vector<unsigned char> codes; // outcodes of a part against the view
+	static float decimation;
+	static bool spatialOrder;
+	// How the stroke draws a layer's parts; multipatch and M types are not drawn.
+	enum PartKind { PARTS_NONE, PARTS_POINTS, PARTS_LINES, PARTS_RINGS };
+	static PartKind partKind(int shpType);
+	bool isStroked() const;
+	unsigned int styleRevision;
+	bool visibleFlag;
+	int shpID;
+	const char* traceName;
 
-	void init();
-	void beginPrimitive(int shpType);
+	static LayerStyle defaultStyle(int shpType);
 
-	int shpID;
-};
\ No newline at end of file
+	// layers are handed around as shared_ptr<ShapeFile>, never copied
+	ShapeFile(const ShapeFile&);
+	ShapeFile& operator=(const ShapeFile&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,254 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "ShapeReader.h"
+#include "Metrics.h"
+#include "DecodeKernels.h"
+#include "shapefil.h"
+
+using namespace std;
+
+static bool openShx(const string& basename, MappedFile& map, PosFile& file){
+	string lower = basename + ".shx", upper = basename + ".SHX";
+	if (map.open(lower.c_str()) || map.open(upper.c_str()))
+		return true;
+	return file.open(lower.c_str()) || file.open(upper.c_str());
+}
+
+// Size of <basename>.shp, 0 if it cannot be opened.
+static FileOffset shpFileSize(const string& basename){
+	PosFile shp;
+	if (!shp.open((basename + ".shp").c_str()) && !shp.open((basename + ".SHP").c_str()))
+		return 0;
+	return shp.size();
+}
+
+/*
+	The .shx stores offsets as 32 bit counts of 16 bit words, so they wrap
+	every 8 GB. Only a .shp past 8 GB can have wrapped; there, an offset that
+	goes backwards has passed another 8 GB boundary. Offsets also go
+	backwards in smaller files, where SHPWriteObject appended a rewritten
+	record at the end, so an unwrapped offset that lands past the end of the
+	.shp falls back to the raw one.
+*/
+static void unwrapOffsets(vector<FileOffset>& offsets, const vector<unsigned int>& sizes, FileOffset shpSize){
+	const FileOffset wrap = (FileOffset)1 << 33;
+	if (shpSize <= wrap)
+		return;
+	FileOffset base = 0, prev = 0;
+	for (size_t i = 0; i < offsets.size(); i++){
+		FileOffset raw = offsets[i];
+		FileOffset next = raw < prev ? base + wrap : base;
+		prev = raw;
+		if (raw + next + 8 + sizes[i] <= shpSize){
+			base = next;
+			offsets[i] = raw + base;
+		}
+		else if (raw + base + 8 + sizes[i] <= shpSize)
+			offsets[i] = raw + base;
+	}
+}
+
+/*
+	Open the .shx (or .SHX) and parse the header and record table.
+	The table is byte swapped straight from the mapped file when possible,
+	otherwise from one positional read.
+*/
+shared_ptr<const ShapeIndex> ShapeIndex::load(const string& basename){
+	MappedFile map;
+	PosFile file;
+	if (!openShx(basename, map, file))
+		return shared_ptr<const ShapeIndex>();
+	FileOffset shpSize = shpFileSize(basename);
+	ScopedTimer timer(PHASE_SHX_PARSE); // the opens above count under PHASE_FILE_OPEN
+	FileOffset fileSize = map.isOpen() ? map.size() : file.size();
+
+	unsigned char headerCopy[100];
+	const unsigned char* header = headerCopy;
+	if (map.isOpen() && fileSize >= 100)
+		header = map.data();
+	else if (!file.isOpen() || file.readAt(0, headerCopy, 100) != 100)
+		return shared_ptr<const ShapeIndex>();
+	if (header[0] != 0 || header[1] != 0 || header[2] != 0x27
+		|| (header[3] != 0x0a && header[3] != 0x0d))
+		return shared_ptr<const ShapeIndex>();
+
+	shared_ptr<ShapeIndex> idx(new ShapeIndex());
+	idx->shpType = readLEInt(header + 32);
+	idx->boundsMin[0] = readLEDouble(header + 36);
+	idx->boundsMin[1] = readLEDouble(header + 44);
+	idx->boundsMax[0] = readLEDouble(header + 52);
+	idx->boundsMax[1] = readLEDouble(header + 60);
+	idx->boundsMin[2] = readLEDouble(header + 68);
+	idx->boundsMax[2] = readLEDouble(header + 76);
+	idx->boundsMin[3] = readLEDouble(header + 84);
+	idx->boundsMax[3] = readLEDouble(header + 92);
+
+	FileOffset shxLength = (FileOffset)readBEUInt(header + 24) * 2;
+	if (shxLength < 100 || shxLength > fileSize)
+		shxLength = fileSize;
+	FileOffset nRecords64 = (shxLength - 100) / 8;
+	if (nRecords64 > 0x7fffffff)
+		return shared_ptr<const ShapeIndex>(); // record ids are int
+	size_t nRecords = (size_t)nRecords64;
+
+	idx->recOffset.resize(nRecords);
+	idx->recSize.resize(nRecords);
+	if (nRecords == 0)
+		return idx;
+
+	const unsigned char* table;
+	vector<unsigned char> tableCopy;
+	if (map.isOpen())
+		table = map.data() + 100;
+	else{
+		tableCopy.resize(nRecords * 8);
+		if (file.readAt(100, &tableCopy[0], tableCopy.size()) != tableCopy.size())
+			return shared_ptr<const ShapeIndex>();
+		table = &tableCopy[0];
+	}
+	decodeKernels().shxEntries(table, nRecords, &idx->recOffset[0], &idx->recSize[0]);
+	unwrapOffsets(idx->recOffset, idx->recSize, shpSize);
+	return idx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FeatureCache
+////////////////////////////////////////////////////////////////////////////////
+
+FeatureCache::FeatureCache(size_t capacity, int nShards){
+	if (nShards < 1)
+		nShards = 1;
+	for (int i = 0; i < nShards; i++)
+		shards.push_back(unique_ptr<Shard>(new Shard()));
+	shardCapacity = (capacity + nShards - 1) / nShards;
+	if (shardCapacity == 0)
+		shardCapacity = 1;
+}
+
+shared_ptr<const Feature> FeatureCache::get(int id){
+	Shard& s = shardOf(id);
+	lock_guard<mutex> guard(s.lock);
+	unordered_map<int, LruList::iterator>::iterator it = s.map.find(id);
+	if (it == s.map.end()){
+		Metrics::add(COUNTER_CACHE_MISSES);
+		return shared_ptr<const Feature>();
+	}
+	Metrics::add(COUNTER_CACHE_HITS);
+	s.lru.splice(s.lru.begin(), s.lru, it->second);
+	return it->second->second;
+}
+
+void FeatureCache::put(int id, const shared_ptr<const Feature>& f){
+	Shard& s = shardOf(id);
+	lock_guard<mutex> guard(s.lock);
+	unordered_map<int, LruList::iterator>::iterator it = s.map.find(id);
+	if (it != s.map.end()){
+		it->second->second = f;
+		s.lru.splice(s.lru.begin(), s.lru, it->second);
+		return;
+	}
+	s.lru.push_front(make_pair(id, f));
+	s.map[id] = s.lru.begin();
+	if (s.lru.size() > shardCapacity){
+		s.map.erase(s.lru.back().first);
+		s.lru.pop_back();
+	}
+}
+
+void FeatureCache::clear(){
+	for (size_t i = 0; i < shards.size(); i++){
+		lock_guard<mutex> guard(shards[i]->lock);
+		shards[i]->lru.clear();
+		shards[i]->map.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ShapeReader
+////////////////////////////////////////////////////////////////////////////////
+
+ShapeReader::ShapeReader(){
+}
+
+bool ShapeReader::open(const string& basename){
+	shared_ptr<const ShapeIndex> idx = ShapeIndex::load(basename);
+	if (!idx)
+		return false;
+	return open(basename, idx);
+}
+
+/*
+	Open the .shp reusing an index that was already parsed, e.g. by another reader
+	of the same layer.
+*/
+bool ShapeReader::open(const string& basename, const shared_ptr<const ShapeIndex>& idx){
+	shared_ptr<PosFile> f(new PosFile());
+	if (!f->open((basename + ".shp").c_str()) && !f->open((basename + ".SHP").c_str()))
+		return false;
+	index = idx;
+	shp = f;
+	return true;
+}
+
+void ShapeReader::enableCache(size_t capacity, int nShards){
+	cache.reset(new FeatureCache(capacity, nShards));
+}
+
+bool ShapeReader::readRecord(int id, vector<unsigned char>& buf) const{
+	if (!index || id < 0 || id >= index->getRecordCount())
+		return false;
+	FileOffset offset = index->recOffset[id] + 8;
+	size_t size = index->recSize[id];
+	if (offset + size > shp->size())
+		return false;
+	buf.resize(size);
+	if (size == 0)
+		return true;
+	return shp->readAt(offset, &buf[0], size) == size;
+}
+
+bool ShapeReader::readFeature(int id, Feature& out, vector<unsigned char>& scratch) const{
+	if (!readRecord(id, scratch))
+		return false;
+	out.id = id;
+	if (scratch.empty()){
+		out.shpType = SHPT_NULL;
+		return true;
+	}
+	return decodeShapeRecord(&scratch[0], scratch.size(), out);
+}
+
+bool ShapeReader::readShape(int id, Arena& arena, ShapeView& out, vector<unsigned char>& scratch) const{
+	if (!readRecord(id, scratch))
+		return false;
+	if (scratch.empty()){
+		out.shpType = SHPT_NULL;
+		out.nParts = out.nVertices = 0;
+		return true;
+	}
+	return decodeShapeRecord(&scratch[0], scratch.size(), arena, out);
+}
+
+shared_ptr<const Feature> ShapeReader::fetch(int id) const{
+	if (cache){
+		shared_ptr<const Feature> hit = cache->get(id);
+		if (hit)
+			return hit;
+	}
+	vector<unsigned char> scratch;
+	shared_ptr<Feature> f(new Feature());
+	if (!readFeature(id, *f, scratch))
+		return shared_ptr<const Feature>();
+	if (cache)
+		cache->put(id, f);
+	return f;
+}
@@ -0,0 +1,100 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef SHAPEREADER_H_DEF
+#define SHAPEREADER_H_DEF
+
+#include "FileIO.h"
+#include "ShapeDecode.h"
+#include <vector>
+#include <string>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+using namespace std;
+
+/*
+	Parsed .shx: header info plus the offset/size of every record in the .shp.
+	Built once and never modified afterwards, so it can be shared by any number
+	of readers and threads (the same data SHPOpenLL keeps in panRecOffset/panRecSize,
+	but with 64 bit offsets so .shp files past 4 GB stay addressable).
+*/
+struct ShapeIndex {
+	int shpType;
+	double boundsMin[4], boundsMax[4]; // XYZM
+	vector<FileOffset> recOffset;   // bytes, record header included
+	vector<unsigned int> recSize;   // bytes, record content only
+
+	int getRecordCount() const { return (int)recOffset.size(); }
+
+	static shared_ptr<const ShapeIndex> load(const string& basename);
+};
+
+/*
+	LRU of decoded features split in independently locked shards, so lookups
+	of different ids from different threads rarely contend.
+*/
+class FeatureCache {
+public:
+	FeatureCache(size_t capacity, int nShards = 16);
+
+	shared_ptr<const Feature> get(int id);
+	void put(int id, const shared_ptr<const Feature>& f);
+	void clear();
+
+private:
+	typedef list<pair<int, shared_ptr<const Feature> > > LruList;
+	struct Shard {
+		mutex lock;
+		LruList lru; // most recently used at the front
+		unordered_map<int, LruList::iterator> map;
+	};
+	vector<unique_ptr<Shard> > shards;
+	size_t shardCapacity;
+
+	Shard& shardOf(int id) { return *shards[(unsigned int)id % shards.size()]; }
+};
+
+/*
+	Thread-safe random access to the records of a shapefile.
+	All state touched by a fetch is either immutable (index, file handle)
+	or supplied by the caller, so no locking is needed on the read path.
+*/
+class ShapeReader {
+public:
+	ShapeReader();
+
+	bool open(const string& basename);
+	bool open(const string& basename, const shared_ptr<const ShapeIndex>& index);
+	void enableCache(size_t capacity, int nShards = 16);
+
+	const shared_ptr<const ShapeIndex>& getIndex() const { return index; }
+	int getRecordCount() const { return index ? index->getRecordCount() : 0; }
+	const PosFile& getFile() const { return *shp; }
+
+	// Raw record content into a caller buffer. Returns false on error.
+	bool readRecord(int id, vector<unsigned char>& buf) const;
+	// Read and decode, using the caller buffer as scratch space.
+	bool readFeature(int id, Feature& out, vector<unsigned char>& scratch) const;
+	// Same, with the decoded arrays placed in a caller arena.
+	bool readShape(int id, Arena& arena, ShapeView& out, vector<unsigned char>& scratch) const;
+	// Cached lookup; decodes on a miss. Returns NULL on error.
+	shared_ptr<const Feature> fetch(int id) const;
+
+private:
+	shared_ptr<const ShapeIndex> index;
+	shared_ptr<PosFile> shp;
+	shared_ptr<FeatureCache> cache;
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "ShapeScanner.h"
+#include "Trace.h"
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+static const size_t blockAlign = 4096;
+
+ShapeScanner::ShapeScanner(const ShapeReader& reader, size_t blockSize, int readAhead)
+	: reader(reader), shp(reader.getFile()){
+	if (blockSize > shp.size())
+		blockSize = (size_t)shp.size(); // small layers: one block, no need for the full buffers
+	if (blockSize < 64 * 1024)
+		blockSize = 64 * 1024;
+	this->blockSize = (blockSize + blockAlign - 1) / blockAlign * blockAlign;
+	this->readAhead = readAhead < 0 ? 0 : readAhead;
+	blocks.resize(this->readAhead + 1);
+	for (size_t i = 0; i < blocks.size(); i++){
+		blocks[i].start = 0;
+		blocks[i].len = 0;
+		blocks[i].headroom = this->blockSize / 2;
+		blocks[i].pending = false;
+		if (i > 0)
+			spareBlocks.push_back((int)i);
+	}
+	current = 0;
+	aheadEnd = 0;
+	blockReads = directReads = 0;
+	aio = this->readAhead > 0 ? new AsyncReader(this->readAhead, min(this->readAhead, 4)) : NULL;
+}
+
+ShapeScanner::~ShapeScanner(){
+	if (aio){
+		dropReadAhead(); // the reads write into blocks
+		delete aio;
+	}
+}
+
+void ShapeScanner::prepare(Block& b, FileOffset start){
+	if (b.data.empty())
+		b.data.resize(blockSize / 2 + blockSize);
+	b.headroom = blockSize / 2;
+	b.start = start;
+	b.len = 0;
+}
+
+// Read the aligned block holding offset.
+void ShapeScanner::fill(Block& b, FileOffset offset){
+	FileOffset start = offset - offset % blockAlign;
+	FileOffset remaining = shp.size() - start;
+	prepare(b, start);
+	b.len = shp.readAt(start, &b.data[b.headroom], remaining < blockSize ? (size_t)remaining : blockSize);
+}
+
+// Until block i has arrived; completions of the blocks behind it are kept.
+void ShapeScanner::waitBlock(int i){
+	if (!blocks[i].pending)
+		return;
+	TraceScope trace("wait read-ahead", "io");
+	IORequest done;
+	while (blocks[i].pending && aio->wait(done)){
+		Block& b = blocks[(int)(size_t)done.user];
+		b.len = done.result;
+		b.pending = false;
+	}
+	if (blocks[i].pending){ // the reader gave up; treat the block as unread
+		blocks[i].len = 0;
+		blocks[i].pending = false;
+	}
+}
+
+// Forgets the blocks read ahead, once their reads are done.
+void ShapeScanner::dropReadAhead(){
+	for (size_t k = 0; k < ahead.size(); k++){
+		waitBlock(ahead[k]);
+		spareBlocks.push_back(ahead[k]);
+	}
+	ahead.clear();
+}
+
+// Queue reads of the blocks after the current one until readAhead are in flight or read.
+void ShapeScanner::startReadAhead(){
+	if (aio == NULL)
+		return;
+	if (ahead.empty())
+		aheadEnd = blocks[current].start + blocks[current].len;
+	while ((int)ahead.size() < readAhead && aheadEnd < shp.size() && !spareBlocks.empty()){
+		int i = spareBlocks.back();
+		spareBlocks.pop_back();
+		Block& b = blocks[i];
+		prepare(b, aheadEnd);
+		FileOffset remaining = shp.size() - aheadEnd;
+		size_t want = remaining < blockSize ? (size_t)remaining : blockSize;
+		IORequest r = { &shp, aheadEnd, &b.data[b.headroom], want, 0, (void*)(size_t)i };
+		b.pending = true;
+		aio->submit(r);
+		ahead.push_back(i);
+		aheadEnd += want;
+		blockReads++;
+	}
+}
+
+bool ShapeScanner::read(int id, const unsigned char*& rec, size_t& len){
+	const ShapeIndex* index = reader.getIndex().get();
+	rec = NULL;
+	len = 0;
+	if (index == NULL || id < 0 || id >= index->getRecordCount())
+		return false;
+	FileOffset offset = index->recOffset[id] + 8;
+	size_t size = index->recSize[id];
+	if (offset + size > shp.size())
+		return false;
+	if (size == 0)
+		return true;
+
+	if (!covers(blocks[current], offset, size)){
+		if (size > blockSize / 2){
+			scratch.resize(size);
+			directReads++;
+			if (shp.readAt(offset, &scratch[0], size) != size)
+				return false;
+			rec = &scratch[0];
+			len = size;
+			return true;
+		}
+
+		// moving forward: switch to the first block read ahead, carrying over
+		// the start of a record that straddles the two
+		Block& cur = blocks[current];
+		FileOffset end = cur.start + cur.len;
+		if (!ahead.empty() && cur.len > 0 && offset >= cur.start){
+			int i = ahead.front();
+			waitBlock(i);
+			Block& next = blocks[i];
+			if (next.len > 0 && next.start == end){
+				if (offset < end){
+					size_t tail = (size_t)(end - offset);
+					memcpy(&next.data[next.headroom - tail], cur.at(offset), tail);
+					next.headroom -= tail;
+					next.start -= tail;
+					next.len += tail;
+				}
+				ahead.pop_front();
+				spareBlocks.push_back(current);
+				current = i;
+			}
+		}
+		if (!covers(blocks[current], offset, size)){
+			dropReadAhead();
+			blockReads++;
+			fill(blocks[current], offset);
+			if (!covers(blocks[current], offset, size))
+				return false;
+		}
+		startReadAhead();
+	}
+	rec = blocks[current].at(offset);
+	len = size;
+	return true;
+}
@@ -0,0 +1,85 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef SHAPESCANNER_H_DEF
+#define SHAPESCANNER_H_DEF
+
+#include "ShapeReader.h"
+#include "AsyncIO.h"
+#include <deque>
+
+using namespace std;
+
+/*
+	Sequential-scan mode over a ShapeReader. Records are served from large
+	aligned blocks of the .shp, so a full-layer scan costs one read per block
+	instead of one per record. With read-ahead on, the next readAhead blocks
+	are kept in flight through an AsyncReader (io_uring, or its thread pool)
+	while the caller decodes the current one.
+
+	Ascending ids are the fast path. Going backwards or skipping past the
+	blocks read ahead reloads the block at the new position; records larger
+	than half a block are read on their own. One scanner serves one thread.
+*/
+class ShapeScanner {
+public:
+	// readAhead 0 reads each block when it is needed.
+	ShapeScanner(const ShapeReader& reader, size_t blockSize = 4 << 20, int readAhead = 4);
+	~ShapeScanner();
+
+	/*
+		Content of record id. rec stays valid until the next call.
+		Returns false on error; empty records give len 0.
+	*/
+	bool read(int id, const unsigned char*& rec, size_t& len);
+
+	long long getBlockReads() const { return blockReads; }
+	long long getDirectReads() const { return directReads; }
+
+private:
+	// file bytes [start, start + len) live at data[headroom]; the headroom
+	// takes the tail of the previous block when a record straddles both
+	struct Block {
+		vector<unsigned char> data; // allocated on first use
+		FileOffset start;
+		size_t len;
+		size_t headroom;
+		bool pending; // read in flight
+		const unsigned char* at(FileOffset offset) const { return &data[0] + headroom + (size_t)(offset - start); }
+	};
+
+	const ShapeReader& reader;
+	const PosFile& shp;
+	size_t blockSize;
+	int readAhead;
+	vector<Block> blocks;   // readAhead + 1
+	int current;
+	deque<int> ahead;       // blocks read ahead of current, in file order
+	vector<int> spareBlocks;
+	FileOffset aheadEnd;    // where the next read-ahead starts
+	AsyncReader* aio;       // NULL without read-ahead
+	vector<unsigned char> scratch;
+	long long blockReads, directReads;
+
+	bool covers(const Block& b, FileOffset offset, size_t len) const {
+		return b.len > 0 && offset >= b.start && offset + len <= b.start + b.len;
+	}
+	void prepare(Block& b, FileOffset start);
+	void fill(Block& b, FileOffset offset);
+	void startReadAhead();
+	void waitBlock(int i);
+	void dropReadAhead();
+
+	ShapeScanner(const ShapeScanner&);
+	ShapeScanner& operator=(const ShapeScanner&);
+};
+
+#endif
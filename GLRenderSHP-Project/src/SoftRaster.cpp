@@ -0,0 +1,285 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "SoftRaster.h"
+#include "Clip.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+void RasterImage::resize(int w, int h){
+	width = w > 0 ? w : 0;
+	height = h > 0 ? h : 0;
+	pixels.assign((size_t)width * height, 0);
+}
+
+static unsigned int toByte(float c){
+	c = c < 0 ? 0 : (c > 1 ? 1 : c);
+	return (unsigned int)(c * 255.0f + 0.5f);
+}
+
+unsigned int packColor(const vec4& rgba){
+	unsigned int a = toByte(rgba.w);
+	unsigned int r = toByte(rgba.x * rgba.w), g = toByte(rgba.y * rgba.w), b = toByte(rgba.z * rgba.w);
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+// src over dst, premultiplied; two channels per multiply.
+static inline unsigned int blendPixel(unsigned int dst, unsigned int src){
+	unsigned int sa = src >> 24;
+	if (sa == 255)
+		return src;
+	if (sa == 0)
+		return src + dst;
+	unsigned int ia = 255 - sa;
+	unsigned int rb = (dst & 0x00FF00FF) * ia + 0x00800080;
+	unsigned int ag = ((dst >> 8) & 0x00FF00FF) * ia + 0x00800080;
+	rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+	ag = ((ag + ((ag >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+	return src + (rb | (ag << 8));
+}
+
+void fillRect(RasterImage& img, const PixelRect& r, unsigned int color){
+	for (int y = r.y0; y < r.y1; y++){
+		unsigned int* p = img.row(y);
+		for (int x = r.x0; x < r.x1; x++)
+			p[x] = color;
+	}
+}
+
+void shiftImage(RasterImage& img, int dx, int dy){
+	int w = img.width, h = img.height;
+	if (dx >= w || -dx >= w || dy >= h || -dy >= h)
+		return;
+	int n = w - (dx > 0 ? dx : -dx);
+	// walk rows away from where they move to, so nothing is overwritten before it is read
+	for (int k = 0; k < h - (dy > 0 ? dy : -dy); k++){
+		int to = dy > 0 ? h - 1 - k : k;
+		int from = to - dy;
+		unsigned int* dst = img.row(to) + (dx > 0 ? dx : 0);
+		const unsigned int* src = img.row(from) + (dx > 0 ? 0 : -dx);
+		memmove(dst, src, n * sizeof(unsigned int));
+	}
+}
+
+void resampleImage(const RasterImage& src, double srcLeft, double srcBottom, double srcScale,
+	RasterImage& dst, double left, double bottom, double scale){
+	// source column of each destination column, -1 outside; the same for rows
+	vector<int> cols(dst.width), rows(dst.height);
+	for (int i = 0; i < dst.width; i++){
+		double x = floor((left + (i + 0.5) * scale - srcLeft) / srcScale);
+		cols[i] = (x >= 0 && x < src.width) ? (int)x : -1;
+	}
+	for (int j = 0; j < dst.height; j++){
+		double y = floor((bottom + (j + 0.5) * scale - srcBottom) / srcScale);
+		rows[j] = (y >= 0 && y < src.height) ? (int)y : -1;
+	}
+	for (int j = 0; j < dst.height; j++){
+		unsigned int* d = dst.row(j);
+		if (rows[j] < 0){
+			memset(d, 0, dst.width * sizeof(unsigned int));
+			continue;
+		}
+		const unsigned int* s = src.row(rows[j]);
+		for (int i = 0; i < dst.width; i++)
+			d[i] = cols[i] < 0 ? 0 : s[cols[i]];
+	}
+}
+
+void blendOver(RasterImage& dst, const RasterImage& src, int y0, int y1){
+	size_t n = (size_t)(y1 - y0) * dst.width;
+	unsigned int* d = dst.row(y0);
+	const unsigned int* s = src.row(y0);
+	for (size_t i = 0; i < n; i++){
+		if (s[i] != 0)
+			d[i] = blendPixel(d[i], s[i]);
+	}
+}
+
+SoftRenderer::SoftRenderer(RasterImage& target, const PixelRect& clipRect, double left, double bottom, double scale)
+	: img(target), clip(clipRect), left(left), bottom(bottom), invScale(1.0 / scale){
+	if (clip.x0 < 0) clip.x0 = 0;
+	if (clip.y0 < 0) clip.y0 = 0;
+	if (clip.x1 > img.width) clip.x1 = img.width;
+	if (clip.y1 > img.height) clip.y1 = img.height;
+}
+
+inline void SoftRenderer::plot(int x, int y, unsigned int color){
+	if (x < clip.x0 || x >= clip.x1 || y < clip.y0 || y >= clip.y1)
+		return;
+	unsigned int& p = img.row(y)[x];
+	p = (color >> 24) == 255 ? color : blendPixel(p, color);
+}
+
+void SoftRenderer::stamp(int x, int y, unsigned int color, int width){
+	if (width <= 1){
+		plot(x, y, color);
+		return;
+	}
+	int lo = -(width - 1) / 2, hi = width / 2;
+	for (int j = lo; j <= hi; j++)
+		for (int i = lo; i <= hi; i++)
+			plot(x + i, y + j, color);
+}
+
+/*
+	One pixel per column (or row, for steep segments) whose centre lies in
+	the segment's half-open span, taken on the line through the unclipped
+	end points. Only columns that can reach the clip rectangle are visited.
+*/
+void SoftRenderer::drawSegment(double x0, double y0, double x1, double y1, bool last, unsigned int color, int width){
+	stamp((int)floor(x0), (int)floor(y0), color, width);
+	if (last)
+		stamp((int)floor(x1), (int)floor(y1), color, width);
+	double dx = x1 - x0, dy = y1 - y0;
+	int reach = width / 2 + 1;
+	bool steep = fabs(dy) > fabs(dx);
+	if (steep){
+		swap(x0, y0);
+		swap(x1, y1);
+		swap(dx, dy);
+	}
+	if (dx == 0)
+		return;
+	double lo = x0 < x1 ? x0 : x1, hi = x0 < x1 ? x1 : x0;
+	double slope = dy / dx;
+	int clipLo = (steep ? clip.y0 : clip.x0) - reach, clipHi = (steep ? clip.y1 : clip.x1) + reach;
+	double first = ceil(lo - 0.5), end = ceil(hi - 0.5);
+	int i0 = first > clipLo ? (int)first : clipLo;
+	int i1 = end < clipHi ? (int)end : clipHi;
+	for (int i = i0; i < i1; i++){
+		int j = (int)floor(y0 + (i + 0.5 - x0) * slope);
+		if (steep)
+			stamp(j, i, color, width);
+		else
+			stamp(i, j, color, width);
+	}
+}
+
+// Float bounds no tighter than v, so a float compare against them errs outwards.
+static float floatBelow(double v){
+	float f = (float)v;
+	return f > v ? nextafterf(f, -HUGE_VALF) : f;
+}
+static float floatAbove(double v){
+	float f = (float)v;
+	return f < v ? nextafterf(f, HUGE_VALF) : f;
+}
+
+/*
+	The clip rectangle widened by margin pixels, in map units, as
+	(minX, minY, maxX, maxY).
+*/
+vec4 SoftRenderer::getMapClip(int margin) const{
+	double scale = 1 / invScale;
+	return vec4(floatBelow(left + (clip.x0 - margin) * scale), floatBelow(bottom + (clip.y0 - margin) * scale),
+		floatAbove(left + (clip.x1 + margin) * scale), floatAbove(bottom + (clip.y1 + margin) * scale));
+}
+
+/*
+	Segments whose ends both lie beyond one side of the clip rectangle,
+	widened by the pen, would draw nothing and are skipped on their
+	outcodes; what is drawn is untouched.
+*/
+void SoftRenderer::drawPolyline(const vec3* v, int n, bool closed, unsigned int color, int width){
+	if (n == 1){
+		stamp((int)floor(toX(v[0].x)), (int)floor(toY(v[0].y)), color, width);
+		return;
+	}
+	codes.resize(n);
+	outcodeKernel()(v, n, getMapClip(width / 2 + 2), codes.data());
+	for (int i = 0; i + 1 < n; i++)
+		if ((codes[i] & codes[i + 1]) == 0)
+			drawSegment(toX(v[i].x), toY(v[i].y), toX(v[i + 1].x), toY(v[i + 1].y), !closed && i + 2 == n, color, width);
+	if (closed && n > 2 && (codes[n - 1] & codes[0]) == 0)
+		drawSegment(toX(v[n - 1].x), toY(v[n - 1].y), toX(v[0].x), toY(v[0].y), false, color, width);
+}
+
+void SoftRenderer::drawPoints(const vec3* v, int n, unsigned int color, int size){
+	if (size < 1)
+		size = 1;
+	double r = size * 0.5;
+	for (int k = 0; k < n; k++){
+		double px = toX(v[k].x), py = toY(v[k].y);
+		int x0 = (int)floor(px - r + 0.5), y0 = (int)floor(py - r + 0.5);
+		if (x0 + size <= clip.x0 || x0 >= clip.x1 || y0 + size <= clip.y0 || y0 >= clip.y1)
+			continue;
+		for (int j = 0; j < size; j++)
+			for (int i = 0; i < size; i++){
+				double cx = i + 0.5 - r, cy = j + 0.5 - r;
+				if (cx * cx + cy * cy <= r * r)
+					plot(x0 + i, y0 + j, color);
+			}
+	}
+}
+
+void SoftRenderer::drawSprite(const vec3& v, const RasterImage& sheet, const PixelRect& cell){
+	int w = cell.x1 - cell.x0, h = cell.y1 - cell.y0;
+	int x0 = (int)floor(toX(v.x) - w * 0.5 + 0.5), y0 = (int)floor(toY(v.y) - h * 0.5 + 0.5);
+	int i0 = max(0, clip.x0 - x0), i1 = min(w, clip.x1 - x0);
+	int j0 = max(0, clip.y0 - y0), j1 = min(h, clip.y1 - y0);
+	for (int j = j0; j < j1; j++){
+		const unsigned int* s = sheet.row(cell.y0 + j) + cell.x0;
+		unsigned int* d = img.row(y0 + j) + x0;
+		for (int i = i0; i < i1; i++){
+			if (s[i] != 0)
+				d[i] = (s[i] >> 24) == 255 ? s[i] : blendPixel(d[i], s[i]);
+		}
+	}
+}
+
+void SoftRenderer::fillTriangles(const vec3* v, size_t nVertices, unsigned int color){
+	for (size_t t = 0; t + 2 < nVertices; t += 3)
+		fillTriangle(v[t], v[t + 1], v[t + 2], color);
+}
+
+void SoftRenderer::fillTriangles(const vec3* v, const unsigned int* indices, size_t nIndices, unsigned int color){
+	for (size_t t = 0; t + 2 < nIndices; t += 3)
+		fillTriangle(v[indices[t]], v[indices[t + 1]], v[indices[t + 2]], color);
+}
+
+/*
+	Scanline fill at pixel centres: row j is covered between the two edges
+	that span j + 0.5, columns whose centre is in [left edge, right edge).
+	Triangles sharing an edge therefore never both cover a pixel.
+*/
+void SoftRenderer::fillTriangle(const vec3& a, const vec3& b, const vec3& c, unsigned int color){
+	double x[3] = { toX(a.x), toX(b.x), toX(c.x) }, y[3] = { toY(a.y), toY(b.y), toY(c.y) };
+	double ymin = min(y[0], min(y[1], y[2])), ymax = max(y[0], max(y[1], y[2]));
+	double xmin = min(x[0], min(x[1], x[2])), xmax = max(x[0], max(x[1], x[2]));
+	if (xmax < clip.x0 || xmin > clip.x1 || ymax < clip.y0 || ymin > clip.y1)
+		return;
+	int j0 = (int)max((double)clip.y0, ceil(ymin - 0.5));
+	int j1 = (int)min((double)clip.y1, ceil(ymax - 0.5));
+	for (int j = j0; j < j1; j++){
+		double yc = j + 0.5;
+		double xs[2];
+		int nx = 0;
+		for (int e = 0; e < 3 && nx < 2; e++){
+			int a = e, b = (e + 1) % 3;
+			double ya = y[a], yb = y[b];
+			if (ya == yb)
+				continue;
+			if ((yc >= ya && yc < yb) || (yc >= yb && yc < ya))
+				xs[nx++] = x[a] + (yc - ya) * (x[b] - x[a]) / (yb - ya);
+		}
+		if (nx < 2)
+			continue;
+		double xl = min(xs[0], xs[1]), xr = max(xs[0], xs[1]);
+		int i0 = (int)max((double)clip.x0, ceil(xl - 0.5));
+		int i1 = (int)min((double)clip.x1, ceil(xr - 0.5));
+		unsigned int* p = img.row(j);
+		for (int i = i0; i < i1; i++)
+			p[i] = (color >> 24) == 255 ? color : blendPixel(p[i], color);
+	}
+}
@@ -0,0 +1,99 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef SOFTRASTER_H_DEF
+#define SOFTRASTER_H_DEF
+
+#include "Vectors.h"
+#include <vector>
+
+using namespace std;
+
+/*
+	RGBA8 image, premultiplied alpha, bytes R, G, B, A in memory (on the
+	little-endian targets we build for). Row 0 is the bottom row, so
+	glDrawPixels and glReadPixels take it as is.
+*/
+struct RasterImage {
+	int width, height;
+	vector<unsigned int> pixels;
+
+	RasterImage() : width(0), height(0) {}
+	void resize(int w, int h);
+	unsigned int* row(int y) { return &pixels[(size_t)y * width]; }
+	const unsigned int* row(int y) const { return &pixels[(size_t)y * width]; }
+};
+
+// Half-open pixel rectangle [x0, x1) x [y0, y1).
+struct PixelRect {
+	int x0, y0, x1, y1;
+
+	PixelRect() : x0(0), y0(0), x1(0), y1(0) {}
+	PixelRect(int x0, int y0, int x1, int y1) : x0(x0), y0(y0), x1(x1), y1(y1) {}
+	bool empty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+unsigned int packColor(const vec4& rgba); // premultiplies
+void fillRect(RasterImage& img, const PixelRect& r, unsigned int color);
+// Moves the content by (dx, dy) pixels; what comes in is left as it was.
+void shiftImage(RasterImage& img, int dx, int dy);
+/*
+	Nearest-neighbour copy of src, drawn for the view (srcLeft, srcBottom,
+	srcScale), into dst as seen from (left, bottom, scale). What src does not
+	cover comes out transparent.
+*/
+void resampleImage(const RasterImage& src, double srcLeft, double srcBottom, double srcScale,
+	RasterImage& dst, double left, double bottom, double scale);
+// Premultiplied source-over of src onto rows [y0, y1) of dst, both the same size.
+void blendOver(RasterImage& dst, const RasterImage& src, int y0, int y1);
+
+/*
+	Draws map geometry into an image through a 2D ortho transform: pixel
+	(i, j) covers map x in [left + i * scale, left + (i + 1) * scale), and
+	likewise for y from bottom. Everything is sampled at pixel centres from
+	the unclipped primitive, so a pixel comes out the same whether it is
+	drawn with the whole image as clip rectangle or with a strip of it;
+	the layer cache depends on that.
+*/
+class SoftRenderer {
+public:
+	SoftRenderer(RasterImage& target, const PixelRect& clip, double left, double bottom, double scale);
+
+	void fillTriangles(const vec3* v, size_t nVertices, unsigned int color);
+	// Triangles given by index triples into v. Overlapping triangles blend twice.
+	void fillTriangles(const vec3* v, const unsigned int* indices, size_t nIndices, unsigned int color);
+	// GL_LINE_STRIP, or GL_LINE_LOOP when closed; width in pixels.
+	void drawPolyline(const vec3* v, int n, bool closed, unsigned int color, int width);
+	// Round dots of the given diameter, as smooth GL points.
+	void drawPoints(const vec3* v, int n, unsigned int color, int size);
+	void drawPoint(const vec3& v, unsigned int color, int size) { drawPoints(&v, 1, color, size); }
+	// Cell of a premultiplied sprite sheet, centred on v as a point of the cell's size would be.
+	void drawSprite(const vec3& v, const RasterImage& sheet, const PixelRect& cell);
+
+	const PixelRect& getClip() const { return clip; }
+	float getScale() const { return (float)(1 / invScale); } // map units per pixel
+
+private:
+	RasterImage& img;
+	PixelRect clip;
+	double left, bottom, invScale;
+	vector<unsigned char> codes; // drawPolyline's outcodes
+
+	double toX(float x) const { return (x - left) * invScale; }
+	double toY(float y) const { return (y - bottom) * invScale; }
+	vec4 getMapClip(int margin) const;
+	void plot(int x, int y, unsigned int color);
+	void fillTriangle(const vec3& a, const vec3& b, const vec3& c, unsigned int color);
+	void stamp(int x, int y, unsigned int color, int width);
+	void drawSegment(double x0, double y0, double x1, double y1, bool last, unsigned int color, int width);
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "SpatialOrder.h"
+#include "Trace.h"
+#include <algorithm>
+#include <float.h>
+
+using namespace std;
+
+unsigned int hilbertIndex(unsigned int x, unsigned int y){
+	const unsigned int n = 1u << 16;
+	unsigned int d = 0;
+	for (unsigned int s = n / 2; s > 0; s /= 2){
+		unsigned int rx = (x & s) != 0, ry = (y & s) != 0;
+		d += s * s * ((3 * rx) ^ ry);
+		// turn the quadrant so the curve inside it runs the standard way
+		if (ry == 0){
+			if (rx == 1){
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			swap(x, y);
+		}
+	}
+	return d;
+}
+
+static vec4 unionBounds(const vec4& a, const vec4& b){
+	return vec4(min(a.x, b.x), min(a.y, b.y), max(a.z, b.z), max(a.w, b.w));
+}
+
+static vec4 pointBounds(const vec3* v, int n){
+	vec4 b(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int i = 0; i < n; i++)
+		b = unionBounds(b, vec4(v[i].x, v[i].y, v[i].x, v[i].y));
+	return b;
+}
+
+// The parts of one record: [firstPart, firstPart + nParts).
+struct RecordRun {
+	unsigned int key;
+	int firstPart, nParts;
+
+	bool operator<(const RecordRun& o) const { return key != o.key ? key < o.key : firstPart < o.firstPart; }
+};
+
+void reorderAlongHilbert(LayerGeometry& geom){
+	TraceScope trace("hilbert reorder", "load");
+	int nParts = geom.getPartCount();
+	if (nParts < 2)
+		return;
+	bool hasBounds = (int)geom.partBounds.size() == nParts;
+
+	// records as runs of parts, with their bounds
+	vector<RecordRun> runs;
+	vector<vec4> runBounds;
+	for (int p = 0; p < nParts; p++){
+		vec4 b = hasBounds ? geom.partBounds[p] : pointBounds(geom.getPart(p), geom.getPartSize(p));
+		if (p > 0 && geom.partShape[p] == geom.partShape[p - 1]){
+			runs.back().nParts++;
+			runBounds.back() = unionBounds(runBounds.back(), b);
+			continue;
+		}
+		RecordRun r = { 0, p, 1 };
+		runs.push_back(r);
+		runBounds.push_back(b);
+	}
+
+	// curve positions over the layer's bounds
+	double x0 = geom.boundBoxMin.x, y0 = geom.boundBoxMin.y;
+	double w = geom.boundBoxMax.x - x0, h = geom.boundBoxMax.y - y0;
+	double sx = w > 0 ? 65535.0 / w : 0, sy = h > 0 ? 65535.0 / h : 0;
+	for (size_t i = 0; i < runs.size(); i++){
+		const vec4& b = runBounds[i];
+		double cx = ((b.x + (double)b.z) / 2 - x0) * sx, cy = ((b.y + (double)b.w) / 2 - y0) * sy;
+		unsigned int qx = (unsigned int)max(0.0, min(65535.0, cx)), qy = (unsigned int)max(0.0, min(65535.0, cy));
+		runs[i].key = hilbertIndex(qx, qy);
+	}
+	sort(runs.begin(), runs.end());
+
+	// the arrays again in curve order
+	vector<vec3> points;
+	vector<unsigned int> partStart;
+	vector<int> partShape;
+	vector<vec4> partBounds;
+	points.reserve(geom.points.size());
+	partStart.reserve(nParts + 1);
+	partShape.reserve(nParts);
+	partBounds.reserve(geom.partBounds.size());
+	partStart.push_back(0);
+	for (size_t i = 0; i < runs.size(); i++){
+		const RecordRun& r = runs[i];
+		points.insert(points.end(), geom.points.begin() + geom.partStart[r.firstPart],
+			geom.points.begin() + geom.partStart[r.firstPart + r.nParts]);
+		for (int p = r.firstPart; p < r.firstPart + r.nParts; p++){
+			partStart.push_back(partStart.back() + geom.getPartSize(p));
+			partShape.push_back(geom.partShape[p]);
+			if (hasBounds)
+				partBounds.push_back(geom.partBounds[p]);
+		}
+	}
+	geom.points.swap(points);
+	geom.partStart.swap(partStart);
+	geom.partShape.swap(partShape);
+	geom.partBounds.swap(partBounds);
+	buildBlockBounds(geom);
+}
+
+void buildBlockBounds(LayerGeometry& geom){
+	geom.blockBounds.clear();
+	int nParts = geom.getPartCount();
+	if ((int)geom.partBounds.size() != nParts)
+		return;
+	const int size = LayerGeometry::partBlockSize;
+	geom.blockBounds.reserve((nParts + size - 1) / size);
+	for (int first = 0; first < nParts; first += size){
+		vec4 b = geom.partBounds[first];
+		for (int p = first + 1; p < min(nParts, first + size); p++)
+			b = unionBounds(b, geom.partBounds[p]);
+		geom.blockBounds.push_back(b);
+	}
+}
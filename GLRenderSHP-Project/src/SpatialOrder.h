@@ -0,0 +1,37 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef SPATIALORDER_H_DEF
+#define SPATIALORDER_H_DEF
+
+#include "LayerGeometry.h"
+
+/*
+	Distance of cell (x, y) along a Hilbert curve through a 65536 x 65536
+	grid. Cells close on the curve are close on the map, and most cells
+	close on the map are close on the curve.
+*/
+unsigned int hilbertIndex(unsigned int x, unsigned int y);
+
+/*
+	Lays the layer out along a Hilbert curve: records are sorted by the
+	curve position of their bounding box centre (ties keep record order),
+	and their parts and vertices are copied in that order, so features near
+	each other on the map are near each other in memory. A record's parts
+	stay consecutive and in their order; partShape still gives every part's
+	record, which is what attribute lookups go through.
+*/
+void reorderAlongHilbert(LayerGeometry& geom);
+
+// Fills blockBounds from partBounds; clears it when the parts have no bounds.
+void buildBlockBounds(LayerGeometry& geom);
+
+#endif
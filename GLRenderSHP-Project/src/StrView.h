@@ -0,0 +1,57 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef STRVIEW_H_DEF
+#define STRVIEW_H_DEF
+
+#include <string>
+#include <string.h>
+
+using namespace std;
+
+/*
+	Non-owning view of characters that live elsewhere, e.g. inside a mapped
+	.dbf (the project is C++11, so no std::string_view). Not NUL-terminated.
+*/
+struct StrView {
+	const char* data;
+	size_t len;
+
+	StrView() : data(""), len(0) {}
+	StrView(const char* data, size_t len) : data(data), len(len) {}
+	StrView(const string& s) : data(s.data()), len(s.size()) {}
+
+	size_t size() const { return len; }
+	bool empty() const { return len == 0; }
+	char operator[](size_t i) const { return data[i]; }
+	string str() const { return string(data, len); }
+
+	bool operator==(const StrView& o) const { return len == o.len && memcmp(data, o.data, len) == 0; }
+	bool operator!=(const StrView& o) const { return !(*this == o); }
+	bool operator<(const StrView& o) const {
+		int c = memcmp(data, o.data, len < o.len ? len : o.len);
+		return c < 0 || (c == 0 && len < o.len);
+	}
+};
+
+// FNV-1a, for unordered containers keyed by StrView
+struct StrViewHash {
+	size_t operator()(const StrView& s) const {
+		unsigned long long h = 14695981039346656037ull;
+		for (size_t i = 0; i < s.len; i++){
+			h ^= (unsigned char)s.data[i];
+			h *= 1099511628211ull;
+		}
+		return (size_t)h;
+	}
+};
+
+#endif
@@ -0,0 +1,239 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Stroker.h"
+#include "Parallel.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "shapefil.h"
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+static const double pi = 3.14159265358979323846;
+static const int maxEntries = 2;
+
+// Chord angle that keeps a circle of radius r within tol of its arc.
+static double arcStep(double r, double tol){
+	if (r <= tol)
+		return pi / 2;
+	return min(pi / 2, 2 * acos(1 - tol / r));
+}
+
+// Fan around c from angle a0 to a1 (either way round, as given) at radius r.
+static void addFan(const vec3& c, double r, double a0, double a1, double tol,
+	vector<vec3>& vertices, vector<unsigned int>& indices){
+	int n = (int)ceil(fabs(a1 - a0) / arcStep(r, tol));
+	if (n < 1)
+		n = 1;
+	unsigned int centre = (unsigned int)vertices.size();
+	vertices.push_back(c);
+	// rotate the radius by a fixed step rather than calling sin/cos per point
+	double step = (a1 - a0) / n, cs = cos(step), sn = sin(step);
+	double x = r * cos(a0), y = r * sin(a0);
+	for (int i = 0; i <= n; i++){
+		vertices.push_back(vec3((float)(c.x + x), (float)(c.y + y), c.z));
+		double nx = x * cs - y * sn;
+		y = x * sn + y * cs;
+		x = nx;
+		if (i > 0){
+			indices.push_back(centre);
+			indices.push_back(centre + i);
+			indices.push_back(centre + i + 1);
+		}
+	}
+}
+
+static void addTriangle(const vec3& a, const vec3& b, const vec3& c, vector<vec3>& vertices, vector<unsigned int>& indices){
+	unsigned int first = (unsigned int)vertices.size();
+	vertices.push_back(a);
+	vertices.push_back(b);
+	vertices.push_back(c);
+	indices.push_back(first);
+	indices.push_back(first + 1);
+	indices.push_back(first + 2);
+}
+
+/*
+	Join at p between the segment arriving with unit direction (ax, ay) and
+	the one leaving with (bx, by). Only the outer side of the bend needs
+	filling: the inner side is already covered by the two quads.
+*/
+static void addJoin(const vec3& p, double ax, double ay, double bx, double by, double hw, LineJoin join,
+	float miterLimit, float tol, vector<vec3>& vertices, vector<unsigned int>& indices){
+	double cross = ax * by - ay * bx, dot = ax * bx + ay * by;
+	if (fabs(cross) < 1e-9 && dot > 0)
+		return; // straight on
+	// outer side: right of the path on a left turn, left on a right turn
+	double side = cross > 0 ? -1 : 1;
+	double o0x = -ay * side, o0y = ax * side, o1x = -by * side, o1y = bx * side;
+	vec3 e0((float)(p.x + o0x * hw), (float)(p.y + o0y * hw), p.z);
+	vec3 e1((float)(p.x + o1x * hw), (float)(p.y + o1y * hw), p.z);
+	if (join == JOIN_ROUND){
+		double a0 = atan2(o0y, o0x), a1 = atan2(o1y, o1x);
+		// the short way round, which is the outer side
+		if (a1 - a0 > pi)
+			a1 -= 2 * pi;
+		else if (a0 - a1 > pi)
+			a1 += 2 * pi;
+		addFan(p, hw, a0, a1, tol, vertices, indices);
+		return;
+	}
+	if (join == JOIN_MITER){
+		double mx = o0x + o1x, my = o0y + o1y;
+		double ml = sqrt(mx * mx + my * my);
+		if (ml > 1e-9){
+			mx /= ml;
+			my /= ml;
+			double cosHalf = mx * o0x + my * o0y; // miter length is hw / cosHalf
+			if (cosHalf > 0 && 1 / cosHalf <= miterLimit){
+				double len = hw / cosHalf;
+				vec3 m((float)(p.x + mx * len), (float)(p.y + my * len), p.z);
+				addTriangle(p, e0, m, vertices, indices);
+				addTriangle(p, m, e1, vertices, indices);
+				return;
+			}
+		}
+	}
+	addTriangle(p, e0, e1, vertices, indices); // bevel
+}
+
+// Cap at p, the line leaving p in unit direction (dx, dy).
+static void addCap(const vec3& p, double dx, double dy, double hw, LineCap cap, float tol,
+	vector<vec3>& vertices, vector<unsigned int>& indices){
+	if (cap == CAP_ROUND){
+		double a = atan2(-dx, dy); // left normal
+		addFan(p, hw, a, a + pi, tol, vertices, indices);
+	}
+	else if (cap == CAP_SQUARE){
+		double nx = -dy * hw, ny = dx * hw, bx = -dx * hw, by = -dy * hw;
+		vec3 l((float)(p.x + nx), (float)(p.y + ny), p.z), r((float)(p.x - nx), (float)(p.y - ny), p.z);
+		vec3 lb((float)(l.x + bx), (float)(l.y + by), p.z), rb((float)(r.x + bx), (float)(r.y + by), p.z);
+		addTriangle(l, lb, rb, vertices, indices);
+		addTriangle(l, rb, r, vertices, indices);
+	}
+}
+
+void strokePolyline(const vec3* v, int n, bool closed, float halfWidth, LineJoin join, LineCap cap,
+	float miterLimit, float tolerance, vector<vec3>& vertices, vector<unsigned int>& indices){
+	// drop repeated points, they have no direction
+	vector<vec3> pts;
+	pts.reserve(n);
+	for (int i = 0; i < n; i++)
+		if (pts.empty() || v[i].x != pts.back().x || v[i].y != pts.back().y)
+			pts.push_back(v[i]);
+	if (closed && pts.size() > 1 && pts.front().x == pts.back().x && pts.front().y == pts.back().y)
+		pts.pop_back();
+	int m = (int)pts.size();
+	double hw = halfWidth;
+	if (m == 0)
+		return;
+	if (m == 1){
+		if (cap == CAP_ROUND)
+			addFan(pts[0], hw, 0, 2 * pi, tolerance, vertices, indices);
+		return;
+	}
+	int nSegments = closed && m > 2 ? m : m - 1;
+	vector<double> dx(nSegments), dy(nSegments);
+	for (int s = 0; s < nSegments; s++){
+		const vec3& a = pts[s];
+		const vec3& b = pts[(s + 1) % m];
+		double ex = (double)b.x - a.x, ey = (double)b.y - a.y, len = sqrt(ex * ex + ey * ey);
+		dx[s] = ex / len;
+		dy[s] = ey / len;
+		double nx = -dy[s] * hw, ny = dx[s] * hw;
+		unsigned int first = (unsigned int)vertices.size();
+		vertices.push_back(vec3((float)(a.x + nx), (float)(a.y + ny), a.z));
+		vertices.push_back(vec3((float)(a.x - nx), (float)(a.y - ny), a.z));
+		vertices.push_back(vec3((float)(b.x - nx), (float)(b.y - ny), b.z));
+		vertices.push_back(vec3((float)(b.x + nx), (float)(b.y + ny), b.z));
+		unsigned int quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+	for (int s = 1; s < nSegments; s++)
+		addJoin(pts[s], dx[s - 1], dy[s - 1], dx[s], dy[s], hw, join, miterLimit, tolerance, vertices, indices);
+	if (nSegments == m) // closed
+		addJoin(pts[0], dx[m - 1], dy[m - 1], dx[0], dy[0], hw, join, miterLimit, tolerance, vertices, indices);
+	else {
+		addCap(pts[0], dx[0], dy[0], hw, cap, tolerance, vertices, indices);
+		addCap(pts[m - 1], -dx[m - 2], -dy[m - 2], hw, cap, tolerance, vertices, indices);
+	}
+}
+
+int StrokeCache::bucketOf(float worldPerPixel){
+	return (int)floor(log2((double)worldPerPixel) * 4 + 0.5);
+}
+
+const StrokeMesh& StrokeCache::get(const LayerGeometry& geom, const LayerStyle& style, unsigned int styleRevision, float worldPerPixel){
+	int bucket = bucketOf(worldPerPixel);
+	for (size_t i = 0; i < entries.size(); i++){
+		if (entries[i].bucket == bucket && entries[i].geometry == &geom && entries[i].styleRevision == styleRevision){
+			rotate(entries.begin(), entries.begin() + i, entries.begin() + i + 1);
+			return *entries[0].mesh;
+		}
+	}
+	TraceScope trace("stroke", "render");
+	shared_ptr<StrokeMesh> mesh(new StrokeMesh());
+	mesh->worldPerPixel = (float)pow(2.0, bucket / 4.0);
+	float hw = style.strokeWidth * 0.5f * mesh->worldPerPixel;
+	float tol = 0.25f * mesh->worldPerPixel;
+	bool closed = geom.shpType == SHPT_POLYGON || geom.shpType == SHPT_POLYGONZ;
+
+	// contiguous runs of parts, one per thread, joined in part order afterwards
+	int nParts = geom.getPartCount();
+	int nChunks = max(1, min((int)thread::hardware_concurrency(), nParts / 256));
+	vector<StrokeMesh> chunks(nChunks);
+	parallelFor(nChunks, 1, [&](int begin, int end){
+		for (int c = begin; c < end; c++){
+			StrokeMesh& out = chunks[c];
+			int p0 = (int)((long long)nParts * c / nChunks), p1 = (int)((long long)nParts * (c + 1) / nChunks);
+			for (int p = p0; p < p1; p++){
+				out.partIndices.push_back((unsigned int)out.indices.size());
+				strokePolyline(geom.getPart(p), geom.getPartSize(p), closed, hw, style.join, style.cap,
+					style.miterLimit, tol, out.vertices, out.indices);
+			}
+		}
+	});
+	size_t nVertices = 0, nIndices = 0;
+	for (int c = 0; c < nChunks; c++){
+		nVertices += chunks[c].vertices.size();
+		nIndices += chunks[c].indices.size();
+	}
+	mesh->vertices.reserve(nVertices);
+	mesh->indices.reserve(nIndices);
+	mesh->partIndices.reserve(nParts + 1);
+	for (int c = 0; c < nChunks; c++){
+		unsigned int vertexBase = (unsigned int)mesh->vertices.size(), indexBase = (unsigned int)mesh->indices.size();
+		mesh->vertices.insert(mesh->vertices.end(), chunks[c].vertices.begin(), chunks[c].vertices.end());
+		for (size_t i = 0; i < chunks[c].indices.size(); i++)
+			mesh->indices.push_back(chunks[c].indices[i] + vertexBase);
+		for (size_t i = 0; i < chunks[c].partIndices.size(); i++)
+			mesh->partIndices.push_back(chunks[c].partIndices[i] + indexBase);
+		vector<vec3>().swap(chunks[c].vertices);
+	}
+	mesh->partIndices.push_back((unsigned int)mesh->indices.size());
+
+	Entry e = { &geom, styleRevision, bucket, mesh };
+	entries.insert(entries.begin(), e);
+	if (entries.size() > maxEntries)
+		entries.pop_back();
+	return *mesh;
+}
+
+size_t StrokeCache::getMemoryBytes() const{
+	size_t n = 0;
+	for (size_t i = 0; i < entries.size(); i++){
+		const StrokeMesh& m = *entries[i].mesh;
+		n += m.vertices.capacity() * sizeof(vec3) + (m.indices.capacity() + m.partIndices.capacity()) * sizeof(unsigned int);
+	}
+	return n;
+}
@@ -0,0 +1,72 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef STROKER_H_DEF
+#define STROKER_H_DEF
+
+#include "LayerGeometry.h"
+#include "LayerStyle.h"
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+/*
+	Triangles covering a polyline stroked halfWidth to each side: a quad
+	per segment, the outer side of every bend filled by the join, and the
+	ends by the cap (closed lines get a join there instead). Round joins
+	and caps are fans whose chords stay within tolerance of the arc.
+	Appends to vertices and indices; the triangles may overlap.
+*/
+void strokePolyline(const vec3* v, int n, bool closed, float halfWidth, LineJoin join, LineCap cap,
+	float miterLimit, float tolerance, vector<vec3>& vertices, vector<unsigned int>& indices);
+
+// Every part of a layer stroked; part p is indices [partIndices[p], partIndices[p + 1]).
+struct StrokeMesh {
+	vector<vec3> vertices;
+	vector<unsigned int> indices;
+	vector<unsigned int> partIndices;
+	float worldPerPixel;     // the scale the widths were made for
+};
+
+/*
+	Stroke meshes of one layer by zoom bucket. Widths are pixels, so a
+	mesh only fits one scale; it is made for the nearest quarter octave
+	(widths are then off by 9% at most) and used for every scale in that
+	bucket, pans included. The two most recent buckets are kept. Meshes
+	are built in parallel over the parts.
+
+	One drawing thread at a time.
+*/
+class StrokeCache {
+public:
+	StrokeCache() {}
+
+	const StrokeMesh& get(const LayerGeometry& geom, const LayerStyle& style, unsigned int styleRevision, float worldPerPixel);
+	void clear() { entries.clear(); }
+	size_t getMemoryBytes() const;
+
+	static int bucketOf(float worldPerPixel);
+
+private:
+	struct Entry {
+		const LayerGeometry* geometry;
+		unsigned int styleRevision;
+		int bucket;
+		shared_ptr<StrokeMesh> mesh;
+	};
+	vector<Entry> entries; // most recent first
+
+	StrokeCache(const StrokeCache&);
+	StrokeCache& operator=(const StrokeCache&);
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "Trace.h"
+#include "Metrics.h"
+#include <vector>
+#include <set>
+#include <mutex>
+#include <memory>
+#include <fstream>
+
+using namespace std;
+
+struct TraceEvent {
+	const char* name;
+	const char* category;
+	long long ts; // ns
+	char phase;   // 'B' or 'E'
+};
+
+/*
+	Single producer ring: only the owning thread writes events and head;
+	write() reads them with an acquire load of head.
+*/
+struct TraceThreadBuffer {
+	int tid;
+	const char* threadName;
+	vector<TraceEvent> events;
+	atomic<size_t> head; // total events ever recorded
+
+	TraceThreadBuffer(int tid, size_t capacity) : tid(tid), threadName(NULL), events(capacity), head(0) {}
+};
+
+atomic<bool> Trace::enabled(false);
+
+static mutex sTraceLock; // guards the lists below, never taken while recording
+static vector<unique_ptr<TraceThreadBuffer> > sBuffers;
+static set<string> sInterned;
+static string sTracePath;
+static size_t sEventsPerThread = 1 << 16;
+static long long sStartNs = 0;
+
+static thread_local TraceThreadBuffer* tBuffer = NULL;
+
+static TraceThreadBuffer* threadBuffer(){
+	if (tBuffer == NULL){
+		lock_guard<mutex> guard(sTraceLock);
+		sBuffers.push_back(unique_ptr<TraceThreadBuffer>(new TraceThreadBuffer((int)sBuffers.size() + 1, sEventsPerThread)));
+		tBuffer = sBuffers.back().get();
+	}
+	return tBuffer;
+}
+
+static void record(const char* name, const char* category, char phase){
+	TraceThreadBuffer* b = threadBuffer();
+	size_t h = b->head.load(memory_order_relaxed);
+	TraceEvent& e = b->events[h % b->events.size()];
+	e.name = name;
+	e.category = category;
+	e.ts = Metrics::nowNs();
+	e.phase = phase;
+	b->head.store(h + 1, memory_order_release);
+}
+
+void Trace::start(const char* path, size_t eventsPerThread){
+	lock_guard<mutex> guard(sTraceLock);
+	sTracePath = path;
+	sEventsPerThread = eventsPerThread > 0 ? eventsPerThread : 1;
+	sStartNs = Metrics::nowNs();
+	enabled.store(true);
+}
+
+void Trace::begin(const char* name, const char* category){
+	record(name, category, 'B');
+}
+
+void Trace::end(const char* name, const char* category){
+	record(name, category, 'E');
+}
+
+void Trace::setThreadName(const char* name){
+	if (isEnabled())
+		threadBuffer()->threadName = name;
+}
+
+const char* Trace::intern(const string& s){
+	lock_guard<mutex> guard(sTraceLock);
+	return sInterned.insert(s).first->c_str();
+}
+
+static void writeJSONString(ostream& os, const char* s){
+	os << '"';
+	for (; s && *s; s++){
+		unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\')
+			os << '\\' << (char)c;
+		else if (c < 0x20)
+			os << ' ';
+		else
+			os << (char)c;
+	}
+	os << '"';
+}
+
+bool Trace::write(){
+	lock_guard<mutex> guard(sTraceLock);
+	if (sTracePath.empty())
+		return false;
+	ofstream out(sTracePath.c_str());
+	if (!out)
+		return false;
+
+	out << fixed;
+	out.precision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (size_t t = 0; t < sBuffers.size(); t++){
+		TraceThreadBuffer& b = *sBuffers[t];
+		if (b.threadName){
+			out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << b.tid
+				<< ",\"name\":\"thread_name\",\"args\":{\"name\":";
+			writeJSONString(out, b.threadName);
+			out << "}}";
+			first = false;
+		}
+
+		size_t head = b.head.load(memory_order_acquire);
+		size_t n = head < b.events.size() ? head : b.events.size();
+		int depth = 0;
+		for (size_t i = head - n; i < head; i++){
+			const TraceEvent& e = b.events[i % b.events.size()];
+			// the ring may have dropped the begin of the oldest scopes
+			if (e.phase == 'E' && depth == 0)
+				continue;
+			depth += (e.phase == 'B') ? 1 : -1;
+			out << (first ? "" : ",\n") << "{\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":" << b.tid
+				<< ",\"ts\":" << (e.ts - sStartNs) / 1000.0 << ",\"cat\":";
+			writeJSONString(out, e.category);
+			out << ",\"name\":";
+			writeJSONString(out, e.name);
+			out << "}";
+			first = false;
+		}
+	}
+	out << "\n]}\n";
+	return true;
+}
@@ -0,0 +1,67 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef TRACE_H_DEF
+#define TRACE_H_DEF
+
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+/*
+	Timeline of begin/end events written as Chrome trace-event JSON
+	(open in chrome://tracing or ui.perfetto.dev).
+
+	Every thread records into its own ring buffer, so recording takes no lock;
+	when a ring is full the oldest events of that thread are overwritten.
+	Event names are not copied: pass string literals or Trace::intern() results.
+*/
+class Trace {
+public:
+	static void start(const char* path, size_t eventsPerThread = 1 << 16);
+	static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+
+	static void begin(const char* name, const char* category);
+	static void end(const char* name, const char* category);
+	static void setThreadName(const char* name);
+
+	// Stable copy of a runtime string (e.g. a layer name) for use as an event name.
+	static const char* intern(const string& s);
+
+	// Writes every thread's events to the file given to start().
+	static bool write();
+
+private:
+	static atomic<bool> enabled;
+};
+
+class TraceScope {
+public:
+	TraceScope(const char* name, const char* category)
+		: name(name), category(category), active(Trace::isEnabled()){
+		if (active)
+			Trace::begin(name, category);
+	}
+	~TraceScope(){
+		if (active)
+			Trace::end(name, category);
+	}
+private:
+	const char* name;
+	const char* category;
+	bool active;
+
+	TraceScope(const TraceScope&);
+	TraceScope& operator=(const TraceScope&);
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#include "ViewCulling.h"
+#include <algorithm>
+
+using namespace std;
+
+void selectVisibleParts(const LayerGeometry& geom, const vec4& view, float minExtent, VisibleParts& out){
+	int nParts = geom.getPartCount();
+	if ((int)geom.partBounds.size() != nParts){
+		for (int p = 0; p < nParts; p++)
+			out.detailed.push_back(p);
+		return;
+	}
+	const vec4* bounds = geom.partBounds.data();
+	const int blockSize = LayerGeometry::partBlockSize;
+	bool blocks = (int)geom.blockBounds.size() == (nParts + blockSize - 1) / blockSize;
+	for (int first = 0; first < nParts; first += blockSize){
+		int end = min(nParts, first + blockSize);
+		// a block off the view is skipped whole; in spatial order most of them are
+		if (blocks && !boundsOverlap(geom.blockBounds[first / blockSize], view)){
+			out.culled += end - first;
+			continue;
+		}
+		for (int p = first; p < end; p++){
+			const vec4& b = bounds[p];
+			if (!boundsOverlap(b, view))
+				out.culled++;
+			else if (b.z - b.x < minExtent && b.w - b.y < minExtent)
+				out.dots.push_back(p);
+			else
+				out.detailed.push_back(p);
+		}
+	}
+}
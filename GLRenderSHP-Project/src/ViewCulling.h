@@ -0,0 +1,38 @@
+/*
+Simple ShapeFile OpenGL renderer.
+Adapted from http://www.codeproject.com/Articles/32035/Rendering-Shapefile-in-OpenGL
+
+Authors
+-Tiago Augusto Engel (tengel@inf.ufsm.br)
+-Cesar Pozzer		 (pozzer@inf.ufsm.br)
+
+Using ShapeLib version 1.3
+*/
+
+#ifndef VIEWCULLING_H_DEF
+#define VIEWCULLING_H_DEF
+
+#include "LayerGeometry.h"
+
+/*
+	The parts of a layer worth submitting for one view: those whose bounds
+	meet the view rectangle, split by size. A part smaller than minExtent
+	(about a pixel) in both directions looks the same as a single vertex.
+*/
+struct VisibleParts {
+	vector<int> detailed;  // draw every vertex
+	vector<int> dots;      // draw the first vertex only
+	int culled;
+
+	VisibleParts() : culled(0) {}
+	void clear() { detailed.clear(); dots.clear(); culled = 0; }
+};
+
+// Appends to out; parts without bounds count as visible.
+void selectVisibleParts(const LayerGeometry& geom, const vec4& view, float minExtent, VisibleParts& out);
+
+inline bool boundsOverlap(const vec4& a, const vec4& b){
+	return a.x <= b.z && b.x <= a.z && a.y <= b.w && b.y <= a.w;
+}
+
+#endif